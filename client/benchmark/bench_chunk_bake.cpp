@@ -0,0 +1,76 @@
+// Compares generating DefaultTerrain chunks against loading their baked records from a WorldDatabase: chunks per
+// second, bytes per baked chunk, and whether the loaded records decode. Decoded chunks are compared against the encoded
+// ones in test_baked_chunk.cpp.
+
+#include <client/BakedChunk.hpp>
+#include <client/Chunk.hpp>
+#include <client/DefaultTerrain.hpp>
+#include <common/WorldDatabase.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr int32_t kRadiusXZ = 6, kMinY = -2, kMaxY = 4;
+constexpr std::size_t kReadBatch = 32;
+
+int main() {
+	auto terrain = DefaultTerrain::Create(12314524);
+	uint32_t version = terrain->GetBakedVersion();
+
+	std::vector<ChunkPos3> positions;
+	for (int32_t y = kMinY; y <= kMaxY; ++y)
+		for (int32_t z = -kRadiusXZ; z <= kRadiusXZ; ++z)
+			for (int32_t x = -kRadiusXZ; x <= kRadiusXZ; ++x)
+				positions.push_back({x, y, z});
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::shared_ptr<Chunk>> generated;
+	for (const auto &pos : positions) {
+		auto chunk = Chunk::Create(pos);
+		terrain->Generate(chunk);
+		generated.push_back(std::move(chunk));
+	}
+	double generate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	auto db_path = std::filesystem::temp_directory_path() / "hypercraft_bench_chunk_bake";
+	std::filesystem::remove_all(db_path);
+	std::filesystem::create_directories(db_path);
+	auto database = WorldDatabase::Create((db_path / "world").string().c_str());
+
+	std::size_t baked_bytes = 0;
+	std::vector<ChunkWriteRequests> requests;
+	for (const auto &chunk : generated) {
+		ChunkWriteRequests &request = requests.emplace_back(ChunkWriteRequests{chunk->GetPosition()});
+		request.baked_version = version;
+		request.baked = EncodeBakedChunk(*chunk);
+		baked_bytes += request.baked.size();
+	}
+	database->Write(requests);
+
+	begin = std::chrono::steady_clock::now();
+	std::vector<std::shared_ptr<Chunk>> loaded;
+	bool valid = true;
+	for (std::size_t i = 0; i < positions.size(); i += kReadBatch) {
+		auto entries =
+		    database->GetChunks(std::span{positions}.subspan(i, std::min(kReadBatch, positions.size() - i)), version);
+		for (std::size_t j = 0; j < entries.size(); ++j) {
+			auto chunk = Chunk::Create(positions[i + j]);
+			valid &= DecodeBakedChunk(entries[j].baked, chunk.get());
+			loaded.push_back(std::move(chunk));
+		}
+	}
+	double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	printf("generate: %.0f chunks/s\n", double(positions.size()) / generate_seconds);
+	printf("baked: %.0f chunks/s, %.0f bytes per chunk, %.2f MiB used\n", double(positions.size()) / load_seconds,
+	       double(baked_bytes) / double(positions.size()), double(database->GetUsedSize()) / (1024.0 * 1024.0));
+	printf("%s\n", valid ? "baked chunks decoded" : "BAKED CHUNKS MALFORMED");
+
+	database.reset();
+	std::filesystem::remove_all(db_path);
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Compares restoring DefaultTerrain chunks from their hibernated records against generating them again: time per
+// chunk to encode on unload, to restore and to generate, and bytes per record. Then walks a World back and forth to
+// show the share of the loaded chunks restored from the ChunkHibernationCache and the time per step spent by
+// ChunkPool::Update(), the unloaded chunks being encoded afterwards as the WorldWorker threads would. Restoring is also
+// timed with the palette layouts of a ChunkSlabPool recycled from the chunks unloaded before.
+
+#include <client/BakedChunk.hpp>
+#include <client/Chunk.hpp>
+#include <client/ChunkSlabPool.hpp>
+#include <client/DefaultTerrain.hpp>
+#include <client/World.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr int32_t kRadiusXZ = 5, kMinY = -2, kMaxY = 4;
+constexpr ChunkLoadShape kLoadShape{.radius = 16, .height = 8};
+constexpr ChunkPos1 kUnloadRadius = 18, kWalkLength = 24;
+constexpr uint32_t kWalkLaps = 3;
+
+template <typename Func> static double measure_us(std::size_t count, Func &&func) {
+	auto begin = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		func(i);
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / double(count);
+}
+
+// Stands in for the client: the chunks loaded are filled with stone below y = 0, as if generated
+static void generate_loaded_chunks(const World &world) {
+	ChunkPos3 center = world.GetCenterChunkPos();
+	ChunkLoadShape bound = kLoadShape.Grow(1);
+	for (int32_t y = -bound.height; y <= bound.height; ++y)
+		for (int32_t z = -bound.radius; z <= bound.radius; ++z)
+			for (int32_t x = -bound.radius; x <= bound.radius; ++x) {
+				auto chunk = world.GetChunkPool().FindRawChunk(center + ChunkPos3(x, y, z));
+				if (!chunk || chunk->IsGenerated())
+					continue;
+				chunk->FillBlocks(chunk->GetPosition().y < 0 ? block::Blocks::kStone : block::Blocks::kAir);
+				chunk->CompactBlocks();
+				chunk->SetGeneratedFlag();
+			}
+}
+
+static void run_walk(const char *name, std::size_t capacity) {
+	auto world = World::Create(kLoadShape, kUnloadRadius, ChunkPoolStorage::kRingMap);
+	world->SetChunkHibernationCapacity(capacity);
+	world->Start();
+	generate_loaded_chunks(*world);
+
+	double update_ms = 0.0;
+	std::size_t steps = 0;
+	for (uint32_t lap = 0; lap < kWalkLaps; ++lap)
+		for (int32_t i = 1; i <= 2 * kWalkLength; ++i, ++steps) {
+			auto begin = std::chrono::steady_clock::now();
+			world->SetCenterChunkPos({ChunkPos1(i <= kWalkLength ? i : 2 * kWalkLength - i), 0, 0});
+			update_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			world->EncodeHibernatingChunks(SIZE_MAX);
+			generate_loaded_chunks(*world);
+		}
+
+	auto stats = world->GetChunkHibernationStats();
+	std::size_t loads = stats.hits + stats.misses;
+	printf("walk, %s: %zu of %zu loads restored (%.1f%%), %zu chunks kept in %.2f MiB, %.2f ms per step\n", name,
+	       stats.hits, loads, loads ? 100.0 * double(stats.hits) / double(loads) : 0.0, stats.chunks,
+	       double(stats.bytes) / (1024.0 * 1024.0), update_ms / double(steps));
+}
+
+int main() {
+	auto terrain = DefaultTerrain::Create(12314524);
+	std::vector<ChunkPos3> positions;
+	for (int32_t y = kMinY; y <= kMaxY; ++y)
+		for (int32_t z = -kRadiusXZ; z <= kRadiusXZ; ++z)
+			for (int32_t x = -kRadiusXZ; x <= kRadiusXZ; ++x)
+				positions.push_back({x, y, z});
+
+	// Twice, so that the second pass has warm terrain caches like the chunks unloaded after a short while
+	std::vector<std::shared_ptr<Chunk>> generated(positions.size());
+	double generate_us = 0.0;
+	for (uint32_t pass = 0; pass < 2; ++pass)
+		generate_us = measure_us(positions.size(), [&](std::size_t i) {
+			generated[i] = Chunk::Create(positions[i]);
+			terrain->Generate(generated[i]);
+			generated[i]->CompactBlocks();
+		});
+
+	std::vector<std::vector<uint8_t>> records(positions.size());
+	double encode_us =
+	    measure_us(positions.size(), [&](std::size_t i) { records[i] = EncodeBakedChunk(*generated[i]); });
+	std::size_t record_bytes = 0;
+	for (const auto &record : records)
+		record_bytes += record.size();
+
+	// Decoded chunks are compared in test_baked_chunk.cpp
+	std::vector<std::shared_ptr<Chunk>> restored(positions.size());
+	bool valid = true;
+	double restore_us = measure_us(positions.size(), [&](std::size_t i) {
+		restored[i] = Chunk::Create(positions[i]);
+		valid &= DecodeBakedChunk(records[i], restored[i].get());
+		restored[i]->CompactBlocks();
+	});
+
+	printf("%zu chunks: generate %.1f us, encode %.1f us, restore %.1f us (%.1fx faster), %.0f bytes per record\n",
+	       positions.size(), generate_us, encode_us, restore_us, generate_us / restore_us,
+	       double(record_bytes) / double(positions.size()));
+	printf("restored chunks %s\n", valid ? "decoded" : "MALFORMED");
+
+	// Unloads and restores the chunks again, so that the palette layouts of the chunks of a slab pool are recycled
+	const auto measure_reload_us = [&](auto &&create_chunk) {
+		double reload_us = 0.0;
+		for (uint32_t pass = 0; pass < 2; ++pass)
+			reload_us = measure_us(positions.size(), [&](std::size_t i) {
+				restored[i] = nullptr;
+				restored[i] = create_chunk(positions[i]);
+				DecodeBakedChunk(records[i], restored[i].get());
+				restored[i]->CompactBlocks();
+			});
+		return reload_us;
+	};
+	double heap_reload_us = measure_reload_us([](const ChunkPos3 &position) { return Chunk::Create(position); });
+	auto slab_pool = ChunkSlabPool::Create(kChunkSlabPoolCapacity, kChunkPaletteBufferCapacity);
+	double pool_reload_us =
+	    measure_reload_us([&](const ChunkPos3 &position) { return slab_pool->AllocateChunk(position); });
+	auto palette_buffer_stats = slab_pool->GetStats().palette_buffers;
+	printf("reload: %.1f us from the heap, %.1f us from a slab pool (%zu of %zu palette buffers recycled)\n",
+	       heap_reload_us, pool_reload_us, palette_buffer_stats.hits,
+	       palette_buffer_stats.hits + palette_buffer_stats.misses);
+
+	run_walk("no hibernation", 0);
+	run_walk("hibernation", kChunkHibernationCapacity);
+	return valid ? 0 : 1;
+}
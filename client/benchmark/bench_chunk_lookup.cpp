@@ -0,0 +1,70 @@
+// Compares the chunk lookup throughput of the ChunkPool storages under concurrent workers, each looking up random
+// chunks around the center with their 26 neighbours like the chunk task runners do, while the center stays still and
+// while it walks back and forth.
+
+#include <client/World.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr ChunkPos1 kLoadRadius = 11, kUnloadRadius = 13, kLookupRadius = 9;
+constexpr uint32_t kLookupsPerThread = 1 << 20;
+constexpr std::size_t kThreadCounts[] = {1, 2, 4, 8};
+
+static void run(const char *name, ChunkPoolStorage storage, std::size_t thread_count, bool walk) {
+	auto world = World::Create(kLoadRadius, kUnloadRadius, storage);
+	world->Start();
+
+	std::atomic_bool walking{walk};
+	std::thread walker;
+	if (walk)
+		walker = std::thread([&world, &walking] {
+			for (uint32_t i = 0; walking.load(std::memory_order_relaxed); ++i)
+				world->SetCenterChunkPos({ChunkPos1(i % 8 < 4 ? i % 4 : 4 - i % 4), 0, 0});
+			world->SetCenterChunkPos({0, 0, 0});
+		});
+
+	std::atomic_size_t found_count{0};
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < thread_count; ++t)
+		threads.emplace_back([&world, &found_count, t] {
+			std::mt19937 rng{uint32_t(t)};
+			std::uniform_int_distribution<int32_t> dist{-kLookupRadius, kLookupRadius};
+			std::size_t found = 0;
+			for (uint32_t i = 0; i < kLookupsPerThread; i += 27) {
+				ChunkPos3 center{dist(rng), dist(rng), dist(rng)};
+				for (uint32_t n = 0; n < 27; ++n) {
+					ChunkPos3 nei_pos;
+					Chunk::NeighbourIndex2CmpXYZ(n, glm::value_ptr(nei_pos));
+					found += bool(world->GetChunkPool().FindRawChunk(center + nei_pos));
+				}
+			}
+			found_count.fetch_add(found);
+		});
+	for (auto &thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	walking.store(false, std::memory_order_relaxed);
+	if (walker.joinable())
+		walker.join();
+
+	std::size_t lookup_count = thread_count * (kLookupsPerThread / 27 * 27);
+	printf("%s, %zu threads%s: %.1f M lookups/s, %.1f%% found\n", name, thread_count, walk ? ", walking" : "",
+	       double(lookup_count) / seconds / 1e6, 100.0 * double(found_count.load()) / double(lookup_count));
+}
+
+int main() {
+	for (bool walk : {false, true})
+		for (std::size_t thread_count : kThreadCounts) {
+			run("hash map", ChunkPoolStorage::kHashMap, thread_count, walk);
+			run("ring map", ChunkPoolStorage::kRingMap, thread_count, walk);
+		}
+	return 0;
+}
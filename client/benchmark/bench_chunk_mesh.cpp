@@ -0,0 +1,113 @@
+// Compares the scalar and bitmask regular meshing backends of BlockMeshAlgo over lit DefaultTerrain chunks: quads per
+// second, output size, and whether both produce the same vertex and index streams.
+
+#include <client/BlockMeshAlgo.hpp>
+#include <client/ChunkTaskPool.hpp>
+#include <client/DefaultTerrain.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+using namespace hc;
+using namespace hc::client;
+
+template <BlockMeshBackend Backend>
+using MeshAlgo = BlockMeshAlgo<
+    BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{0, 0, 0, kChunkSize, kChunkSize, kChunkSize},
+                    kBlockAlgoSwizzleYZX>,
+    Backend>;
+
+constexpr int32_t kRadiusXZ = 3, kMinY = -2, kMaxY = 4;
+constexpr uint32_t kMeshRounds = 3;
+
+struct MeshStats {
+	std::size_t quads{}, bytes{};
+};
+
+static bool same_meshes(const std::vector<BlockMesh> &l, const std::vector<BlockMesh> &r) {
+	if (l.size() != r.size())
+		return false;
+	for (std::size_t i = 0; i < l.size(); ++i) {
+		if (l[i].transparent != r[i].transparent || l[i].vertices.size() != r[i].vertices.size() ||
+		    l[i].indices != r[i].indices)
+			return false;
+		if (std::memcmp(l[i].vertices.data(), r[i].vertices.data(), l[i].vertices.size() * sizeof(BlockVertex)))
+			return false;
+	}
+	return true;
+}
+
+int main() {
+	auto terrain = DefaultTerrain::Create(12314524);
+
+	std::unordered_map<ChunkPos3, std::shared_ptr<Chunk>> chunks;
+	for (int32_t y = kMinY - 2; y <= kMaxY + 2; ++y)
+		for (int32_t z = -kRadiusXZ - 2; z <= kRadiusXZ + 2; ++z)
+			for (int32_t x = -kRadiusXZ - 2; x <= kRadiusXZ + 2; ++x) {
+				ChunkPos3 pos{x, y, z};
+				auto chunk = Chunk::Create(pos);
+				terrain->Generate(chunk);
+				chunk->CompactBlocks();
+				chunks[pos] = std::move(chunk);
+			}
+	const auto get_neighbours = [&](const ChunkPos3 &pos) {
+		std::array<std::shared_ptr<Chunk>, 27> neighbours;
+		for (uint32_t i = 0; i < 27; ++i) {
+			ChunkPos3 nei_pos;
+			Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+			neighbours[i] = chunks.at(pos + nei_pos);
+		}
+		return neighbours;
+	};
+
+	// Initial lights as the kLight task computes them (its runner does not touch the task pool)
+	ChunkTaskRunner<ChunkTaskType::kLight> light_runner;
+	for (const auto &it : chunks) {
+		const auto &pos = it.first;
+		if (std::abs(pos.x) <= kRadiusXZ + 1 && std::abs(pos.z) <= kRadiusXZ + 1 && kMinY - 1 <= pos.y &&
+		    pos.y <= kMaxY + 1)
+			light_runner.Run(nullptr, ChunkTaskRunnerData<ChunkTaskType::kLight>{get_neighbours(pos)});
+	}
+
+	std::vector<std::unique_ptr<ChunkNeighbourhood<kChunkMeshReach>>> neighbourhoods;
+	for (int32_t y = kMinY; y <= kMaxY; ++y)
+		for (int32_t z = -kRadiusXZ; z <= kRadiusXZ; ++z)
+			for (int32_t x = -kRadiusXZ; x <= kRadiusXZ; ++x) {
+				auto neighbours = get_neighbours({x, y, z});
+				auto &neighbourhood = neighbourhoods.emplace_back(new ChunkNeighbourhood<kChunkMeshReach>{});
+				neighbourhood->GatherBlocks(neighbours);
+				neighbourhood->GatherLights(neighbours);
+			}
+
+	const auto mesh = [](auto &&algo, const ChunkNeighbourhood<kChunkMeshReach> &neighbourhood) {
+		return algo.Generate([&](auto x, auto y, auto z) { return neighbourhood.GetBlock(x, y, z); },
+		                     [&](auto x, auto y, auto z) { return neighbourhood.GetLight(x, y, z); });
+	};
+
+	const auto bench = [&]<BlockMeshBackend Backend>(const char *name) {
+		MeshStats stats;
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t r = 0; r < kMeshRounds; ++r)
+			for (const auto &neighbourhood : neighbourhoods)
+				for (const auto &m : mesh(MeshAlgo<Backend>{}, *neighbourhood)) {
+					stats.quads += m.vertices.size() / 4;
+					stats.bytes += m.vertices.size() * sizeof(BlockVertex) + m.indices.size() * sizeof(uint16_t);
+				}
+		double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		spdlog::info("{}: {:.0f} quads/s, {:.1f} chunks/s, {} quads, {:.1f} KiB per round", name,
+		             double(stats.quads) / sec, double(neighbourhoods.size() * kMeshRounds) / sec,
+		             stats.quads / kMeshRounds, double(stats.bytes) / double(kMeshRounds) / 1024.0);
+		return sec;
+	};
+	double scalar_sec = bench.operator()<BlockMeshBackend::kScalar>("scalar");
+	double bitmask_sec = bench.operator()<BlockMeshBackend::kBitmask>("bitmask");
+	spdlog::info("bitmask speedup: {:.2f}x", scalar_sec / bitmask_sec);
+
+	std::size_t mismatches = 0;
+	for (const auto &neighbourhood : neighbourhoods)
+		mismatches += !same_meshes(mesh(MeshAlgo<BlockMeshBackend::kScalar>{}, *neighbourhood),
+		                           mesh(MeshAlgo<BlockMeshBackend::kBitmask>{}, *neighbourhood));
+	spdlog::info("{} of {} chunks differ between backends", mismatches, neighbourhoods.size());
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Walks the center chunk through a world and compares the incremental ChunkPool::Update() against rescanning the whole
+// chunk table and load list on each center change: time per chunk boundary crossing, and whether both keep the same
+// chunks. Teleports are checked but not timed. Then compares the chunks held by ellipsoid and cylinder load shapes of
+// larger radii, with and without cutting the shapes above the terrain.
+
+#include <client/DefaultTerrain.hpp>
+#include <client/World.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr uint32_t kSteps = 256, kCheckInterval = 16;
+
+// The previous ChunkPool::Update()
+class RescanChunkPool {
+private:
+	libcuckoo::cuckoohash_map<ChunkPos3, std::shared_ptr<Chunk>> m_chunks;
+	std::shared_ptr<ChunkSlabPool> m_slab_pool{
+	    ChunkSlabPool::Create(kChunkSlabPoolCapacity, kChunkPaletteBufferCapacity)};
+	std::vector<ChunkPos3> m_load_list;
+	ChunkPos1 m_unload_radius;
+
+public:
+	inline RescanChunkPool(ChunkPos1 load_radius, ChunkPos1 unload_radius) : m_unload_radius{unload_radius} {
+		// Balls of the load radius grown by a chunk
+		std::unordered_set<ChunkPos3> load_set;
+		for (ChunkPos1 y = -load_radius; y <= load_radius; ++y)
+			for (ChunkPos1 z = -load_radius; z <= load_radius; ++z)
+				for (ChunkPos1 x = -load_radius; x <= load_radius; ++x) {
+					if (ChunkPosLength2(ChunkPos3{x, y, z}) > uint32_t(load_radius * load_radius))
+						continue;
+					for (uint32_t i = 0; i < 27; ++i)
+						load_set.insert(ChunkPos3(x + ChunkPos1(i % 3) - 1, y + ChunkPos1(i / 3 % 3) - 1,
+						                          z + ChunkPos1(i / 9) - 1));
+				}
+		m_load_list = {load_set.begin(), load_set.end()};
+	}
+	inline void Update(const ChunkPos3 &center) {
+		auto locked_chunks = m_chunks.lock_table();
+		for (auto it = locked_chunks.begin(); it != locked_chunks.end();) {
+			if (ChunkPosDistance2(center, it->first) > uint32_t(m_unload_radius * m_unload_radius))
+				it = locked_chunks.erase(it);
+			else
+				++it;
+		}
+		for (const auto &offset : m_load_list)
+			if (locked_chunks.find(center + offset) == locked_chunks.end())
+				locked_chunks.insert(center + offset, m_slab_pool->AllocateChunk(center + offset));
+	}
+	inline bool Contains(const ChunkPos3 &pos) const { return m_chunks.contains(pos); }
+};
+
+static void run(ChunkPos1 load_radius, ChunkPos1 unload_radius) {
+	std::mt19937 rng{2333};
+	std::vector<ChunkPos3> centers{{0, 0, 0}};
+	std::vector<bool> teleports{true};
+	for (uint32_t i = 1; i < kSteps; ++i) {
+		ChunkPos3 center = centers.back();
+		// Mostly walk to a neighbour, sometimes teleport
+		bool teleport = rng() % 32 == 0;
+		if (teleport)
+			center += ChunkPos3(rng() % 64, rng() % 8, rng() % 64) - ChunkPos3(32, 4, 32);
+		else
+			center[rng() % 3] += rng() % 2 ? 1 : -1;
+		centers.push_back(center);
+		teleports.push_back(teleport);
+	}
+
+	auto world = World::Create(load_radius, unload_radius);
+	RescanChunkPool rescan_pool{load_radius, unload_radius};
+	double incremental_seconds = 0.0, rescan_seconds = 0.0;
+	uint32_t walk_count = 0;
+	bool valid = true;
+	for (uint32_t i = 0; i < kSteps; ++i) {
+		auto begin = std::chrono::steady_clock::now();
+		if (i == 0)
+			world->Start();
+		else
+			world->SetCenterChunkPos(centers[i]);
+		auto mid = std::chrono::steady_clock::now();
+		rescan_pool.Update(centers[i]);
+		auto end = std::chrono::steady_clock::now();
+		if (!teleports[i]) {
+			++walk_count;
+			incremental_seconds += std::chrono::duration<double>(mid - begin).count();
+			rescan_seconds += std::chrono::duration<double>(end - mid).count();
+		}
+
+		if (i % kCheckInterval == kCheckInterval - 1) {
+			ChunkPos1 extent = std::max<ChunkPos1>(load_radius + 1, unload_radius) + 1;
+			for (ChunkPos1 y = -extent; y <= extent; ++y)
+				for (ChunkPos1 z = -extent; z <= extent; ++z)
+					for (ChunkPos1 x = -extent; x <= extent; ++x) {
+						ChunkPos3 pos = centers[i] + ChunkPos3{x, y, z};
+						valid &= bool(world->GetChunkPool().FindRawChunk(pos)) == rescan_pool.Contains(pos);
+					}
+		}
+	}
+	printf("load radius %d, unload radius %d: incremental %.1f us, rescan %.1f us per center change, %s\n",
+	       load_radius, unload_radius, incremental_seconds * 1e6 / walk_count, rescan_seconds * 1e6 / walk_count,
+	       valid ? "same chunks" : "CHUNKS MISMATCH");
+}
+
+static void run_shape(const char *name, const ChunkLoadShape &load_shape, std::optional<ChunkPos1> max_y) {
+	auto world = World::Create(load_shape, ChunkPos1(load_shape.radius + 2), ChunkPoolStorage::kRingMap);
+	auto begin = std::chrono::steady_clock::now();
+	if (max_y)
+		world->SetMaxLoadChunkY(*max_y); // the first update
+	world->Start();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	world->SetCenterChunkPos({1, 0, 0});
+	double step_seconds =
+	    std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() - seconds;
+	printf("%s of radius %d and height %d%s: %zu chunks, start %.1f ms, step %.2f ms\n", name, load_shape.radius,
+	       load_shape.height, max_y ? ", cut above the terrain" : "",
+	       world->GetChunkPool().GetSlabPool()->GetStats().in_use, seconds * 1e3, step_seconds * 1e3);
+}
+
+int main() {
+	run(8, 10);
+	run(11, 13);
+	run(20, 22);
+
+	// The same cut as LocalClient
+	constexpr ChunkPos1 kRadius = 48;
+	ChunkPos1 max_y = ChunkPos1(ChunkPosFromBlockPos(*DefaultTerrain::Create(0)->GetMaxHeight()) + 3);
+	run_shape("ball", {.radius = kRadius, .height = kRadius}, std::nullopt);
+	run_shape("ball", {.radius = kRadius, .height = kRadius}, max_y);
+	run_shape("ellipsoid", {.radius = kRadius, .height = 16}, max_y);
+	run_shape("cylinder", {.type = ChunkLoadShape::Type::kCylinder, .radius = kRadius, .height = 12}, max_y);
+	return 0;
+}
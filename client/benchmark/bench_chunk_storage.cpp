@@ -0,0 +1,104 @@
+// Compares the palette block storage of Chunk with a flat block array: resident memory per chunk and meshing
+// throughput over DefaultTerrain chunks.
+
+#include <client/BlockMeshAlgo.hpp>
+#include <client/Chunk.hpp>
+#include <client/DefaultTerrain.hpp>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+
+using namespace hc;
+using namespace hc::client;
+
+using FlatBlocks = std::array<block::Block, kChunkSize * kChunkSize * kChunkSize>;
+using MeshAlgo = BlockMeshAlgo<BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{0, 0, 0, kChunkSize, kChunkSize,
+                                                                                     kChunkSize},
+                                               kBlockAlgoSwizzleYZX>>;
+
+constexpr int32_t kRadiusXZ = 3, kMinY = -2, kMaxY = 4;
+constexpr uint32_t kMeshRounds = 3;
+
+template <typename ChunkT, typename FindFunc, typename GetFunc>
+static std::size_t mesh_all(const std::vector<ChunkPos3> &positions, FindFunc &&find, GetFunc &&get) {
+	std::size_t vertices = 0;
+	for (const auto &pos : positions) {
+		std::array<const ChunkT *, 27> neighbours;
+		for (uint32_t i = 0; i < 27; ++i) {
+			ChunkPos3 nei_pos;
+			Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+			neighbours[i] = find(pos + nei_pos);
+		}
+		auto meshes = MeshAlgo{}.Generate(
+		    [&](auto x, auto y, auto z) -> block::Block {
+			    return get(neighbours[Chunk::GetBlockNeighbourIndex(x, y, z)], x, y, z);
+		    },
+		    [](auto, auto, auto) -> block::Light { return {15, 0}; });
+		for (const auto &mesh : meshes)
+			vertices += mesh.vertices.size();
+	}
+	return vertices;
+}
+
+int main() {
+	auto terrain = DefaultTerrain::Create(12314524);
+
+	std::unordered_map<ChunkPos3, std::shared_ptr<Chunk>> chunks;
+	std::unordered_map<ChunkPos3, std::unique_ptr<FlatBlocks>> flat_chunks;
+	for (int32_t y = kMinY - 1; y <= kMaxY + 1; ++y)
+		for (int32_t z = -kRadiusXZ - 1; z <= kRadiusXZ + 1; ++z)
+			for (int32_t x = -kRadiusXZ - 1; x <= kRadiusXZ + 1; ++x) {
+				ChunkPos3 pos{x, y, z};
+				auto chunk = Chunk::Create(pos);
+				terrain->Generate(chunk);
+				chunk->CompactBlocks();
+				auto flat = std::make_unique<FlatBlocks>();
+				chunk->GetBlockStorage().Copy(0, flat->size(), flat->data());
+				chunks[pos] = std::move(chunk);
+				flat_chunks[pos] = std::move(flat);
+			}
+
+	std::size_t palette_bytes = 0;
+	std::map<uint32_t, uint32_t> bits_histogram;
+	for (const auto &it : chunks) {
+		palette_bytes += it.second->GetBlockStorage().GetHeapSize();
+		++bits_histogram[it.second->GetBlockStorage().GetBits()];
+	}
+	spdlog::info("{} chunks, block memory per chunk: flat {} B, palette {:.1f} B ({:.2f}%)", chunks.size(),
+	             sizeof(FlatBlocks), double(palette_bytes) / double(chunks.size()),
+	             100.0 * double(palette_bytes) / double(chunks.size() * sizeof(FlatBlocks)));
+	for (const auto &it : bits_histogram)
+		spdlog::info("  {:2} bits: {} chunks", it.first, it.second);
+
+	std::vector<ChunkPos3> mesh_positions;
+	for (int32_t y = kMinY; y <= kMaxY; ++y)
+		for (int32_t z = -kRadiusXZ; z <= kRadiusXZ; ++z)
+			for (int32_t x = -kRadiusXZ; x <= kRadiusXZ; ++x)
+				mesh_positions.emplace_back(x, y, z);
+
+	const auto bench = [&](const char *name, auto &&mesh_func) {
+		std::size_t vertices = 0;
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t r = 0; r < kMeshRounds; ++r)
+			vertices += mesh_func();
+		double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		spdlog::info("mesh {}: {:.1f} chunks/s ({} vertices)", name,
+		             double(mesh_positions.size() * kMeshRounds) / sec, vertices);
+	};
+	bench("flat", [&] {
+		return mesh_all<FlatBlocks>(
+		    mesh_positions, [&](const ChunkPos3 &pos) { return flat_chunks.at(pos).get(); },
+		    [](const FlatBlocks *blocks, auto x, auto y, auto z) {
+			    return (*blocks)[InnerIndex3FromPos((x + kChunkSize) % kChunkSize, (y + kChunkSize) % kChunkSize,
+			                                        (z + kChunkSize) % kChunkSize)];
+		    });
+	});
+	bench("palette", [&] {
+		return mesh_all<Chunk>(
+		    mesh_positions, [&](const ChunkPos3 &pos) { return chunks.at(pos).get(); },
+		    [](const Chunk *chunk, auto x, auto y, auto z) { return chunk->GetBlockFromNeighbour(x, y, z); });
+	});
+	return 0;
+}
@@ -0,0 +1,82 @@
+// Runs the memory budget checks of a World under budgets below and above the memory of its load shape: bytes and
+// shape shrink after each check, and whether the chunks kept are exactly the nearest ones. A wide and low cylinder
+// shows the horizontal radius shrinking past the height. Then fills and trims the DefaultTerrain caches.
+
+#include <client/Chunk.hpp>
+#include <client/DefaultTerrain.hpp>
+#include <client/World.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr ChunkLoadShape kLoadShape{.radius = 32, .height = 12},
+                         kLowLoadShape{.type = ChunkLoadShape::Type::kCylinder, .radius = 40, .height = 6};
+constexpr uint32_t kChecks = 12;
+constexpr int32_t kTerrainColumns = 24;
+constexpr double kMiB = 1024.0 * 1024.0;
+
+// Whether the world holds every chunk of its load shape and none outside its unload shape
+static bool keeps_nearest(const World &world) {
+	ChunkLoadShape load_shape = world.GetLoadShape(), unload_shape = world.GetUnloadShape();
+	ChunkLoadShape bound = unload_shape.Grow(2);
+	for (int32_t y = -bound.height; y <= bound.height; ++y)
+		for (int32_t z = -bound.radius; z <= bound.radius; ++z)
+			for (int32_t x = -bound.radius; x <= bound.radius; ++x) {
+				ChunkPos3 pos{x, y, z};
+				bool found = bool(world.GetChunkPool().FindRawChunk(pos));
+				if (found ? !unload_shape.Contains(pos) : load_shape.Contains(pos))
+					return false;
+			}
+	return true;
+}
+
+static void run_budget(World *p_world, const char *name, std::size_t budget) {
+	p_world->SetMemoryBudget(budget);
+	printf("%s budget %.1f MiB:\n", name, double(budget) / kMiB);
+	for (uint32_t i = 0; i < kChecks; ++i) {
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t t = 0; t < kMemoryBudgetTicks; ++t)
+			p_world->NextTick();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		ChunkLoadShape load_shape = p_world->GetLoadShape();
+		printf("  check %u: %.1f MiB, shrunk by %d chunks to radius %d height %d, %.2f ms\n", i,
+		       double(p_world->GetMemoryStats().GetTotal()) / kMiB, p_world->GetBudgetShrink(), load_shape.radius,
+		       load_shape.height, ms);
+	}
+	printf("  nearest chunks kept: %s\n", keeps_nearest(*p_world) ? "yes" : "NO");
+}
+
+int main() {
+	auto world = World::Create(kLoadShape, ChunkPos1(kLoadShape.radius + 2), ChunkPoolStorage::kRingMap);
+	world->Start();
+	std::size_t full_bytes = world->GetMemoryStats().GetTotal();
+	printf("no budget: %.1f MiB\n", double(full_bytes) / kMiB);
+	run_budget(world.get(), "3/4", full_bytes * 3 / 4);
+	// Below what the smallest shape takes, the shrink stops at kMemoryBudgetMinLoadRadius
+	run_budget(world.get(), "1/2", full_bytes / 2);
+	run_budget(world.get(), "1.5x", full_bytes * 3 / 2);
+	world.reset();
+
+	auto low_world = World::Create(kLowLoadShape, ChunkPos1(kLowLoadShape.radius + 2), ChunkPoolStorage::kRingMap);
+	low_world->Start();
+	std::size_t low_full_bytes = low_world->GetMemoryStats().GetTotal();
+	printf("low cylinder, no budget: %.1f MiB\n", double(low_full_bytes) / kMiB);
+	run_budget(low_world.get(), "1/2", low_full_bytes / 2);
+	low_world.reset();
+
+	auto terrain = DefaultTerrain::Create(12314524);
+	auto begin = std::chrono::steady_clock::now();
+	for (int32_t z = 0; z < kTerrainColumns; ++z)
+		for (int32_t x = 0; x < kTerrainColumns; ++x)
+			terrain->Generate(Chunk::Create({x, 0, z}));
+	double generate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	std::size_t cache_bytes = terrain->GetCacheBytes();
+	std::size_t freed_bytes = terrain->TrimCaches(cache_bytes / 2);
+	printf("terrain caches: %.1f MiB after %d columns (%.0f ms), trimming half freed %.1f MiB, %.1f MiB left\n",
+	       double(cache_bytes) / kMiB, kTerrainColumns * kTerrainColumns, generate_ms, double(freed_bytes) / kMiB,
+	       double(terrain->GetCacheBytes()) / kMiB);
+	return 0;
+}
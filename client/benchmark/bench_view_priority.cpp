@@ -0,0 +1,93 @@
+// Flies the center chunk through a world at a constant speed, sampling the fraction of chunks in view that are meshed,
+// then stops and measures the time until the view is fully meshed. Chunk tasks are prioritized by distance only, then
+// by the camera view and velocity.
+
+#include <client/LocalClient.hpp>
+#include <client/World.hpp>
+#include <client/WorldWorker.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+using namespace hc;
+using namespace hc::client;
+
+// Chunks are only meshed a few chunks inside the load radius, see World::IsViewMeshed()
+constexpr ChunkPos1 kLoadRadius = 8, kUnloadRadius = 10, kViewRadius = kLoadRadius - 4;
+constexpr std::size_t kConcurrency = 4;
+constexpr uint32_t kSteps = 16;
+constexpr auto kStepDuration = std::chrono::milliseconds(400);
+constexpr float kFov = 3.14159265f / 3.0f, kAspectRatio = 16.0f / 9.0f;
+const glm::vec3 kDirection{1.0f, 0.0f, 0.0f};
+
+// Fraction of chunks within kViewRadius and in the view that are meshed
+static double get_view_meshed_ratio(const World &world, const ChunkTaskView &view) {
+	ChunkPos3 center = world.GetCenterChunkPos();
+	uint32_t count = 0, meshed_count = 0;
+	for (ChunkPos1 y = -kViewRadius; y <= kViewRadius; ++y)
+		for (ChunkPos1 z = -kViewRadius; z <= kViewRadius; ++z)
+			for (ChunkPos1 x = -kViewRadius; x <= kViewRadius; ++x) {
+				ChunkPos3 rel_pos{x, y, z};
+				if (ChunkPosLength2(rel_pos) > uint32_t(kViewRadius * kViewRadius) || !view.IsVisible(rel_pos))
+					continue;
+				auto chunk = world.GetChunkPool().FindRawChunk(center + rel_pos);
+				++count;
+				meshed_count += chunk && chunk->IsMeshed();
+			}
+	return double(meshed_count) / double(count);
+}
+
+static void run(const char *name, bool prioritize_view) {
+	auto db_path = std::filesystem::temp_directory_path() / "hypercraft_bench_view_priority";
+	std::filesystem::remove_all(db_path);
+	std::filesystem::create_directories(db_path);
+
+	auto world = World::Create(kLoadRadius, kUnloadRadius);
+	auto client = LocalClient::Create(world, (db_path / "world").c_str());
+	auto worker = WorldWorker::Create(world);
+
+	glm::vec3 velocity = kDirection * float(kChunkSize) / std::chrono::duration<float>(kStepDuration).count();
+	// The view is also used to tell which chunks are visible when it doesn't prioritize tasks
+	ChunkTaskView view;
+	{
+		auto view_world = World::Create(kLoadRadius, kUnloadRadius);
+		view_world->SetCenterView(kDirection, kFov, kAspectRatio, velocity);
+		view = view_world->GetCenterView();
+	}
+	if (prioritize_view)
+		world->SetCenterView(kDirection, kFov, kAspectRatio, velocity);
+
+	worker->Launch(kConcurrency);
+	world->Start();
+	while (get_view_meshed_ratio(*world, view) < 1.0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	double ratio_sum = 0.0;
+	glm::vec3 position{0.5f};
+	for (uint32_t i = 0; i < kSteps; ++i) {
+		position += kDirection * float(kChunkSize);
+		world->SetCenterPos(position);
+		std::this_thread::sleep_for(kStepDuration);
+		ratio_sum += get_view_meshed_ratio(*world, view);
+	}
+	if (prioritize_view)
+		world->SetCenterView(kDirection, kFov, kAspectRatio, glm::vec3{0.0f});
+	auto stop_time = std::chrono::steady_clock::now();
+	while (get_view_meshed_ratio(*world, view) < 1.0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	printf("%s: %.1f%% of view meshed while flying, view meshed %.1f ms after stopping\n", name,
+	       ratio_sum / kSteps * 100.0,
+	       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stop_time).count());
+
+	worker->Join();
+	client.reset();
+	world.reset();
+	std::filesystem::remove_all(db_path);
+}
+
+int main() {
+	run("distance", false);
+	run("view", true);
+	return 0;
+}
@@ -0,0 +1,111 @@
+// Builds a world of large player-made structures in WorldDatabase with raw and with compressed records, then compares
+// the database size and the GetChunks() read throughput.
+
+#include <common/WorldDatabase.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace hc;
+
+constexpr ChunkPos1 kRadiusXZ = 6, kMinY = 0, kMaxY = 3;
+constexpr std::size_t kRequestSize = 256, kReadBatch = 32;
+constexpr uint32_t kReadRounds = 16;
+
+struct ChunkEdits {
+	ChunkPos3 chunk_pos;
+	std::vector<ChunkSetBlockEntry> blocks;
+	std::vector<ChunkSetSunlightEntry> sunlights;
+};
+
+// A building per chunk: a plank floor, cobblestone walls with glass windows, a glass roof, a dug out basement and
+// some furniture
+static ChunkEdits make_structure(const ChunkPos3 &chunk_pos, std::mt19937 *p_rng) {
+	ChunkEdits edits{chunk_pos};
+	uint32_t height = 8 + (*p_rng)() % 16, margin = (*p_rng)() % 4;
+	const auto set = [&](uint32_t x, uint32_t y, uint32_t z, block::Block block) {
+		edits.blocks.push_back({InnerIndex3FromPos(x, y, z), block::Blocks::kAir, block});
+	};
+	for (uint32_t y = 0; y < kChunkSize; ++y)
+		for (uint32_t z = margin; z < kChunkSize - margin; ++z)
+			for (uint32_t x = margin; x < kChunkSize - margin; ++x) {
+				bool wall = x == margin || z == margin || x == kChunkSize - margin - 1 || z == kChunkSize - margin - 1;
+				if (y < 4)
+					set(x, y, z, block::Blocks::kAir);
+				else if (y == 4)
+					set(x, y, z, block::Blocks::kPlank);
+				else if (y < 4 + height && wall)
+					set(x, y, z, (y % 4 == 2 && (x + z) % 3) ? block::Blocks::kGlass : block::Blocks::kCobblestone);
+				else if (y == 4 + height)
+					set(x, y, z, block::Blocks::kGlass);
+				else if (y == 5 && !wall && (*p_rng)() % 16 == 0)
+					set(x, y, z, (*p_rng)() % 2 ? block::Blocks::kGlowstone : block::Blocks::kLog);
+			}
+	for (uint32_t z = 0; z < kChunkSize; ++z)
+		for (uint32_t x = 0; x < kChunkSize; ++x)
+			edits.sunlights.push_back({InnerIndex2FromPos(x, z), 0, InnerPos1(5 + height)});
+	return edits;
+}
+
+static void run(const char *name, bool compress, const std::vector<ChunkEdits> &world) {
+	auto db_path = std::filesystem::temp_directory_path() / "hypercraft_bench_world_database";
+	std::filesystem::remove_all(db_path);
+	std::filesystem::create_directories(db_path);
+	auto database = WorldDatabase::Create((db_path / "world").string().c_str());
+	database->SetRecordCompression(compress);
+
+	auto begin = std::chrono::steady_clock::now();
+	std::size_t block_count = 0, sunlight_count = 0;
+	std::vector<ChunkPos3> positions;
+	for (const auto &edits : world) {
+		ChunkWriteRequests requests{edits.chunk_pos};
+		for (std::size_t i = 0; i < edits.blocks.size(); i += kRequestSize)
+			requests.blocks.emplace_back(edits.blocks.begin() + (std::ptrdiff_t)i,
+			                             edits.blocks.begin() +
+			                                 (std::ptrdiff_t)std::min(i + kRequestSize, edits.blocks.size()));
+		requests.sunlights.push_back(edits.sunlights);
+		database->Write({&requests, 1});
+		positions.push_back(edits.chunk_pos);
+	}
+	double write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+	begin = std::chrono::steady_clock::now();
+	for (uint32_t r = 0; r < kReadRounds; ++r) {
+		block_count = sunlight_count = 0;
+		for (std::size_t i = 0; i < positions.size(); i += kReadBatch) {
+			auto chunks = database->GetChunks(
+			    std::span{positions}.subspan(i, std::min(kReadBatch, positions.size() - i)));
+			for (const auto &chunk : chunks) {
+				block_count += chunk.blocks.size();
+				sunlight_count += chunk.sunlights.size();
+			}
+		}
+	}
+	double read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	std::size_t used_size = database->GetUsedSize();
+	printf("%s: %zu chunks, %zu blocks, %zu sunlights, %.2f MiB used (%.2f bytes per entry), written in %.0f ms, "
+	       "read %.0f chunks/s\n",
+	       name, positions.size(), block_count, sunlight_count, double(used_size) / (1024.0 * 1024.0),
+	       double(used_size) / double(block_count + sunlight_count), write_ms,
+	       double(positions.size() * kReadRounds) / read_seconds);
+
+	database.reset();
+	std::filesystem::remove_all(db_path);
+}
+
+int main() {
+	std::mt19937 rng{2333};
+	std::vector<ChunkEdits> world;
+	for (ChunkPos1 y = kMinY; y <= kMaxY; ++y)
+		for (ChunkPos1 z = -kRadiusXZ; z <= kRadiusXZ; ++z)
+			for (ChunkPos1 x = -kRadiusXZ; x <= kRadiusXZ; ++x)
+				world.push_back(make_structure({x, y, z}, &rng));
+
+	run("raw", false, world);
+	run("compressed", true, world);
+	return 0;
+}
@@ -0,0 +1,114 @@
+// Loads a world with WorldWorker threads, then measures the CPU used by the idle workers and the latency from a
+// SetBlock push to the block being visible. The chunk task counters are printed as CSV at the end of each run. A single
+// worker is run as well, since it has to produce and run every task by itself.
+
+#include <client/LocalClient.hpp>
+#include <client/World.hpp>
+#include <client/WorldWorker.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+using namespace hc;
+using namespace hc::client;
+
+constexpr ChunkPos1 kLoadRadius = 6, kUnloadRadius = 8;
+constexpr std::size_t kConcurrencies[] = {1, 4};
+constexpr auto kLoadTimeout = std::chrono::seconds(60);
+constexpr uint32_t kWakeTrials = 20;
+
+static double get_cpu_seconds() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+	       double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+static bool is_loaded(const World &world) {
+	constexpr ChunkPos1 kRadius = kLoadRadius - 2;
+	for (ChunkPos1 y = -kRadius; y <= kRadius; ++y)
+		for (ChunkPos1 z = -kRadius; z <= kRadius; ++z)
+			for (ChunkPos1 x = -kRadius; x <= kRadius; ++x) {
+				ChunkPos3 pos{x, y, z};
+				if (ChunkPosLength2(pos) > uint32_t(kRadius * kRadius))
+					continue;
+				auto chunk = world.GetChunkPool().FindChunk(pos);
+				if (!chunk || !chunk->IsLightValid())
+					return false;
+			}
+	return true;
+}
+
+static bool run(std::size_t concurrency) {
+	auto db_path = std::filesystem::temp_directory_path() / "hypercraft_bench_world_worker";
+	std::filesystem::remove_all(db_path);
+	std::filesystem::create_directories(db_path);
+
+	auto world = World::Create(kLoadRadius, kUnloadRadius);
+	auto client = LocalClient::Create(world, (db_path / "world").c_str());
+	auto worker = WorldWorker::Create(world);
+	worker->Launch(concurrency);
+	printf("%zu workers\n", concurrency);
+
+	auto begin = std::chrono::steady_clock::now();
+	world->Start();
+	bool loaded;
+	while (!(loaded = is_loaded(*world)) && std::chrono::steady_clock::now() - begin < kLoadTimeout)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	if (!loaded) {
+		printf("load: not finished after %lld s\n", (long long)kLoadTimeout.count());
+		printf("%s", world->GetChunkTaskPool().GetTaskStats().ToCSV().c_str());
+		worker->Join();
+		client.reset();
+		world.reset();
+		std::filesystem::remove_all(db_path);
+		return false;
+	}
+	printf("load: %.3f s\n", std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	{
+		double cpu_begin = get_cpu_seconds();
+		auto wall_begin = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(std::chrono::seconds(2));
+		double cpu = get_cpu_seconds() - cpu_begin,
+		       wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+		printf("idle: %.1f%% of one core (%zu workers)\n", cpu / wall * 100.0, concurrency);
+	}
+
+	std::vector<double> latencies;
+	for (uint32_t i = 0; i < kWakeTrials; ++i) {
+		// Let the workers park again
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		BlockPos3 pos{(BlockPos1)i, 0, 0};
+		block::Block block = world->GetBlock(pos).value() == block::Blocks::kStone ? block::Blocks::kGlass
+		                                                                            : block::Blocks::kStone;
+		auto push_time = std::chrono::steady_clock::now();
+		world->SetBlock(pos, block);
+		while (world->GetBlock(pos).value() != block)
+			std::this_thread::yield();
+		latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - push_time).count());
+	}
+	std::sort(latencies.begin(), latencies.end());
+	printf("wake latency (SetBlock push to visible): median %.1f us, p90 %.1f us, max %.1f us\n",
+	       latencies[latencies.size() / 2], latencies[latencies.size() * 9 / 10], latencies.back());
+
+	printf("%s", world->GetChunkTaskPool().GetTaskStats().ToCSV().c_str());
+
+	worker->Join();
+	client.reset();
+	world.reset();
+	std::filesystem::remove_all(db_path);
+	return true;
+}
+
+int main() {
+	bool success = true;
+	for (std::size_t concurrency : kConcurrencies)
+		success = run(concurrency) && success;
+	return success ? 0 : 1;
+}
@@ -13,6 +13,9 @@
 
 #include <client/rg/WorldRenderGraph.hpp>
 
+#include <chrono>
+#include <optional>
+
 namespace hc::client {
 
 class Application {
@@ -44,8 +47,19 @@ private:
 	// Temporal game data TODO: remove
 	float m_day_night = 0.0;
 	bool m_mouse_captured = false;
+	glm::vec3 m_camera_velocity{0.0f};
+	// Time from the last view change until all chunks in the view are meshed
+	std::optional<std::chrono::steady_clock::time_point> m_view_change_time;
+	double m_view_meshed_ms = 0.0;
+	// Chunk task counters of the last second
+	ChunkTaskStats m_task_stats, m_task_stats_window;
+	// Chunk stage durations of the chunks visible in the last second
+	ChunkLifecycleStats m_chunk_lifecycle_stats, m_chunk_lifecycle_stats_window;
+	std::chrono::steady_clock::time_point m_chunk_lifecycle_time{};
 	std::optional<ChunkPos3> m_selected_pos, m_outer_selected_pos;
 	std::optional<block::Block> m_selected_block;
+	void task_stats_gui();
+	void chunk_lifecycle_gui();
 	void select_block();
 	void modify_block();
 
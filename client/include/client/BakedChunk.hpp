@@ -0,0 +1,20 @@
+#ifndef HYPERCRAFT_CLIENT_BAKED_CHUNK_HPP
+#define HYPERCRAFT_CLIENT_BAKED_CHUNK_HPP
+
+#include <cinttypes>
+#include <span>
+#include <vector>
+
+namespace hc::client {
+
+class Chunk;
+
+// Generated blocks and sunlight heights of a chunk, stored in the WorldDatabase so that the terrain of a visited chunk
+// is not generated again. Encoded as runs of a block palette and runs of sunlight heights.
+std::vector<uint8_t> EncodeBakedChunk(const Chunk &chunk);
+// Returns false if the record is malformed, the chunk is left untouched then
+bool DecodeBakedChunk(std::span<const uint8_t> record, Chunk *p_chunk);
+
+} // namespace hc::client
+
+#endif
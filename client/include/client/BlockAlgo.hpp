@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cinttypes>
+#include <tuple>
+
 namespace hc::client {
 
 using BlockAlgoAxis = uint8_t;
@@ -2,6 +2,7 @@
 
 #include <block/BlockFace.hpp>
 #include <block/Light.hpp>
+#include <common/Trace.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <queue>
@@ -44,7 +45,7 @@ public:
 	template <typename GetBlockFunc, typename GetLightFunc, typename SetLightFunc>
 	inline void PropagateLight(Queue *p_entries, GetBlockFunc get_block_func, GetLightFunc get_light_func,
 	                           SetLightFunc set_light_func) {
-
+		HC_TRACE_ZONE("BlockLightAlgo::PropagateLight");
 		while (!p_entries->empty()) {
 			Entry e = p_entries->front();
 			p_entries->pop();
@@ -71,6 +72,38 @@ public:
 			}
 		}
 	}
+
+	// Entries hold the light levels removed at their positions (already reset by the caller). Dimmer lights that may
+	// come from them are reset to get_source_func() as well, brighter or equal ones are pushed to p_add_entries, so
+	// that a following PropagateLight(p_add_entries, ...) refills the darkened area.
+	template <typename GetLightFunc, typename SetLightFunc, typename GetSourceFunc>
+	inline void RemoveLight(Queue *p_entries, Queue *p_add_entries, GetLightFunc get_light_func,
+	                        SetLightFunc set_light_func, GetSourceFunc get_source_func) {
+		while (!p_entries->empty()) {
+			Entry e = p_entries->front();
+			p_entries->pop();
+			for (block::BlockFace f = 0; f < 6; ++f) {
+				Entry nei = e;
+				block::BlockFaceProceed(glm::value_ptr(nei.pos), f);
+
+				if (!in_bound_bordered(nei.pos.x, nei.pos.y, nei.pos.z))
+					continue;
+
+				block::LightLvl lvl = get_light_func(nei.pos.x, nei.pos.y, nei.pos.z);
+				if (lvl == 0)
+					continue;
+				if (lvl < e.lvl) {
+					block::LightLvl source = get_source_func(nei.pos.x, nei.pos.y, nei.pos.z);
+					set_light_func(nei.pos.x, nei.pos.y, nei.pos.z, source);
+					nei.lvl = lvl;
+					p_entries->push(nei);
+					if (source)
+						p_add_entries->push({nei.pos, source});
+				} else
+					p_add_entries->push({nei.pos, lvl});
+			}
+		}
+	}
 };
 
 } // namespace hc::client
\ No newline at end of file
@@ -6,15 +6,19 @@
 #include <block/Block.hpp>
 #include <block/Light.hpp>
 #include <common/Size.hpp>
+#include <common/Trace.hpp>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/hash.hpp>
 
+#include <bit>
 #include <vector>
 
 namespace hc::client {
 
-template <typename Config> class BlockMeshAlgo {
+enum class BlockMeshBackend { kScalar, kBitmask };
+
+template <typename Config, BlockMeshBackend Backend = BlockMeshBackend::kBitmask> class BlockMeshAlgo {
 private:
 	struct AO4 { // compressed ambient occlusion data for 4 vertices (a face)
 		uint8_t m_data;
@@ -305,6 +309,88 @@ private:
 		}
 	}
 
+	template <BlockAlgoAxis Axis>
+	inline void push_quad(uint8_t quad_face_inv, typename Config::Type xa, typename Config::Type u,
+	                      typename Config::Type v, uint32_t width, uint32_t height, texture::BlockTexture quad_texture,
+	                      Light4 quad_light) {
+		constexpr BlockAlgoAxis kUAxis = Config::template GetNextAxis<Axis>();
+		constexpr BlockAlgoAxis kVAxis = Config::template GetNextAxis2<Axis>();
+
+		auto [x, y, z] = Config::template ToXYZ<Axis, uint32_t>(xa, u, v);
+		uint32_t ux, uy, uz, vx, vy, vz;
+		if (quad_face_inv ^ ((kUAxis + 1) % 3 == kVAxis)) {
+			std::tie(ux, uy, uz) = Config::template ToXYZ<Axis, uint32_t>(0, height, 0);
+			std::tie(vx, vy, vz) = Config::template ToXYZ<Axis, uint32_t>(0, 0, width);
+		} else {
+			std::tie(ux, uy, uz) = Config::template ToXYZ<Axis, uint32_t>(0, 0, width);
+			std::tie(vx, vy, vz) = Config::template ToXYZ<Axis, uint32_t>(0, height, 0);
+		}
+
+		// TODO: process resource rotation
+
+		BlockMesh &info = quad_texture.UseTransparentPass() ? m_transparent_mesh_info : m_opaque_mesh_info;
+		// if indices would exceed, restart
+		uint16_t cur_vertex = info.vertices.size();
+		if (cur_vertex + 4 > UINT16_MAX) {
+			bool trans = info.transparent;
+			m_meshes.push_back(std::move(info));
+			info = BlockMesh{};
+			info.transparent = trans;
+		}
+		info.aabb.Merge({{uint32_t(x) << BlockVertex::kUnitBitOffset, uint32_t(y) << BlockVertex::kUnitBitOffset,
+		                  uint32_t(z) << BlockVertex::kUnitBitOffset},
+		                 {uint32_t(x + ux + vx) << BlockVertex::kUnitBitOffset,
+		                  uint32_t(y + uy + vy) << BlockVertex::kUnitBitOffset,
+		                  uint32_t(z + uz + vz) << BlockVertex::kUnitBitOffset}});
+
+		block::BlockFace quad_face = (Axis << 1) | quad_face_inv;
+		info.vertices.emplace_back(x << BlockVertex::kUnitBitOffset, y << BlockVertex::kUnitBitOffset,
+		                           z << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[0],
+		                           quad_light.sunlight[0], quad_light.torchlight[0], quad_texture.GetID(),
+		                           quad_texture.GetTransformation());
+		info.vertices.emplace_back((x + ux) << BlockVertex::kUnitBitOffset, (y + uy) << BlockVertex::kUnitBitOffset,
+		                           (z + uz) << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[1],
+		                           quad_light.sunlight[1], quad_light.torchlight[1], quad_texture.GetID(),
+		                           quad_texture.GetTransformation());
+		info.vertices.emplace_back((x + ux + vx) << BlockVertex::kUnitBitOffset,
+		                           (y + uy + vy) << BlockVertex::kUnitBitOffset,
+		                           (z + uz + vz) << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[2],
+		                           quad_light.sunlight[2], quad_light.torchlight[2], quad_texture.GetID(),
+		                           quad_texture.GetTransformation());
+		info.vertices.emplace_back((x + vx) << BlockVertex::kUnitBitOffset, (y + vy) << BlockVertex::kUnitBitOffset,
+		                           (z + vz) << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[3],
+		                           quad_light.sunlight[3], quad_light.torchlight[3], quad_texture.GetID(),
+		                           quad_texture.GetTransformation());
+
+		if (quad_light.GetFlip()) {
+			// 11--------10
+			//|       / |
+			//|    /    |
+			//| /       |
+			// 00--------01
+			info.indices.push_back(cur_vertex);
+			info.indices.push_back(cur_vertex + 1);
+			info.indices.push_back(cur_vertex + 2);
+
+			info.indices.push_back(cur_vertex);
+			info.indices.push_back(cur_vertex + 2);
+			info.indices.push_back(cur_vertex + 3);
+		} else {
+			// 11--------10
+			//| \       |
+			//|    \    |
+			//|       \ |
+			// 00--------01
+			info.indices.push_back(cur_vertex + 1);
+			info.indices.push_back(cur_vertex + 2);
+			info.indices.push_back(cur_vertex + 3);
+
+			info.indices.push_back(cur_vertex);
+			info.indices.push_back(cur_vertex + 1);
+			info.indices.push_back(cur_vertex + 3);
+		}
+	}
+
 	template <BlockAlgoAxis Axis, typename GetBlockFunc, typename GetLightFunc>
 	inline void generate_regular_mesh_axis(GetBlockFunc &&get_block_func, GetLightFunc &&get_light_func) {
 		using T = typename Config::Type;
@@ -378,86 +464,7 @@ private:
 								}
 						end_height_loop:
 
-							// Add quad
-							auto [x, y, z] = Config::template ToXYZ<Axis, uint32_t>(xa, u, v);
-							uint32_t ux, uy, uz, vx, vy, vz;
-							if (quad_face_inv ^ ((kUAxis + 1) % 3 == kVAxis)) {
-								std::tie(ux, uy, uz) = Config::template ToXYZ<Axis, uint32_t>(0, height, 0);
-								std::tie(vx, vy, vz) = Config::template ToXYZ<Axis, uint32_t>(0, 0, width);
-							} else {
-								std::tie(ux, uy, uz) = Config::template ToXYZ<Axis, uint32_t>(0, 0, width);
-								std::tie(vx, vy, vz) = Config::template ToXYZ<Axis, uint32_t>(0, height, 0);
-							}
-
-							// TODO: process resource rotation
-
-							BlockMesh &info =
-							    quad_texture.UseTransparentPass() ? m_transparent_mesh_info : m_opaque_mesh_info;
-							// if indices would exceed, restart
-							uint16_t cur_vertex = info.vertices.size();
-							if (cur_vertex + 4 > UINT16_MAX) {
-								bool trans = info.transparent;
-								m_meshes.push_back(std::move(info));
-								info = BlockMesh{};
-								info.transparent = trans;
-							}
-							info.aabb.Merge({{uint32_t(x) << BlockVertex::kUnitBitOffset,
-							                  uint32_t(y) << BlockVertex::kUnitBitOffset,
-							                  uint32_t(z) << BlockVertex::kUnitBitOffset},
-							                 {uint32_t(x + ux + vx) << BlockVertex::kUnitBitOffset,
-							                  uint32_t(y + uy + vy) << BlockVertex::kUnitBitOffset,
-							                  uint32_t(z + uz + vz) << BlockVertex::kUnitBitOffset}});
-
-							block::BlockFace quad_face = (Axis << 1) | quad_face_inv;
-							info.vertices.emplace_back(
-							    x << BlockVertex::kUnitBitOffset, y << BlockVertex::kUnitBitOffset,
-							    z << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[0],
-							    quad_light.sunlight[0], quad_light.torchlight[0], quad_texture.GetID(),
-							    quad_texture.GetTransformation());
-							info.vertices.emplace_back(
-							    (x + ux) << BlockVertex::kUnitBitOffset, (y + uy) << BlockVertex::kUnitBitOffset,
-							    (z + uz) << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[1],
-							    quad_light.sunlight[1], quad_light.torchlight[1], quad_texture.GetID(),
-							    quad_texture.GetTransformation());
-							info.vertices.emplace_back((x + ux + vx) << BlockVertex::kUnitBitOffset,
-							                           (y + uy + vy) << BlockVertex::kUnitBitOffset,
-							                           (z + uz + vz) << BlockVertex::kUnitBitOffset, Axis, quad_face,
-							                           quad_light.ao[2], quad_light.sunlight[2],
-							                           quad_light.torchlight[2], quad_texture.GetID(),
-							                           quad_texture.GetTransformation());
-							info.vertices.emplace_back(
-							    (x + vx) << BlockVertex::kUnitBitOffset, (y + vy) << BlockVertex::kUnitBitOffset,
-							    (z + vz) << BlockVertex::kUnitBitOffset, Axis, quad_face, quad_light.ao[3],
-							    quad_light.sunlight[3], quad_light.torchlight[3], quad_texture.GetID(),
-							    quad_texture.GetTransformation());
-
-							if (quad_light.GetFlip()) {
-								// 11--------10
-								//|       / |
-								//|    /    |
-								//| /       |
-								// 00--------01
-								info.indices.push_back(cur_vertex);
-								info.indices.push_back(cur_vertex + 1);
-								info.indices.push_back(cur_vertex + 2);
-
-								info.indices.push_back(cur_vertex);
-								info.indices.push_back(cur_vertex + 2);
-								info.indices.push_back(cur_vertex + 3);
-							} else {
-								// 11--------10
-								//| \       |
-								//|    \    |
-								//|       \ |
-								// 00--------01
-								info.indices.push_back(cur_vertex + 1);
-								info.indices.push_back(cur_vertex + 2);
-								info.indices.push_back(cur_vertex + 3);
-
-								info.indices.push_back(cur_vertex);
-								info.indices.push_back(cur_vertex + 1);
-								info.indices.push_back(cur_vertex + 3);
-							}
+							push_quad<Axis>(quad_face_inv, xa, u, v, width, height, quad_texture, quad_light);
 
 							for (uint32_t a = 0; a < height; ++a) {
 								auto *base_ptr =
@@ -481,6 +488,153 @@ private:
 		}
 	}
 
+	// Bitmask backend of generate_regular_mesh_axis with identical output. For every column along Axis, 64-bit masks of
+	// empty and opaque faces resolve most visible faces with shifts and ANDs (Show() is only called for the remaining
+	// transparent / liquid pairs). Visible faces are scattered into per-slice row masks, then merged with bit scans in
+	// the same order as the scalar greedy meshing.
+	template <BlockAlgoAxis Axis, typename GetBlockFunc, typename GetLightFunc>
+	inline void generate_regular_mesh_axis_bitmask(GetBlockFunc &&get_block_func, GetLightFunc &&get_light_func) {
+		using T = typename Config::Type;
+
+		constexpr BlockAlgoAxis kUAxis = Config::template GetNextAxis<Axis>();
+		constexpr BlockAlgoAxis kVAxis = Config::template GetNextAxis2<Axis>();
+		constexpr T kMin = Config::template GetMin<Axis>(), kMax = Config::template GetMax<Axis>();
+		constexpr uint32_t kSpanU = Config::template GetSpan<kUAxis, uint32_t>(),
+		                   kSpanV = Config::template GetSpan<kVAxis, uint32_t>(), kArea = kSpanU * kSpanV;
+		// Bit i of a column is the block at kMin - 1 + i, the slice xa = kMin - 1 + i lies between bit i - 1 and i
+		constexpr uint32_t kColumnBits = kMax - kMin + 2;
+		static_assert(kColumnBits < 64 && kSpanV <= 64);
+		constexpr uint64_t kColumnMask = (uint64_t(1) << kColumnBits) - 1;
+		// faces of kFA are visible on slices (kMin, kMax], faces of kFB on [kMin, kMax)
+		constexpr uint64_t kSliceMask[2] = {kColumnMask & ~uint64_t(3),
+		                                    kColumnMask & ~(uint64_t(1) << (kColumnBits - 1)) & ~uint64_t(1)};
+		constexpr block::BlockFace kFA = Axis << 1, kFB = kFA | 1;
+		// Show(opaque, empty) is true only if empty textures count as transparent
+		constexpr bool kOpaqueShowEmpty = texture::BlockTexture{}.IsTransparent();
+
+		// textures of the kFA / kFB faces, indexed by [face][column][bit]
+		m_column_textures.resize(2 * kArea * kColumnBits);
+		texture::BlockTexture *column_textures[2] = {m_column_textures.data(),
+		                                             m_column_textures.data() + kArea * kColumnBits};
+		// visible faces, indexed by [face][slice bit][u]
+		m_face_rows.assign(2 * kColumnBits * kSpanU, 0);
+		uint64_t *face_rows[2] = {m_face_rows.data(), m_face_rows.data() + kColumnBits * kSpanU};
+		m_light_buffer.resize(kArea);
+
+		const auto get_empty_opaque = [](texture::BlockTexture tex, uint64_t bit, uint64_t *p_empty,
+		                                 uint64_t *p_opaque) {
+			if (tex.Empty())
+				*p_empty |= bit;
+			else if (!tex.IsTransparent() && !tex.IsLiquid())
+				*p_opaque |= bit;
+		};
+
+		uint32_t column = 0;
+		for (uint32_t ui = 0; ui < kSpanU; ++ui)
+			for (uint32_t vi = 0; vi < kSpanV; ++vi, ++column) {
+				T u = T(Config::template GetMin<kUAxis>() + ui), v = T(Config::template GetMin<kVAxis>() + vi);
+				texture::BlockTexture *tex_a = column_textures[0] + column * kColumnBits,
+				                      *tex_b = column_textures[1] + column * kColumnBits;
+				uint64_t empty_a = 0, opaque_a = 0, empty_b = 0, opaque_b = 0;
+				for (uint32_t i = 0; i < kColumnBits; ++i) {
+					auto [x, y, z] = Config::template ToXYZ<Axis, T>(T(kMin - 1 + (T)i), u, v);
+					block::Block block = get_block_func(x, y, z);
+					if (m_dynamic_block_textures.empty()) {
+						tex_a[i] = block.GetTexture(kFA);
+						tex_b[i] = block.GetTexture(kFB);
+					} else {
+						auto it = m_dynamic_block_textures.find(glm::vec<3, T>(x, y, z));
+						tex_a[i] = it == m_dynamic_block_textures.end() ? block.GetTexture(kFA) : it->second[kFA];
+						tex_b[i] = it == m_dynamic_block_textures.end() ? block.GetTexture(kFB) : it->second[kFB];
+					}
+					get_empty_opaque(tex_a[i], uint64_t(1) << i, &empty_a, &opaque_a);
+					get_empty_opaque(tex_b[i], uint64_t(1) << i, &empty_b, &opaque_b);
+				}
+				// Align kFA faces of the blocks before each slice with the kFB faces after it
+				empty_a <<= 1u;
+				opaque_a <<= 1u;
+
+				uint64_t visible[2], unknown[2];
+				visible[0] = kOpaqueShowEmpty ? opaque_a & empty_b : 0;
+				unknown[0] = ~(empty_a | (opaque_a & opaque_b) | visible[0]) & kSliceMask[0];
+				visible[1] = kOpaqueShowEmpty ? opaque_b & empty_a : 0;
+				unknown[1] = ~(empty_b | (opaque_b & opaque_a) | visible[1]) & kSliceMask[1];
+				for (uint64_t bits = unknown[0]; bits; bits &= bits - 1) {
+					uint32_t i = std::countr_zero(bits);
+					if (tex_a[i - 1].Show(tex_b[i]))
+						visible[0] |= uint64_t(1) << i;
+				}
+				for (uint64_t bits = unknown[1]; bits; bits &= bits - 1) {
+					uint32_t i = std::countr_zero(bits);
+					if (tex_b[i].Show(tex_a[i - 1]))
+						visible[1] |= uint64_t(1) << i;
+				}
+
+				for (uint32_t f = 0; f < 2; ++f)
+					for (uint64_t bits = visible[f] & kSliceMask[f]; bits; bits &= bits - 1)
+						face_rows[f][std::countr_zero(bits) * kSpanU + ui] |= uint64_t(1) << vi;
+			}
+
+		for (uint32_t i = 1; i < kColumnBits; ++i) {
+			T xa = T(kMin - 1 + (T)i);
+			for (uint8_t quad_face_inv = 0; quad_face_inv < 2; ++quad_face_inv) {
+				uint64_t *rows = face_rows[quad_face_inv] + i * kSpanU;
+				// texture of the face in column c: textures[c * kColumnBits]
+				const texture::BlockTexture *textures = column_textures[quad_face_inv] + (quad_face_inv ? i : i - 1);
+				T xb = quad_face_inv ? xa : T(xa - 1);
+				block::BlockFace face = quad_face_inv ? kFB : kFA;
+
+				bool any = false;
+				for (uint32_t ui = 0; ui < kSpanU; ++ui) {
+					for (uint64_t bits = rows[ui]; bits; bits &= bits - 1) {
+						uint32_t vi = std::countr_zero(bits);
+						auto [x, y, z] = Config::template ToXYZ<Axis, T>(xb, T(Config::template GetMin<kUAxis>() + ui),
+						                                                  T(Config::template GetMin<kVAxis>() + vi));
+						light4_init(get_block_func, get_light_func, m_light_buffer.data() + ui * kSpanV + vi, face, x,
+						            y, z);
+					}
+					any |= rows[ui] != 0;
+				}
+				if (!any)
+					continue;
+
+				const auto same_quad = [&](uint32_t a, uint32_t b) {
+					return textures[a * kColumnBits] == textures[b * kColumnBits] &&
+					       m_light_buffer[a] == m_light_buffer[b];
+				};
+				for (uint32_t ui = 0; ui < kSpanU; ++ui) {
+					while (rows[ui]) {
+						uint32_t vi = std::countr_zero(rows[ui]), counter = ui * kSpanV + vi;
+						// Compute width in the run of visible faces
+						uint32_t run = std::countr_one(rows[ui] >> vi), width;
+						for (width = 1; width < run && same_quad(counter, counter + width); ++width)
+							;
+						uint64_t width_mask = (width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1) << vi;
+
+						// Compute height
+						uint32_t height;
+						for (height = 1; ui + height < kSpanU; ++height) {
+							if ((rows[ui + height] & width_mask) != width_mask)
+								break;
+							uint32_t k = 0, nei_counter = counter + height * kSpanV;
+							while (k < width && same_quad(counter, nei_counter + k))
+								++k;
+							if (k < width)
+								break;
+						}
+
+						push_quad<Axis>(quad_face_inv, xa, T(Config::template GetMin<kUAxis>() + ui),
+						                T(Config::template GetMin<kVAxis>() + vi), width, height,
+						                textures[counter * kColumnBits], m_light_buffer[counter]);
+
+						for (uint32_t a = 0; a < height; ++a)
+							rows[ui + a] &= ~width_mask;
+					}
+				}
+			}
+		}
+	}
+
 	std::vector<BlockMesh> m_meshes;
 	BlockMesh m_opaque_mesh_info, m_transparent_mesh_info;
 
@@ -490,9 +644,14 @@ private:
 	    m_dynamic_block_textures;
 	std::array<texture::BlockTexture, 6> m_dynamic_block_texture_buffer;
 
+	std::vector<texture::BlockTexture> m_column_textures;
+	std::vector<uint64_t> m_face_rows;
+	std::vector<Light4> m_light_buffer;
+
 public:
 	template <typename GetBlockFunc, typename GetLightFunc>
 	inline std::vector<BlockMesh> Generate(GetBlockFunc &&get_block_func, GetLightFunc &&get_light_func) {
+		HC_TRACE_ZONE("BlockMeshAlgo::Generate");
 		using T = typename Config::Type;
 		static_assert(std::is_integral_v<T>);
 		static_assert(Config::kBound.min_x >= 0 && Config::kBound.min_y >= 0 && Config::kBound.min_z >= 0);
@@ -508,9 +667,15 @@ public:
 
 		generate_custom_mesh(get_block_func, get_light_func);
 
-		generate_regular_mesh_axis<0>(get_block_func, get_light_func);
-		generate_regular_mesh_axis<1>(get_block_func, get_light_func);
-		generate_regular_mesh_axis<2>(get_block_func, get_light_func);
+		if constexpr (Backend == BlockMeshBackend::kBitmask) {
+			generate_regular_mesh_axis_bitmask<0>(get_block_func, get_light_func);
+			generate_regular_mesh_axis_bitmask<1>(get_block_func, get_light_func);
+			generate_regular_mesh_axis_bitmask<2>(get_block_func, get_light_func);
+		} else {
+			generate_regular_mesh_axis<0>(get_block_func, get_light_func);
+			generate_regular_mesh_axis<1>(get_block_func, get_light_func);
+			generate_regular_mesh_axis<2>(get_block_func, get_light_func);
+		}
 
 		if (!m_opaque_mesh_info.vertices.empty())
 			m_meshes.push_back(std::move(m_opaque_mesh_info));
@@ -20,7 +20,7 @@ public:
 	glm::vec3 m_position{0.0f, 0.0f, 0.0f};
 	float m_yaw{0.0f}, m_pitch{0.0f};
 	float m_sensitive{0.005f}, m_speed{2.0f}, m_fov{PIF / 3.0f},
-	    m_aspect_ratio{float(kDefaultWidth) / float(kDefaultHeight)};
+	    m_aspect_ratio{float(kDefaultWidth) / float(kDefaultHeight)}, m_far{1024.0f};
 
 	struct UniformData {
 		glm::vec4 view_position;
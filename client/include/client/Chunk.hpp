@@ -7,8 +7,8 @@
 #include <common/Size.hpp>
 #include <glm/glm.hpp>
 
-#include "client/mesh/MeshHandle.hpp"
-#include <client/ChunkMesh.hpp>
+#include <client/ChunkLifecycle.hpp>
+#include <client/PaletteArray.hpp>
 
 #include <atomic>
 #include <memory>
@@ -30,7 +30,7 @@ public:
 	template <typename T>
 	static inline constexpr typename std::enable_if<std::is_integral<T>::value, uint32_t>::type
 	CmpXYZ2NeighbourIndex(T cmp_x, T cmp_y, T cmp_z) {
-		return CmpXYZ2NeighbourIndex(cmp_x, cmp_y, cmp_z);
+		return hc::CmpXYZ2NeighbourIndex(cmp_x, cmp_y, cmp_z);
 	}
 	template <typename T>
 	static inline constexpr typename std::enable_if<std::is_integral<T>::value, uint32_t>::type
@@ -45,21 +45,65 @@ public:
 
 	inline const ChunkPos3 &GetPosition() const { return m_position; }
 
+	using BlockStorage = PaletteArray<Block, kSize * kSize * kSize>;
+
+	// Proxy returned by GetBlockRef, since packed blocks are not addressable
+	class BlockRef {
+	private:
+		BlockStorage *m_storage;
+		uint32_t m_idx;
+
+	public:
+		inline BlockRef(BlockStorage *storage, uint32_t idx) : m_storage{storage}, m_idx{idx} {}
+		inline operator Block() const { return m_storage->Get(m_idx); }
+		inline BlockRef &operator=(Block b) {
+			m_storage->Set(m_idx, b);
+			return *this;
+		}
+	};
+
 	// TODO: Protect Block & Light RW with mutexes
 	// Block Getter and Setter
-	inline const Block *GetBlockData() const { return m_blocks; }
-	template <typename T> inline Block GetBlock(T x, T y, T z) const { return m_blocks[InnerIndex3FromPos(x, y, z)]; }
-	template <typename T> inline Block &GetBlockRef(T x, T y, T z) { return m_blocks[InnerIndex3FromPos(x, y, z)]; }
-	inline Block GetBlock(uint32_t idx) const { return m_blocks[idx]; }
-	inline Block &GetBlockRef(uint32_t idx) { return m_blocks[idx]; }
-	template <typename T> inline void SetBlock(T x, T y, T z, Block b) { m_blocks[InnerIndex3FromPos(x, y, z)] = b; }
-	inline void SetBlock(uint32_t idx, Block b) { m_blocks[idx] = b; }
+	inline const BlockStorage &GetBlockStorage() const { return m_blocks; }
+	template <typename T> inline Block GetBlock(T x, T y, T z) const { return m_blocks.Get(InnerIndex3FromPos(x, y, z)); }
+	template <typename T> inline BlockRef GetBlockRef(T x, T y, T z) {
+		return {&m_blocks, (uint32_t)InnerIndex3FromPos(x, y, z)};
+	}
+	inline Block GetBlock(uint32_t idx) const { return m_blocks.Get(idx); }
+	inline BlockRef GetBlockRef(uint32_t idx) { return {&m_blocks, idx}; }
+	template <typename T> inline void SetBlock(T x, T y, T z, Block b) { SetBlock(InnerIndex3FromPos(x, y, z), b); }
+	inline void SetBlock(uint32_t idx, Block b) {
+		m_blocks.Set(idx, b);
+		if (m_uniform_counted && !m_blocks.IsUniform()) {
+			m_uniform_counted = false;
+			s_uniform_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+	inline void FillBlocks(Block b) { m_blocks.Fill(b); }
+	inline void AssignBlocks(const Block *blocks) { m_blocks.Assign(blocks); }
 	template <std::signed_integral T> inline Block GetBlockFromNeighbour(T x, T y, T z) const {
-		return m_blocks[InnerIndex3FromPos((x + kSize) % kSize, (y + kSize) % kSize, (z + kSize) % kSize)];
+		return m_blocks.Get(InnerIndex3FromPos((x + kSize) % kSize, (y + kSize) % kSize, (z + kSize) % kSize));
 	}
 	template <std::unsigned_integral T> inline Block GetBlockFromNeighbour(T x, T y, T z) const {
-		return m_blocks[InnerIndex3FromPos(x % kSize, y % kSize, z % kSize)];
+		return m_blocks.Get(InnerIndex3FromPos(x % kSize, y % kSize, z % kSize));
 	}
+	// Shrink block palette, call only when no other thread can access the chunk (before SetGeneratedFlag)
+	inline void CompactBlocks() {
+		m_blocks.Compact();
+		if (m_blocks.IsUniform() && !m_uniform_counted) {
+			m_uniform_counted = true;
+			s_uniform_count.fetch_add(1, std::memory_order_relaxed);
+		}
+		update_heap_bytes();
+	}
+
+	// Uniform chunk: a single block fills the whole chunk
+	inline bool IsUniform() const { return m_blocks.IsUniform(); }
+	inline Block GetUniformBlock() const { return m_blocks.GetUniform(); }
+	// Number of live compacted chunks that are uniform
+	inline static std::size_t GetUniformChunkCount() { return s_uniform_count.load(std::memory_order_relaxed); }
+	// Heap bytes of the block and light storages of the live chunks, as of their last CompactBlocks() or AssignLights()
+	inline static std::size_t GetHeapBytes() { return s_heap_bytes.load(std::memory_order_relaxed); }
 
 	// Sunlight Getter and Setter
 	inline InnerPos1 GetSunlightHeight(uint32_t idx) const { return m_sunlight_heights[idx]; }
@@ -81,20 +125,78 @@ public:
 		return GetSunlight(x % kSize, y % kSize, z % kSize);
 	}
 
+	// Light Getter and Setter, valid after the initial light propagation (kLight task)
+	using LightStorage = PaletteArray<Light, kSize * kSize * kSize>;
+	inline const LightStorage &GetLightStorage() const { return m_lights; }
+	inline Light GetLight(uint32_t idx) const { return m_lights.Get(idx); }
+	template <typename T> inline Light GetLight(T x, T y, T z) const { return m_lights.Get(InnerIndex3FromPos(x, y, z)); }
+	inline void SetLight(uint32_t idx, Light l) { m_lights.Set(idx, l); }
+	template <typename T> inline void SetLight(T x, T y, T z, Light l) { m_lights.Set(InnerIndex3FromPos(x, y, z), l); }
+	inline void AssignLights(const Light *lights) {
+		m_lights.Assign(lights);
+		update_heap_bytes();
+	}
+	// Shrink light palette and free the retired layouts, call only when no other thread can access the lights
+	inline void CompactLights() {
+		m_lights.Compact();
+		update_heap_bytes();
+	}
+
 	// Creation
-	inline explicit Chunk(const ChunkPos3 &position) : m_position{position} {}
+	// The block and light layouts are allocated from p_buffer_pool if not null, which must outlive the chunk
+	inline explicit Chunk(const ChunkPos3 &position, PaletteBufferPool *p_buffer_pool = nullptr)
+	    : m_position{position}, m_blocks{{}, p_buffer_pool}, m_lights{{}, p_buffer_pool} {}
+	inline ~Chunk() {
+		if (m_uniform_counted)
+			s_uniform_count.fetch_sub(1, std::memory_order_relaxed);
+		s_heap_bytes.fetch_sub(m_heap_bytes, std::memory_order_relaxed);
+	}
 	static inline std::shared_ptr<Chunk> Create(const ChunkPos3 &position) { return std::make_shared<Chunk>(position); }
 
+	inline ChunkLifecycle &GetLifecycle() { return m_lifecycle; }
+	inline const ChunkLifecycle &GetLifecycle() const { return m_lifecycle; }
+
 	// Generated Flag
-	inline void SetGeneratedFlag() { m_generated_flag.store(true, std::memory_order_release); }
+	inline void SetGeneratedFlag() {
+		m_lifecycle.Reach(ChunkStage::kGenerate);
+		m_generated_flag.store(true, std::memory_order_release);
+	}
 	inline bool IsGenerated() const { return m_generated_flag.load(std::memory_order_acquire); }
 
+	// Light Valid Flag
+	inline void SetLightValidFlag() {
+		m_lifecycle.Reach(ChunkStage::kLight);
+		m_light_valid_flag.store(true, std::memory_order_release);
+	}
+	inline bool IsLightValid() const { return m_light_valid_flag.load(std::memory_order_acquire); }
+
+	// Meshed Flag, set once a mesh of the chunk is pushed to the renderer
+	inline void SetMeshedFlag() {
+		m_lifecycle.Reach(ChunkStage::kMesh);
+		m_meshed_flag.store(true, std::memory_order_release);
+	}
+	inline bool IsMeshed() const { return m_meshed_flag.load(std::memory_order_acquire); }
+
 private:
 	const ChunkPos3 m_position{};
 
-	Block m_blocks[kSize * kSize * kSize];
+	BlockStorage m_blocks;
 	InnerPos1 m_sunlight_heights[kSize * kSize]{};
-	std::atomic_bool m_generated_flag{false};
+	LightStorage m_lights;
+	std::atomic_bool m_generated_flag{false}, m_light_valid_flag{false}, m_meshed_flag{false};
+	ChunkLifecycle m_lifecycle;
+
+	bool m_uniform_counted{false};
+	inline static std::atomic_size_t s_uniform_count{0};
+
+	std::size_t m_heap_bytes{0};
+	inline static std::atomic_size_t s_heap_bytes{0};
+	// Only called by the writer of the storages
+	inline void update_heap_bytes() {
+		std::size_t heap_bytes = m_blocks.GetHeapSize() + m_lights.GetHeapSize();
+		s_heap_bytes.fetch_add(heap_bytes - m_heap_bytes, std::memory_order_relaxed);
+		m_heap_bytes = heap_bytes;
+	}
 };
 
 } // namespace hc::client
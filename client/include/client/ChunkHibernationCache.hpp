@@ -0,0 +1,201 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_HIBERNATION_CACHE_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_HIBERNATION_CACHE_HPP
+
+#include <client/BakedChunk.hpp>
+#include <client/Chunk.hpp>
+#include <client/Config.hpp>
+#include <common/Position.hpp>
+
+#include <cinttypes>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace hc::client {
+
+// Encoded blocks and sunlight heights of recently unloaded chunks (see BakedChunk.hpp), so that a chunk loaded again
+// soon after is decoded instead of being read from the database and generated. The least recently unloaded chunks are
+// dropped once the records exceed the capacity. Unloaded chunks are only queued by Hibernate(), the worker threads
+// encode them with EncodePending() between tasks.
+class ChunkHibernationCache {
+public:
+	struct Stats {
+		std::size_t hits, misses, chunks, bytes, pending;
+	};
+
+private:
+	struct Entry {
+		ChunkPos3 position;
+		std::vector<uint8_t> record;
+		std::size_t bytes; // including the list and map nodes
+	};
+	std::list<Entry> m_entries; // most recently unloaded first
+	std::unordered_map<ChunkPos3, std::list<Entry>::iterator> m_entry_map;
+	// the last chunk hibernated at each position until its record is put, a record encoded from an earlier chunk (or
+	// after the chunk is taken back) is discarded
+	struct Pending {
+		std::shared_ptr<Chunk> chunk;
+		uint64_t sequence;
+	};
+	std::unordered_map<ChunkPos3, Pending> m_pending_map;
+	std::deque<std::pair<ChunkPos3, uint64_t>> m_pending_queue; // oldest first
+	uint64_t m_sequence{0};
+	std::size_t m_capacity, m_bytes{0}, m_hits{0}, m_misses{0};
+	mutable std::mutex m_mutex;
+
+	inline void erase_entry(std::list<Entry>::iterator it) {
+		m_bytes -= it->bytes;
+		m_entry_map.erase(it->position);
+		m_entries.erase(it);
+	}
+	inline void erase_pending(const ChunkPos3 &position, uint64_t sequence) {
+		if (auto it = m_pending_map.find(position); it != m_pending_map.end() && it->second.sequence == sequence)
+			m_pending_map.erase(it);
+	}
+	inline void put(const ChunkPos3 &position, std::vector<uint8_t> &&record, std::size_t bytes) {
+		if (auto it = m_entry_map.find(position); it != m_entry_map.end())
+			erase_entry(it->second);
+		if (bytes > m_capacity)
+			return;
+		m_entries.push_front({position, std::move(record), bytes});
+		m_entry_map.emplace(position, m_entries.begin());
+		m_bytes += bytes;
+		if (m_bytes > m_capacity)
+			trim(m_bytes - m_capacity);
+	}
+	inline static std::size_t get_entry_bytes(std::vector<uint8_t> *p_record) {
+		p_record->shrink_to_fit();
+		return sizeof(Entry) + p_record->size() + sizeof(std::pair<ChunkPos3, std::list<Entry>::iterator>) +
+		       4 * sizeof(void *);
+	}
+	inline std::size_t trim(std::size_t bytes) {
+		std::size_t prev_bytes = m_bytes;
+		while (!m_entries.empty() && prev_bytes - m_bytes < bytes)
+			erase_entry(std::prev(m_entries.end()));
+		return prev_bytes - m_bytes;
+	}
+
+public:
+	inline explicit ChunkHibernationCache(std::size_t capacity) : m_capacity{capacity} {}
+
+	// 0 disables the cache
+	inline void SetCapacity(std::size_t capacity) {
+		std::scoped_lock lock{m_mutex};
+		m_capacity = capacity;
+		if (!m_capacity) {
+			m_pending_map.clear();
+			m_pending_queue.clear();
+		}
+		if (m_bytes > m_capacity)
+			trim(m_bytes - m_capacity);
+	}
+	inline std::size_t GetCapacity() const {
+		std::scoped_lock lock{m_mutex};
+		return m_capacity;
+	}
+
+	inline void Put(const ChunkPos3 &position, std::vector<uint8_t> &&record) {
+		std::size_t bytes = get_entry_bytes(&record);
+		std::scoped_lock lock{m_mutex};
+		m_pending_map.erase(position);
+		put(position, std::move(record), bytes);
+	}
+	// Queues an unloaded chunk to be encoded by EncodePending(), returns false if the cache is disabled
+	inline bool Hibernate(std::shared_ptr<Chunk> &&chunk) {
+		std::scoped_lock lock{m_mutex};
+		if (!m_capacity)
+			return false;
+		ChunkPos3 position = chunk->GetPosition();
+		if (auto it = m_entry_map.find(position); it != m_entry_map.end())
+			erase_entry(it->second);
+		m_pending_map[position] = {std::move(chunk), ++m_sequence};
+		m_pending_queue.emplace_back(position, m_sequence);
+		// a queued chunk keeps its whole storage alive, drop the oldest ones if the workers fall behind
+		while (m_pending_queue.size() > kChunkHibernationMaxPending) {
+			erase_pending(m_pending_queue.front().first, m_pending_queue.front().second);
+			m_pending_queue.pop_front();
+		}
+		return true;
+	}
+	// Encodes up to max_count queued chunks, returns the number of chunks encoded
+	inline std::size_t EncodePending(std::size_t max_count) {
+		std::size_t count = 0;
+		while (count < max_count) {
+			std::shared_ptr<Chunk> chunk;
+			uint64_t sequence;
+			{
+				std::scoped_lock lock{m_mutex};
+				if (m_pending_queue.empty())
+					break;
+				auto [position, front_sequence] = m_pending_queue.front();
+				m_pending_queue.pop_front();
+				auto it = m_pending_map.find(position);
+				if (it == m_pending_map.end() || it->second.sequence != front_sequence)
+					continue;
+				chunk = it->second.chunk;
+				sequence = front_sequence;
+			}
+			std::vector<uint8_t> record = EncodeBakedChunk(*chunk);
+			std::size_t bytes = get_entry_bytes(&record);
+			++count;
+
+			std::scoped_lock lock{m_mutex};
+			auto it = m_pending_map.find(chunk->GetPosition());
+			if (it == m_pending_map.end() || it->second.sequence != sequence)
+				continue;
+			m_pending_map.erase(it);
+			put(chunk->GetPosition(), std::move(record), bytes);
+		}
+		return count;
+	}
+	// Removes the record of position and returns it, counted as a hit or a miss. A chunk still queued is encoded here.
+	inline std::optional<std::vector<uint8_t>> Take(const ChunkPos3 &position) {
+		std::shared_ptr<Chunk> chunk;
+		{
+			std::scoped_lock lock{m_mutex};
+			if (auto it = m_pending_map.find(position); it != m_pending_map.end()) {
+				++m_hits;
+				chunk = std::move(it->second.chunk);
+				m_pending_map.erase(it);
+			} else if (auto entry_it = m_entry_map.find(position); entry_it != m_entry_map.end()) {
+				++m_hits;
+				std::vector<uint8_t> record = std::move(entry_it->second->record);
+				erase_entry(entry_it->second);
+				return record;
+			} else {
+				++m_misses;
+				return std::nullopt;
+			}
+		}
+		return EncodeBakedChunk(*chunk);
+	}
+	// Drops the record of position, for a chunk changed while unloaded
+	inline void Erase(const ChunkPos3 &position) {
+		std::scoped_lock lock{m_mutex};
+		m_pending_map.erase(position);
+		if (auto it = m_entry_map.find(position); it != m_entry_map.end())
+			erase_entry(it->second);
+	}
+	// Drops the least recently unloaded records until bytes are freed, returns the bytes freed
+	inline std::size_t Trim(std::size_t bytes) {
+		std::scoped_lock lock{m_mutex};
+		return trim(bytes);
+	}
+
+	inline Stats GetStats() const {
+		std::scoped_lock lock{m_mutex};
+		return {.hits = m_hits,
+		        .misses = m_misses,
+		        .chunks = m_entries.size(),
+		        .bytes = m_bytes,
+		        .pending = m_pending_map.size()};
+	}
+};
+
+} // namespace hc::client
+
+#endif
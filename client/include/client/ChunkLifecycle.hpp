@@ -0,0 +1,83 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_LIFECYCLE_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_LIFECYCLE_HPP
+
+#include <client/LatencyHistogram.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace hc::client {
+
+// Stages of a chunk from being inserted by ChunkPool::Update() to its mesh being visible
+enum class ChunkStage {
+	kInsert,   // inserted by ChunkPool::Update()
+	kLoad,     // chunk entry read from the database
+	kGenerate, // blocks and sunlights generated
+	kLight,    // lights propagated
+	kMesh,     // mesh pushed to the ChunkMeshSink
+	kVisible,  // mesh uploaded to the GPU (or dropped by a NullChunkMeshSink)
+	COUNT
+};
+inline constexpr std::size_t kChunkStageCount = static_cast<std::size_t>(ChunkStage::COUNT);
+const char *GetChunkStageName(ChunkStage stage);
+
+// First times at which a chunk reached each stage
+class ChunkLifecycle {
+private:
+	std::array<std::atomic_int64_t, kChunkStageCount> m_times{}; // steady clock in ns, 0 if not reached
+	std::atomic_bool m_restored{false};
+
+public:
+	inline static int64_t GetNow() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		           std::chrono::steady_clock::now().time_since_epoch())
+		    .count();
+	}
+	// Returns false if the stage was reached before
+	inline bool Reach(ChunkStage stage) {
+		int64_t expected = 0;
+		return m_times[static_cast<std::size_t>(stage)].compare_exchange_strong(expected, GetNow(),
+		                                                                         std::memory_order_relaxed);
+	}
+	inline int64_t GetTime(ChunkStage stage) const {
+		return m_times[static_cast<std::size_t>(stage)].load(std::memory_order_relaxed);
+	}
+	// Loaded from the ChunkHibernationCache instead of the database and the terrain
+	inline void SetRestored() { m_restored.store(true, std::memory_order_relaxed); }
+	inline bool IsRestored() const { return m_restored.load(std::memory_order_relaxed); }
+};
+
+struct ChunkLifecycleStats {
+	// stages[s] holds the durations from stage s - 1 to stage s, stages[kInsert] the whole lifecycle
+	std::array<LatencyHistogram, kChunkStageCount> stages{};
+	// The whole lifecycles of stages[kInsert] split by chunks restored or not
+	LatencyHistogram restored{}, cold{};
+
+	inline const LatencyHistogram &Get(ChunkStage stage) const { return stages[static_cast<std::size_t>(stage)]; }
+	// Chunks visible after earlier
+	ChunkLifecycleStats Since(const ChunkLifecycleStats &earlier) const;
+
+	// One row per stage
+	std::string ToCSV() const;
+	// Includes the histogram buckets
+	std::string ToJSON() const;
+};
+
+// Stage durations of all chunks that became visible
+class ChunkLifecycleRecorder {
+private:
+	std::array<AtomicLatencyHistogram, kChunkStageCount> m_stages{};
+	AtomicLatencyHistogram m_restored{}, m_cold{};
+
+public:
+	// Call once the chunk reaches ChunkStage::kVisible
+	void Add(const ChunkLifecycle &lifecycle);
+	ChunkLifecycleStats GetStats() const;
+};
+
+} // namespace hc::client
+
+#endif
@@ -0,0 +1,53 @@
+#include <client/Chunk.hpp>
+
+#include <client/BlockLightAlgo.hpp>
+#include <client/ChunkNeighbourhood.hpp>
+
+namespace hc::client {
+
+template <> class ChunkTaskRunnerData<ChunkTaskType::kLight> {
+private:
+	std::array<std::shared_ptr<Chunk>, 27> m_chunk_ptr_array;
+
+public:
+	inline static constexpr ChunkTaskType kType = ChunkTaskType::kLight;
+
+	inline ChunkTaskRunnerData(std::array<std::shared_ptr<Chunk>, 27> &&chunk_ptr_array)
+	    : m_chunk_ptr_array{std::move(chunk_ptr_array)} {}
+	inline const ChunkPos3 &GetChunkPos() const { return m_chunk_ptr_array[26]->GetPosition(); }
+	inline const std::shared_ptr<Chunk> &GetChunkPtr() const { return m_chunk_ptr_array[26]; }
+	inline const auto &GetChunkPtrArray() const { return m_chunk_ptr_array; }
+};
+
+// Initial light propagation of a generated chunk, later changes are applied incrementally by kSetBlock and
+// kSetSunlight
+template <> class ChunkTaskData<ChunkTaskType::kLight> final : public ChunkTaskDataBase<ChunkTaskType::kLight> {
+private:
+	bool m_queued{false};
+
+public:
+	inline static constexpr ChunkTaskType kType = ChunkTaskType::kLight;
+
+	inline void Push() { m_queued = true; }
+	inline constexpr ChunkTaskPriority GetPriority() const { return ChunkTaskPriority::kLow; }
+	inline bool IsQueued() const { return m_queued; }
+	std::optional<ChunkTaskRunnerData<ChunkTaskType::kLight>> Pop(const ChunkTaskPoolLocked &task_pool,
+	                                                              const ChunkPos3 &chunk_pos);
+	inline void OnUnload() { m_queued = false; }
+};
+
+template <> class ChunkTaskRunner<ChunkTaskType::kLight> {
+private:
+	using LightAlgo = BlockLightAlgo<
+	    BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{0, 0, 0, kChunkSize, kChunkSize, kChunkSize}>, 15>;
+	LightAlgo::Queue m_sunlight_entries, m_torchlight_entries;
+	ChunkNeighbourhood<15> m_neighbourhood;
+	std::unique_ptr<block::Light[]> m_chunk_lights{new block::Light[kChunkSize * kChunkSize * kChunkSize]};
+
+public:
+	inline static constexpr ChunkTaskType kType = ChunkTaskType::kLight;
+
+	void Run(ChunkTaskPool *p_task_pool, ChunkTaskRunnerData<ChunkTaskType::kLight> &&data);
+};
+
+} // namespace hc::client
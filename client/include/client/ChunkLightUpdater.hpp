@@ -0,0 +1,194 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_LIGHT_UPDATER_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_LIGHT_UPDATER_HPP
+
+#include <block/Block.hpp>
+#include <client/BlockLightAlgo.hpp>
+#include <client/Chunk.hpp>
+
+#include <array>
+#include <bitset>
+#include <memory>
+
+namespace hc::client {
+
+// Blocks read by a chunk mesh lie within [-kChunkMeshReach, kChunkSize + kChunkMeshReach) (custom meshes and AO on the
+// border)
+inline constexpr InnerPos1 kChunkMeshReach = 3;
+
+// Incremental updates of the persistent chunk light volumes around a center chunk. Changes are seeded in positions
+// relative to the center chunk, then Propagate() removes the outdated lights and refills them. Missing chunks and
+// chunks whose lights are not initialized yet act as opaque walls and are never written.
+class ChunkLightUpdater {
+private:
+	using LightAlgo = BlockLightAlgo<BlockAlgoConfig<
+	    InnerPos1, BlockAlgoBound<InnerPos1>{-(InnerPos1)kChunkSize, -(InnerPos1)kChunkSize, -(InnerPos1)kChunkSize,
+	                                         2 * (InnerPos1)kChunkSize, 2 * (InnerPos1)kChunkSize,
+	                                         2 * (InnerPos1)kChunkSize}>>;
+
+	std::array<Chunk *, 27> m_chunks{};
+	LightAlgo::Queue m_sunlight_remove_entries, m_sunlight_add_entries, m_torchlight_remove_entries,
+	    m_torchlight_add_entries;
+	std::bitset<27> m_remesh_set, m_written_set;
+
+	inline Chunk *get_chunk(InnerPos1 x, InnerPos1 y, InnerPos1 z) const {
+		return m_chunks[GetBlockChunkNeighbourIndex(x, y, z)];
+	}
+	inline static uint32_t get_inner_index(InnerPos1 x, InnerPos1 y, InnerPos1 z) {
+		constexpr InnerPos1 kSize = kChunkSize;
+		return InnerIndex3FromPos((x + kSize) % kSize, (y + kSize) % kSize, (z + kSize) % kSize);
+	}
+	inline block::Light get_light(InnerPos1 x, InnerPos1 y, InnerPos1 z) const {
+		const Chunk *chunk = get_chunk(x, y, z);
+		return chunk ? chunk->GetLight(get_inner_index(x, y, z)) : block::Light{};
+	}
+	inline block::Block get_block(InnerPos1 x, InnerPos1 y, InnerPos1 z) const {
+		const Chunk *chunk = get_chunk(x, y, z);
+		return chunk ? chunk->GetBlock(get_inner_index(x, y, z)) : block::Block{block::Blocks::kStone};
+	}
+	inline block::LightLvl get_sunlight_source(InnerPos1 x, InnerPos1 y, InnerPos1 z) const {
+		constexpr InnerPos1 kSize = kChunkSize;
+		const Chunk *chunk = get_chunk(x, y, z);
+		return chunk->GetSunlight((x + kSize) % kSize, (y + kSize) % kSize, (z + kSize) % kSize) ? 15 : 0;
+	}
+	// Mark the chunks whose meshes read the block or light at (x, y, z)
+	inline void mark_remesh(InnerPos1 x, InnerPos1 y, InnerPos1 z) {
+		const auto get_cmps = [](InnerPos1 v, InnerPos1 *cmps) -> uint32_t {
+			constexpr InnerPos1 kSize = kChunkSize;
+			InnerPos1 cmp = v < 0 ? -1 : (v >= kSize ? 1 : 0), r = InnerPos1(v - cmp * kSize);
+			uint32_t count = 0;
+			cmps[count++] = cmp;
+			if (cmp > -1 && r < kChunkMeshReach)
+				cmps[count++] = InnerPos1(cmp - 1);
+			if (cmp < 1 && r >= kSize - kChunkMeshReach)
+				cmps[count++] = InnerPos1(cmp + 1);
+			return count;
+		};
+		InnerPos1 cmp_x[2], cmp_y[2], cmp_z[2];
+		uint32_t count_x = get_cmps(x, cmp_x), count_y = get_cmps(y, cmp_y), count_z = get_cmps(z, cmp_z);
+		for (uint32_t i = 0; i < count_x; ++i)
+			for (uint32_t j = 0; j < count_y; ++j)
+				for (uint32_t k = 0; k < count_z; ++k)
+					m_remesh_set[CmpXYZ2NeighbourIndex(cmp_x[i], cmp_y[j], cmp_z[k])] = true;
+	}
+
+	template <block::LightType Type> inline void set_light(InnerPos1 x, InnerPos1 y, InnerPos1 z, block::LightLvl lvl) {
+		Chunk *chunk = get_chunk(x, y, z);
+		uint32_t idx = get_inner_index(x, y, z);
+		block::Light light = chunk->GetLight(idx);
+		if constexpr (Type == block::LightType::kSunlight)
+			light.SetSunlight(lvl);
+		else
+			light.SetTorchlight(lvl);
+		chunk->SetLight(idx, light);
+		m_written_set[GetBlockChunkNeighbourIndex(x, y, z)] = true;
+		mark_remesh(x, y, z);
+	}
+
+	template <block::LightType Type>
+	inline void seed(InnerPos3 pos, block::LightLvl source, LightAlgo::Queue *p_remove_entries,
+	                 LightAlgo::Queue *p_add_entries) {
+		block::Light light = get_light(pos.x, pos.y, pos.z);
+		block::LightLvl lvl = Type == block::LightType::kSunlight ? light.GetSunlight() : light.GetTorchlight();
+		set_light<Type>(pos.x, pos.y, pos.z, source);
+		if (lvl)
+			p_remove_entries->push({pos, lvl});
+		if (source)
+			p_add_entries->push({pos, source});
+	}
+	// Removals may clear lights queued for propagation before, only keep entries still matching the lights
+	template <typename GetLightFunc> inline static void drop_outdated(LightAlgo::Queue *p_entries, GetLightFunc &&get_light) {
+		for (std::size_t i = p_entries->size(); i; --i) {
+			LightAlgo::Entry e = p_entries->front();
+			p_entries->pop();
+			if (get_light(e.pos.x, e.pos.y, e.pos.z) == e.lvl)
+				p_entries->push(e);
+		}
+	}
+	// Lights around pos may flow in after pos becomes passable
+	inline void seed_neighbours(InnerPos3 pos) {
+		for (block::BlockFace f = 0; f < 6; ++f) {
+			InnerPos3 nei_pos = block::BlockFaceProceed(pos, f);
+			block::Light light = get_light(nei_pos.x, nei_pos.y, nei_pos.z);
+			if (light.GetSunlight())
+				m_sunlight_add_entries.push({nei_pos, light.GetSunlight()});
+			if (light.GetTorchlight())
+				m_torchlight_add_entries.push({nei_pos, light.GetTorchlight()});
+		}
+	}
+
+public:
+	// chunks are indexed by Chunk::CmpXYZ2NeighbourIndex and may be null
+	inline void Reset(const std::array<std::shared_ptr<Chunk>, 27> &chunks) {
+		for (uint32_t i = 0; i < 27; ++i)
+			m_chunks[i] = chunks[i] && chunks[i]->IsLightValid() ? chunks[i].get() : nullptr;
+		m_remesh_set.reset();
+		m_written_set.reset();
+	}
+	inline bool IsCenterValid() const { return m_chunks[26]; }
+
+	// Call after the block at pos (inside the center chunk) is changed from old_block to new_block
+	inline void OnBlockChange(InnerPos3 pos, block::Block old_block, block::Block new_block) {
+		mark_remesh(pos.x, pos.y, pos.z);
+		if (!IsCenterValid())
+			return;
+		bool old_pass = old_block.GetIndirectLightPass(), new_pass = new_block.GetIndirectLightPass();
+		if (old_pass != new_pass)
+			seed<block::LightType::kSunlight>(pos, get_sunlight_source(pos.x, pos.y, pos.z),
+			                                  &m_sunlight_remove_entries, &m_sunlight_add_entries);
+		if (old_pass != new_pass || old_block.GetLightLevel() != new_block.GetLightLevel())
+			seed<block::LightType::kTorchlight>(pos, new_block.GetLightLevel(), &m_torchlight_remove_entries,
+			                                    &m_torchlight_add_entries);
+		if (new_pass && !old_pass)
+			seed_neighbours(pos);
+	}
+	// Call after the sunlight height at (x, z) of the center chunk is changed from old_height to new_height
+	inline void OnSunlightHeightChange(InnerPos1 x, InnerPos1 z, InnerPos1 old_height, InnerPos1 new_height) {
+		if (!IsCenterValid())
+			return;
+		InnerPos1 begin = std::max(std::min(old_height, new_height), InnerPos1(0)),
+		          end = std::min(std::max(old_height, new_height), (InnerPos1)kChunkSize);
+		block::LightLvl source = new_height < old_height ? 15 : 0;
+		for (InnerPos1 y = begin; y < end; ++y)
+			seed<block::LightType::kSunlight>({x, y, z}, source, &m_sunlight_remove_entries, &m_sunlight_add_entries);
+	}
+
+	inline void Propagate() {
+		LightAlgo algo{};
+		const auto get_block_func = [this](InnerPos1 x, InnerPos1 y, InnerPos1 z) { return get_block(x, y, z); };
+		const auto get_sunlight = [this](InnerPos1 x, InnerPos1 y, InnerPos1 z) {
+			return get_light(x, y, z).GetSunlight();
+		};
+		const auto get_torchlight = [this](InnerPos1 x, InnerPos1 y, InnerPos1 z) {
+			return get_light(x, y, z).GetTorchlight();
+		};
+		const auto set_sunlight = [this](InnerPos1 x, InnerPos1 y, InnerPos1 z, block::LightLvl lvl) {
+			set_light<block::LightType::kSunlight>(x, y, z, lvl);
+		};
+		const auto set_torchlight = [this](InnerPos1 x, InnerPos1 y, InnerPos1 z, block::LightLvl lvl) {
+			set_light<block::LightType::kTorchlight>(x, y, z, lvl);
+		};
+
+		algo.RemoveLight(&m_sunlight_remove_entries, &m_sunlight_add_entries, get_sunlight, set_sunlight,
+		                 [this](InnerPos1 x, InnerPos1 y, InnerPos1 z) { return get_sunlight_source(x, y, z); });
+		drop_outdated(&m_sunlight_add_entries, get_sunlight);
+		algo.PropagateLight(&m_sunlight_add_entries, get_block_func, get_sunlight, set_sunlight);
+
+		algo.RemoveLight(&m_torchlight_remove_entries, &m_torchlight_add_entries, get_torchlight, set_torchlight,
+		                 [this](InnerPos1 x, InnerPos1 y, InnerPos1 z) { return get_block(x, y, z).GetLightLevel(); });
+		drop_outdated(&m_torchlight_add_entries, get_torchlight);
+		algo.PropagateLight(&m_torchlight_add_entries, get_block_func, get_torchlight, set_torchlight);
+	}
+
+	// Chunks (by neighbour index) whose meshes are affected by the changes
+	inline const std::bitset<27> &GetRemeshSet() const { return m_remesh_set; }
+	// Compact the light volumes written by Propagate(), the task must keep their other readers and writers out
+	inline void CompactLights() {
+		for (uint32_t i = 0; i < 27; ++i)
+			if (m_written_set[i])
+				m_chunks[i]->CompactLights();
+	}
+};
+
+} // namespace hc::client
+
+#endif
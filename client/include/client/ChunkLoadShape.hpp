@@ -0,0 +1,69 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_LOAD_SHAPE_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_LOAD_SHAPE_HPP
+
+#include <common/Position.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+
+namespace hc::client {
+
+// Chunks around the center chunk within a horizontal radius and a vertical radius. The shape is a union of y columns:
+// the column (x, z) of half height h holds the chunks with y in [-h, h].
+struct ChunkLoadShape {
+	enum class Type : uint8_t { kEllipsoid, kCylinder };
+
+	Type type{Type::kEllipsoid};
+	ChunkPos1 radius{}, height{}; // horizontal and vertical radii, at least 1
+
+	inline bool operator==(const ChunkLoadShape &r) const {
+		return type == r.type && radius == r.radius && height == r.height;
+	}
+
+	// The shape grown by dist chunks in every direction
+	inline ChunkLoadShape Grow(ChunkPos1 dist) const {
+		return {type, ChunkPos1(radius + dist), ChunkPos1(height + dist)};
+	}
+	// The shape shrunk by dist chunks, each radius stops at min_radius (or stays if already smaller)
+	inline ChunkLoadShape Shrink(ChunkPos1 dist, ChunkPos1 min_radius) const {
+		const auto shrink = [dist, min_radius](ChunkPos1 r) {
+			return ChunkPos1(std::max<int32_t>(r - dist, std::min(r, min_radius)));
+		};
+		return {type, shrink(radius), shrink(height)};
+	}
+	// Distance in blocks from anywhere in the center chunk to the farthest block of the shape, for the far plane
+	inline float GetFarDistance() const {
+		float r = float(radius + 1), h = float(height + 1);
+		return std::sqrt(r * r + h * h) * float(kChunkSize);
+	}
+	// -1 if the column is outside, a shape with a negative radius is empty
+	inline int32_t GetHalfHeight(int32_t x, int32_t z) const {
+		int32_t r2 = int32_t(radius) * radius, rem = r2 - x * x - z * z;
+		if (radius < 0 || height < 0 || rem < 0)
+			return -1;
+		if (type == Type::kCylinder || rem == r2)
+			return height;
+		// y^2 / height^2 + (x^2 + z^2) / radius^2 <= 1
+		int32_t max_y2 = int32_t(height) * height * rem / r2;
+		auto h = (int32_t)std::sqrt((float)max_y2);
+		while ((h + 1) * (h + 1) <= max_y2)
+			++h;
+		while (h * h > max_y2)
+			--h;
+		return h;
+	}
+	inline bool Contains(const ChunkPos3 &rel_pos) const {
+		return std::abs(int32_t(rel_pos.y)) <= GetHalfHeight(rel_pos.x, rel_pos.z);
+	}
+	// Squared distance from the center to the farthest chunk inside
+	inline uint32_t GetMaxDist2() const {
+		return type == Type::kCylinder ? uint32_t(radius * radius + height * height)
+		                               : uint32_t(std::max(radius, height) * std::max(radius, height));
+	}
+};
+
+} // namespace hc::client
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_MESH_SINK_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_MESH_SINK_HPP
+
+#include <client/BlockVertex.hpp>
+#include <common/Position.hpp>
+
+#include <vector>
+
+namespace hc::client {
+
+// Receives the meshes produced by the chunk mesh tasks of a World, WorldRenderer uploads them to the GPU
+class ChunkMeshSink {
+public:
+	virtual ~ChunkMeshSink() = default;
+	virtual void PushChunkMesh(const ChunkPos3 &chunk_pos, std::vector<BlockMesh> &&meshes) = 0;
+	// Called on each world update to drop the meshes outside the unload shape
+	virtual void EraseUnloadedMeshes() = 0;
+	// Approximate bytes held for the meshes
+	inline virtual std::size_t GetMeshBytes() const { return 0; }
+};
+
+} // namespace hc::client
+
+#endif
@@ -1,19 +1,12 @@
 #include <client/Chunk.hpp>
 
-#include <client/BlockLightAlgo.hpp>
+#include <client/ChunkLightUpdater.hpp>
+#include <client/ChunkNeighbourhood.hpp>
 
 namespace hc::client {
 
 class WorldRenderer;
 
-inline constexpr bool ChunkShouldRemesh(InnerPos3 relative_block_pos) {
-	using LightAlgo = BlockLightAlgo<
-	    BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{-1, -1, -1, (InnerPos1)kChunkSize + 1,
-	                                                         (InnerPos1)kChunkSize + 1, (InnerPos1)kChunkSize + 1}>,
-	    14>;
-	return LightAlgo::IsBorderLightInterfere(relative_block_pos.x, relative_block_pos.y, relative_block_pos.z, 15);
-}
-
 template <> class ChunkTaskRunnerData<ChunkTaskType::kMesh> {
 private:
 	std::array<std::shared_ptr<Chunk>, 27> m_chunk_ptr_array;
@@ -50,12 +43,7 @@ public:
 
 template <> class ChunkTaskRunner<ChunkTaskType::kMesh> {
 private:
-	using LightAlgo = BlockLightAlgo<
-	    BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{-1, -1, -1, (InnerPos1)kChunkSize + 1,
-	                                                         (InnerPos1)kChunkSize + 1, (InnerPos1)kChunkSize + 1}>,
-	    14>;
-	LightAlgo::Queue m_sunlight_entries, m_torchlight_entries;
-	block::Light m_extend_light_buffer[(kChunkSize + 30) * (kChunkSize + 30) * (kChunkSize + 30)]{};
+	ChunkNeighbourhood<kChunkMeshReach> m_neighbourhood;
 
 public:
 	inline static constexpr ChunkTaskType kType = ChunkTaskType::kMesh;
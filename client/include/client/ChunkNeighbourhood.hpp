@@ -0,0 +1,98 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_NEIGHBOURHOOD_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_NEIGHBOURHOOD_HPP
+
+#include <client/Chunk.hpp>
+
+#include <array>
+#include <memory>
+
+namespace hc::client {
+
+// Contiguous copy of a chunk and a Border-wide shell of its 26 neighbours, gathered once per task with row copies.
+// Blocks (and optionally lights) at x, y, z in [-Border, kChunkSize + Border) are read with plain strided
+// indexing, laid out like InnerIndex3 (x fastest, then z, then y).
+template <uint32_t Border> class ChunkNeighbourhood {
+	static_assert(Border <= kChunkSize);
+
+public:
+	inline static constexpr int32_t kBorder = Border, kMin = -kBorder, kMax = (int32_t)kChunkSize + kBorder;
+	inline static constexpr uint32_t kSpan = kChunkSize + 2 * Border, kVolume = kSpan * kSpan * kSpan;
+
+	template <std::integral T> inline static constexpr uint32_t GetIndex(T x, T y, T z) {
+		return uint32_t(x + kBorder) + (uint32_t(z + kBorder) + uint32_t(y + kBorder) * kSpan) * kSpan;
+	}
+
+private:
+	using ChunkArray = std::array<std::shared_ptr<Chunk>, 27>;
+
+	std::unique_ptr<block::Block[]> m_blocks{new block::Block[kVolume]};
+	std::unique_ptr<block::Light[]> m_lights;
+
+	// Call func(chunk, inner_x, inner_y, inner_z, length, index) for each x-row segment lying in a single chunk
+	template <typename Func> inline static void for_each_segment(const ChunkArray &chunks, Func &&func) {
+		constexpr int32_t kSegmentBegins[3] = {kMin, 0, (int32_t)kChunkSize},
+		                  kSegmentEnds[3] = {0, (int32_t)kChunkSize, kMax};
+		for (int32_t y = kMin; y < kMax; ++y) {
+			int32_t cmp_y = y < 0 ? -1 : (y >= (int32_t)kChunkSize ? 1 : 0);
+			int32_t inner_y = (y + (int32_t)kChunkSize) % (int32_t)kChunkSize;
+			for (int32_t z = kMin; z < kMax; ++z) {
+				int32_t cmp_z = z < 0 ? -1 : (z >= (int32_t)kChunkSize ? 1 : 0);
+				int32_t inner_z = (z + (int32_t)kChunkSize) % (int32_t)kChunkSize;
+				for (uint32_t s = 0; s < 3; ++s) {
+					int32_t begin = kSegmentBegins[s], end = kSegmentEnds[s];
+					if (begin == end)
+						continue;
+					const Chunk &chunk = *chunks[CmpXYZ2NeighbourIndex((int32_t)s - 1, cmp_y, cmp_z)];
+					func(chunk, (begin + (int32_t)kChunkSize) % (int32_t)kChunkSize, inner_y, inner_z,
+					     uint32_t(end - begin), GetIndex(begin, y, z));
+				}
+			}
+		}
+	}
+
+public:
+	// chunks are indexed by Chunk::CmpXYZ2NeighbourIndex
+	inline void GatherBlocks(const ChunkArray &chunks) {
+		for_each_segment(chunks, [this](const Chunk &chunk, int32_t x, int32_t y, int32_t z, uint32_t length,
+		                                uint32_t index) {
+			chunk.GetBlockStorage().Copy(InnerIndex3FromPos(x, y, z), length, m_blocks.get() + index);
+		});
+	}
+	// Initial lights before propagation: sunlight from chunk sunlight heights, torchlight from light-emitting blocks.
+	// Requires GatherBlocks first.
+	inline void GatherInitialLights(const ChunkArray &chunks) {
+		if (!m_lights)
+			m_lights.reset(new block::Light[kVolume]);
+		for_each_segment(chunks, [this](const Chunk &chunk, int32_t x, int32_t y, int32_t z, uint32_t length,
+		                                uint32_t index) {
+			for (uint32_t i = 0; i < length; ++i)
+				m_lights[index + i] = block::Light{block::LightLvl(chunk.GetSunlight(x + (int32_t)i, y, z) ? 15 : 0),
+				                                   m_blocks[index + i].GetLightLevel()};
+		});
+	}
+
+	// Propagated lights from the chunks' light volumes, which must be valid (Chunk::IsLightValid)
+	inline void GatherLights(const ChunkArray &chunks) {
+		if (!m_lights)
+			m_lights.reset(new block::Light[kVolume]);
+		for_each_segment(chunks, [this](const Chunk &chunk, int32_t x, int32_t y, int32_t z, uint32_t length,
+		                                uint32_t index) {
+			chunk.GetLightStorage().Copy(InnerIndex3FromPos(x, y, z), length, m_lights.get() + index);
+		});
+	}
+
+	template <std::integral T> inline block::Block GetBlock(T x, T y, T z) const {
+		return m_blocks[GetIndex(x, y, z)];
+	}
+	template <std::integral T> inline block::Light GetLight(T x, T y, T z) const {
+		return m_lights[GetIndex(x, y, z)];
+	}
+	template <std::integral T> inline block::Light &GetLightRef(T x, T y, T z) { return m_lights[GetIndex(x, y, z)]; }
+	inline const block::Block *GetBlockData() const { return m_blocks.get(); }
+	inline block::Light *GetLightData() { return m_lights.get(); }
+	inline const block::Light *GetLightData() const { return m_lights.get(); }
+};
+
+} // namespace hc::client
+
+#endif
@@ -1,23 +1,128 @@
 #pragma once
 
 #include <client/Chunk.hpp>
+#include <client/ChunkHibernationCache.hpp>
+#include <client/ChunkLoadShape.hpp>
+#include <client/ChunkRingMap.hpp>
+#include <client/ChunkSlabPool.hpp>
+#include <client/Config.hpp>
 #include <cuckoohash_map.hh>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace hc::client {
 
 class World;
 
+enum class ChunkPoolStorage {
+	kHashMap, // cuckoo hash map, for any radius
+	kRingMap  // toroidal array with cheaper lookups, rebuilt larger when the shapes outgrow it
+};
+
 class ChunkPool {
 private:
 	World &m_world;
 	libcuckoo::cuckoohash_map<ChunkPos3, std::shared_ptr<Chunk>> m_chunks;
+	using RingMap = ChunkRingMap<std::shared_ptr<Chunk>>;
+	// Replaces m_chunks if not null. When the shapes outgrow it, Update() moves the chunks to a larger ring map. The
+	// earlier ones are kept empty since other threads may still be looking up chunks in them.
+	std::atomic<RingMap *> m_ring_chunks{nullptr};
+	std::vector<std::unique_ptr<RingMap>> m_ring_chunk_maps;
+	std::atomic_size_t m_ring_chunks_heap_size{0}; // of all the ring maps
+	std::shared_ptr<ChunkSlabPool> m_slab_pool;
+	ChunkHibernationCache m_hibernation{kChunkHibernationCapacity};
+
+	// Half heights of the columns of a shape, see ChunkLoadShape
+	struct ShapeColumns {
+		int32_t extent{-1};
+		std::vector<int32_t> half_heights; // -1 for the columns outside
+		inline int32_t Get(int32_t x, int32_t z) const {
+			return std::abs(x) > extent || std::abs(z) > extent
+			           ? -1
+			           : half_heights[(z + extent) * (2 * extent + 1) + (x + extent)];
+		}
+	};
+	// Chunks loaded around the center, and chunks kept until they leave the unload shape, none above max_y
+	struct Shape {
+		ChunkPos3 center;
+		ChunkLoadShape load_shape, unload_shape;
+		ChunkPos1 max_y;
+		ShapeColumns load_columns, keep_columns;
+	};
+	// Shape of the previous Update, only the chunks in the difference with the current one are loaded or unloaded
+	std::optional<Shape> m_prev_shape;
+	std::mutex m_update_mutex;
+
+	inline RingMap *get_ring_chunks() const { return m_ring_chunks.load(std::memory_order_acquire); }
+	// Called by Update() only
+	void grow_ring_chunks(uint32_t extent_xz, uint32_t extent_y);
+
+	inline bool contains_chunk(const ChunkPos3 &position) const {
+		RingMap *p_ring_chunks = get_ring_chunks();
+		return p_ring_chunks ? p_ring_chunks->Contains(position) : m_chunks.contains(position);
+	}
+	inline bool insert_chunk(const ChunkPos3 &position, std::shared_ptr<Chunk> &&chunk) {
+		RingMap *p_ring_chunks = get_ring_chunks();
+		return p_ring_chunks ? p_ring_chunks->Insert(position, std::move(chunk))
+		                     : m_chunks.insert(position, std::move(chunk));
+	}
+	inline void erase_chunk(const ChunkPos3 &position) {
+		if (RingMap *p_ring_chunks = get_ring_chunks())
+			p_ring_chunks->Erase(position);
+		else
+			m_chunks.erase(position);
+	}
 
 public:
-	inline explicit ChunkPool(World *p_world) : m_world{*p_world} {}
+	inline ChunkPool(World *p_world, ChunkPoolStorage storage, const ChunkLoadShape &load_shape,
+	                 const ChunkLoadShape &unload_shape)
+	    : m_world{*p_world},
+	      m_slab_pool{ChunkSlabPool::Create(kChunkSlabPoolCapacity, kChunkPaletteBufferCapacity)} {
+		// The load shape grows by a chunk, see Update()
+		if (storage == ChunkPoolStorage::kRingMap) {
+			m_ring_chunk_maps.push_back(
+			    std::make_unique<RingMap>(2 * std::max(load_shape.radius + 1, (int)unload_shape.radius) + 1,
+			                              2 * std::max(load_shape.height + 1, (int)unload_shape.height) + 1));
+			m_ring_chunks_heap_size.store(m_ring_chunk_maps.back()->GetHeapSize(), std::memory_order_relaxed);
+			m_ring_chunks.store(m_ring_chunk_maps.back().get(), std::memory_order_release);
+		}
+	}
 	void Update();
+	inline ChunkPoolStorage GetStorage() const {
+		return get_ring_chunks() ? ChunkPoolStorage::kRingMap : ChunkPoolStorage::kHashMap;
+	}
+	// Extents of the ring map, or 0 for the hash map
+	inline std::pair<uint32_t, uint32_t> GetRingMapExtents() const {
+		RingMap *p_ring_chunks = get_ring_chunks();
+		return p_ring_chunks ? std::pair{p_ring_chunks->GetExtentXZ(), p_ring_chunks->GetExtentY()}
+		                     : std::pair{0u, 0u};
+	}
+	inline const std::shared_ptr<ChunkSlabPool> &GetSlabPool() const { return m_slab_pool; }
+	inline ChunkHibernationCache &GetHibernationCache() { return m_hibernation; }
+	inline const ChunkHibernationCache &GetHibernationCache() const { return m_hibernation; }
+	// Bytes of the chunk storage and of the chunks allocated by the pool, including the chunks still referenced after
+	// being unloaded. The heap of the chunks is counted over all pools, see Chunk::GetHeapBytes().
+	inline std::size_t GetMemoryBytes() const {
+		std::size_t storage_bytes =
+		    get_ring_chunks() ? m_ring_chunks_heap_size.load(std::memory_order_relaxed)
+		                      : m_chunks.capacity() * sizeof(std::pair<ChunkPos3, std::shared_ptr<Chunk>>);
+		// slabs are kept once allocated, so the free slots count as well as the chunks beyond the slab capacity, and
+		// so do the palette buffers kept for the next chunks
+		ChunkSlabPool::Stats slab_stats = m_slab_pool->GetStats();
+		return storage_bytes + std::max(slab_stats.slots, slab_stats.in_use) * ChunkSlabPool::GetSlotSize() +
+		       slab_stats.palette_buffers.bytes + Chunk::GetHeapBytes();
+	}
 	inline std::shared_ptr<Chunk> FindRawChunk(const ChunkPos3 &position) const {
 		std::shared_ptr<Chunk> ret = nullptr;
-		m_chunks.find_fn(position, [&ret](const auto &data) { ret = data; });
+		const auto func = [&ret](const auto &data) { ret = data; };
+		if (RingMap *p_ring_chunks = get_ring_chunks())
+			p_ring_chunks->FindFn(position, func);
+		else
+			m_chunks.find_fn(position, func);
 		return ret;
 	}
 	inline std::shared_ptr<Chunk> FindChunk(const ChunkPos3 &position) const {
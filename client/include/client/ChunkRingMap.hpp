@@ -0,0 +1,121 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_RING_MAP_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_RING_MAP_HPP
+
+#include <common/Position.hpp>
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace hc::client {
+
+// Toroidal array indexed by chunk positions modulo power of two extents, one for x and z and one for y. Positions
+// inside a box smaller than the extents never share a slot, so the loaded chunks around a center fit without probing.
+// Each slot is guarded by a spin lock and tagged with the position it holds.
+template <typename T> class ChunkRingMap {
+private:
+	struct Slot {
+		std::atomic_flag lock;
+		bool occupied{false};
+		ChunkPos3 position{};
+		T value{};
+	};
+	class SlotLock {
+	private:
+		Slot &m_slot;
+
+	public:
+		inline explicit SlotLock(Slot &slot) : m_slot{slot} {
+			while (m_slot.lock.test_and_set(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+		inline ~SlotLock() { m_slot.lock.clear(std::memory_order_release); }
+	};
+
+	uint32_t m_xz_bits, m_y_bits, m_xz_mask, m_y_mask;
+	std::unique_ptr<Slot[]> m_slots;
+
+	inline std::size_t get_slot_count() const { return std::size_t{1} << (2 * m_xz_bits + m_y_bits); }
+	inline Slot &get_slot(const ChunkPos3 &position) const {
+		uint32_t x = uint32_t(position.x) & m_xz_mask, y = uint32_t(position.y) & m_y_mask;
+		uint32_t z = uint32_t(position.z) & m_xz_mask;
+		return m_slots[(((y << m_xz_bits) | z) << m_xz_bits) | x];
+	}
+
+public:
+	// Holds the positions inside any box of min_extent_xz by min_extent_y by min_extent_xz chunks
+	inline ChunkRingMap(uint32_t min_extent_xz, uint32_t min_extent_y)
+	    : m_xz_bits{(uint32_t)std::countr_zero(std::bit_ceil(min_extent_xz))},
+	      m_y_bits{(uint32_t)std::countr_zero(std::bit_ceil(min_extent_y))}, m_xz_mask{(1u << m_xz_bits) - 1u},
+	      m_y_mask{(1u << m_y_bits) - 1u},
+	      m_slots{std::make_unique<Slot[]>(get_slot_count())} {}
+
+	inline uint32_t GetExtentXZ() const { return 1u << m_xz_bits; }
+	inline uint32_t GetExtentY() const { return 1u << m_y_bits; }
+	inline std::size_t GetHeapSize() const { return get_slot_count() * sizeof(Slot); }
+	// Whether the positions inside any box of extent_xz by extent_y by extent_xz chunks fit
+	inline bool Holds(uint32_t extent_xz, uint32_t extent_y) const {
+		return extent_xz <= GetExtentXZ() && extent_y <= GetExtentY();
+	}
+
+	// Calls func with the value at position, returns false if there is none
+	template <typename Func> inline bool FindFn(const ChunkPos3 &position, Func &&func) const {
+		Slot &slot = get_slot(position);
+		SlotLock lock{slot};
+		if (!slot.occupied || slot.position != position)
+			return false;
+		func(slot.value);
+		return true;
+	}
+	inline bool Contains(const ChunkPos3 &position) const {
+		return FindFn(position, [](const T &) {});
+	}
+	// Returns false if the slot holds a value, of position or of another position sharing it
+	inline bool Insert(const ChunkPos3 &position, T &&value) {
+		Slot &slot = get_slot(position);
+		SlotLock lock{slot};
+		if (slot.occupied)
+			return false;
+		slot.occupied = true;
+		slot.position = position;
+		slot.value = std::move(value);
+		return true;
+	}
+	// Calls func with each position and value held, slot by slot
+	template <typename Func> inline void ForEachFn(Func &&func) const {
+		for (std::size_t i = 0; i < get_slot_count(); ++i) {
+			Slot &slot = m_slots[i];
+			SlotLock lock{slot};
+			if (slot.occupied)
+				func(slot.position, slot.value);
+		}
+	}
+	inline bool Erase(const ChunkPos3 &position) {
+		Slot &slot = get_slot(position);
+		T value{};
+		{
+			SlotLock lock{slot};
+			if (!slot.occupied || slot.position != position)
+				return false;
+			slot.occupied = false;
+			// Destroyed after unlocking
+			value = std::exchange(slot.value, T{});
+		}
+		return true;
+	}
+	inline void Clear() {
+		for (std::size_t i = 0; i < get_slot_count(); ++i) {
+			Slot &slot = m_slots[i];
+			T value{}; // destroyed after unlocking
+			SlotLock lock{slot};
+			slot.occupied = false;
+			value = std::exchange(slot.value, T{});
+		}
+	}
+};
+
+} // namespace hc::client
+
+#endif
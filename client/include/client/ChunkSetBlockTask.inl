@@ -1,4 +1,5 @@
 #include <client/Chunk.hpp>
+#include <client/ChunkLightUpdater.hpp>
 #include <client/ChunkUpdate.hpp>
 
 #include <common/Data.hpp>
@@ -36,24 +37,29 @@ public:
 
 template <> class ChunkTaskRunnerData<ChunkTaskType::kSetBlock> {
 private:
-	std::shared_ptr<Chunk> m_chunk_ptr;
+	std::array<std::shared_ptr<Chunk>, 27> m_chunk_ptr_array;
 	std::unordered_map<InnerIndex3, ChunkUpdate<block::Block>> m_set_block_map;
 
 public:
 	inline static constexpr ChunkTaskType kType = ChunkTaskType::kSetBlock;
-	inline ChunkTaskRunnerData(std::shared_ptr<Chunk> chunk_ptr,
+	// neighbour chunks are needed for light updates and may be null
+	inline ChunkTaskRunnerData(std::array<std::shared_ptr<Chunk>, 27> &&chunk_ptr_array,
 	                           std::unordered_map<InnerIndex3, ChunkUpdate<block::Block>> &&set_block_map)
-	    : m_chunk_ptr{std::move(chunk_ptr)}, m_set_block_map{std::move(set_block_map)} {}
-	inline const ChunkPos3 &GetChunkPos() const { return m_chunk_ptr->GetPosition(); }
-	inline const std::shared_ptr<Chunk> &GetChunkPtr() const { return m_chunk_ptr; }
+	    : m_chunk_ptr_array{std::move(chunk_ptr_array)}, m_set_block_map{std::move(set_block_map)} {}
+	inline const ChunkPos3 &GetChunkPos() const { return m_chunk_ptr_array[26]->GetPosition(); }
+	inline const std::shared_ptr<Chunk> &GetChunkPtr() const { return m_chunk_ptr_array[26]; }
+	inline const auto &GetChunkPtrArray() const { return m_chunk_ptr_array; }
 	inline const auto &GetSetBlockMap() const { return m_set_block_map; }
 };
 
 template <> class ChunkTaskRunner<ChunkTaskType::kSetBlock> {
+private:
+	ChunkLightUpdater m_light_updater;
+
 public:
 	inline static constexpr ChunkTaskType kType = ChunkTaskType::kSetBlock;
 
-	static void Run(ChunkTaskPool *p_task_pool, ChunkTaskRunnerData<ChunkTaskType::kSetBlock> &&data);
+	void Run(ChunkTaskPool *p_task_pool, ChunkTaskRunnerData<ChunkTaskType::kSetBlock> &&data);
 };
 
 } // namespace hc::client
@@ -1,4 +1,5 @@
 #include <client/Chunk.hpp>
+#include <client/ChunkLightUpdater.hpp>
 #include <client/ChunkUpdate.hpp>
 
 namespace hc::client {
@@ -33,22 +34,26 @@ public:
 
 template <> class ChunkTaskRunnerData<ChunkTaskType::kSetSunlight> {
 private:
-	std::shared_ptr<Chunk> m_chunk_ptr;
+	std::array<std::shared_ptr<Chunk>, 27> m_chunk_ptr_array;
 	std::unordered_map<InnerIndex2, ChunkUpdate<InnerPos1>> m_set_sunlight_map;
 
 public:
 	inline static constexpr ChunkTaskType kType = ChunkTaskType::kSetSunlight;
 
-	inline ChunkTaskRunnerData(std::shared_ptr<Chunk> chunk_ptr,
+	// neighbour chunks are needed for light updates and may be null
+	inline ChunkTaskRunnerData(std::array<std::shared_ptr<Chunk>, 27> &&chunk_ptr_array,
 	                           std::unordered_map<InnerIndex2, ChunkUpdate<InnerPos1>> &&set_sunlight_map)
-	    : m_chunk_ptr{std::move(chunk_ptr)}, m_set_sunlight_map{std::move(set_sunlight_map)} {}
-	inline const ChunkPos3 &GetChunkPos() const { return m_chunk_ptr->GetPosition(); }
-	inline const std::shared_ptr<Chunk> &GetChunkPtr() const { return m_chunk_ptr; }
+	    : m_chunk_ptr_array{std::move(chunk_ptr_array)}, m_set_sunlight_map{std::move(set_sunlight_map)} {}
+	inline const ChunkPos3 &GetChunkPos() const { return m_chunk_ptr_array[26]->GetPosition(); }
+	inline const std::shared_ptr<Chunk> &GetChunkPtr() const { return m_chunk_ptr_array[26]; }
+	inline const auto &GetChunkPtrArray() const { return m_chunk_ptr_array; }
 	inline const auto &GetSetSunlightMap() const { return m_set_sunlight_map; }
 };
 
 template <> class ChunkTaskRunner<ChunkTaskType::kSetSunlight> {
 private:
+	ChunkLightUpdater m_light_updater;
+
 public:
 	inline static constexpr ChunkTaskType kType = ChunkTaskType::kSetSunlight;
 
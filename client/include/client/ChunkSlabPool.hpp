@@ -0,0 +1,96 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_SLAB_POOL_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_SLAB_POOL_HPP
+
+#include <client/Chunk.hpp>
+#include <client/PaletteBufferPool.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hc::client {
+
+// Recycles the storage of Chunk objects (together with their shared_ptr control block). Slots are carved from slabs
+// owned by the pool; a slot returns to the free list once the last reference to its chunk is released. The block and
+// light layouts of the chunks are recycled by a PaletteBufferPool of the pool.
+class ChunkSlabPool : public std::enable_shared_from_this<ChunkSlabPool> {
+public:
+	struct Stats {
+		std::size_t hits, misses, in_use, peak, slots, capacity;
+		PaletteBufferPool::Stats palette_buffers;
+	};
+
+	inline static std::shared_ptr<ChunkSlabPool> Create(std::size_t capacity, std::size_t palette_buffer_capacity) {
+		return std::make_shared<ChunkSlabPool>(capacity, palette_buffer_capacity);
+	}
+
+private:
+	inline static constexpr std::size_t kSlotAlign = alignof(std::max_align_t),
+	                                    kSlotSize = (sizeof(Chunk) + 64 + kSlotAlign - 1) / kSlotAlign * kSlotAlign,
+	                                    kSlabSlots = 64;
+
+	template <typename T> class Allocator {
+	private:
+		std::shared_ptr<ChunkSlabPool> m_pool;
+		template <typename> friend class Allocator;
+
+	public:
+		using value_type = T;
+
+		inline explicit Allocator(std::shared_ptr<ChunkSlabPool> pool) : m_pool{std::move(pool)} {}
+		template <typename U> inline Allocator(const Allocator<U> &r) : m_pool{r.m_pool} {}
+
+		inline T *allocate(std::size_t n) {
+			static_assert(sizeof(T) <= kSlotSize && alignof(T) <= kSlotAlign);
+			return n == 1 ? static_cast<T *>(m_pool->allocate_slot()) : std::allocator<T>{}.allocate(n);
+		}
+		inline void deallocate(T *p, std::size_t n) {
+			if (n == 1)
+				m_pool->deallocate_slot(p);
+			else
+				std::allocator<T>{}.deallocate(p, n);
+		}
+		template <typename U> inline bool operator==(const Allocator<U> &r) const { return m_pool == r.m_pool; }
+		template <typename U> inline bool operator!=(const Allocator<U> &r) const { return m_pool != r.m_pool; }
+	};
+
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<std::byte[]>> m_slabs; // sorted by address
+	std::vector<void *> m_free_slots;
+	std::size_t m_capacity, m_hits{}, m_misses{}, m_in_use{}, m_peak{};
+	PaletteBufferPool m_palette_buffers;
+
+	void *allocate_slot();
+	void deallocate_slot(void *slot);
+	bool owns_slot(const void *slot) const;
+	std::size_t find_slab(const void *slot) const; // index of the slab holding slot, or m_slabs.size()
+
+public:
+	inline ChunkSlabPool(std::size_t capacity, std::size_t palette_buffer_capacity)
+	    : m_capacity{capacity}, m_palette_buffers{palette_buffer_capacity} {}
+	~ChunkSlabPool() = default;
+
+	// Bytes of a chunk with its control block
+	inline static constexpr std::size_t GetSlotSize() { return kSlotSize; }
+
+	inline std::shared_ptr<Chunk> AllocateChunk(const ChunkPos3 &position) {
+		return std::allocate_shared<Chunk>(Allocator<Chunk>{shared_from_this()}, position,
+		                                  &m_palette_buffers);
+	}
+
+	// Maximum number of slots backed by slabs, chunks beyond it fall back to the global heap
+	inline void SetCapacity(std::size_t capacity) {
+		std::scoped_lock lock{m_mutex};
+		m_capacity = capacity;
+	}
+	Stats GetStats();
+	// Frees the slabs with no chunk left, returns the bytes freed
+	std::size_t ReleaseEmptySlabs();
+	// Frees the palette layout buffers kept for the next chunks, returns the bytes freed
+	inline std::size_t ReleasePaletteBuffers() { return m_palette_buffers.Release(); }
+};
+
+} // namespace hc::client
+
+#endif
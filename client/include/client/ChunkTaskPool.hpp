@@ -2,17 +2,27 @@
 #ifndef HC_CLIENT_CHUNK_TASK_POOL_HPP
 #define HC_CLIENT_CHUNK_TASK_POOL_HPP
 
+#include <client/ChunkTaskScheduler.hpp>
+#include <client/ChunkTaskStats.hpp>
+
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <concurrentqueue.h>
+#include <chrono>
 #include <condition_variable>
+#include <cstdlib>
 #include <cuckoohash_map.hh>
+#include <deque>
 #include <glm/gtx/hash.hpp>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <span>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace hc::client {
 
@@ -21,9 +31,6 @@ class Chunk;
 class ChunkTaskPool;
 class ChunkTaskPoolLocked;
 
-enum class ChunkTaskType { kGenerate, kSetBlock, kSetSunlight, kMesh, kFloodSunlight, kUpdateBlock, COUNT };
-enum class ChunkTaskPriority { kHigh, kTick, kLow };
-
 template <ChunkTaskType> class ChunkTaskData;
 template <ChunkTaskType> class ChunkTaskRunnerData;
 template <ChunkTaskType> class ChunkTaskRunner;
@@ -31,6 +38,7 @@ template <ChunkTaskType> class ChunkTaskRunner;
 template <ChunkTaskType Type> class ChunkTaskDataBase {
 private:
 	bool m_running{false};
+	std::chrono::steady_clock::time_point m_push_time{};
 
 	friend class ChunkTaskPool;
 	friend class ChunkTaskPoolLocked;
@@ -46,6 +54,7 @@ public:
 
 #include "ChunkFloodSunlightTask.inl"
 #include "ChunkGenerateTask.inl"
+#include "ChunkLightTask.inl"
 #include "ChunkMeshTask.inl"
 #include "ChunkSetBlockTask.inl"
 #include "ChunkSetSunlightTask.inl"
@@ -87,19 +96,104 @@ template <> struct ChunkTaskRunnerDataVariant<ChunkTaskType::COUNT> {
 
 class ChunkTaskPoolToken;
 class ChunkTaskPool {
+public:
+	inline static constexpr std::size_t kMaxWorkers = 64;
+	// Pops read the task data of positions up to this many chunks away along every axis
+	inline static constexpr int32_t kPopRadius = 2;
+
 private:
 	using DataTuple = typename ChunkTaskDataTuple<>::Type;
 	using RunnerDataVariant = typename ChunkTaskRunnerDataVariant<>::Type;
 
+	// Task data sharded by regions of 4^3 chunks, so that a pop only locks the regions within kPopRadius
+	inline static constexpr ChunkPos1 kDataRegionShift = 2;
+	inline static constexpr uint32_t kDataShardCount = 64;
+	struct DataShard {
+		std::mutex mutex;
+		std::unordered_map<ChunkPos3, DataTuple> map;
+		// Running tasks of the tracked types (see is_tracked_around()) in the shard's regions
+		std::vector<std::pair<ChunkPos3, ChunkTaskType>> running;
+	};
+
+	// Runner data queued on a worker, the owner takes from the front and other workers steal from the back
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<RunnerDataVariant> high_priority, low_priority;
+	};
+
 	World &m_world;
-	libcuckoo::cuckoohash_map<ChunkPos3, DataTuple> m_data_map;
-	moodycamel::ConcurrentQueue<RunnerDataVariant> m_high_priority_runner_data_queue, m_low_priority_runner_data_queue;
+	std::array<DataShard, kDataShardCount> m_data_shards;
+	std::atomic_size_t m_data_count{0};
+	ChunkTaskScheduler m_scheduler;
+	std::array<WorkerQueue, kMaxWorkers> m_worker_queues;
+	std::array<ChunkTaskStatsRecorder, kMaxWorkers> m_stats_recorders;
+	std::chrono::steady_clock::time_point m_stats_begin_time{std::chrono::steady_clock::now()};
+	// Worker whose runner pushed to a position last
+	libcuckoo::cuckoohash_map<ChunkPos3, std::size_t> m_spawn_owners;
+	// Blocked positions waiting for a position's tasks to finish
+	libcuckoo::cuckoohash_map<ChunkPos3, std::vector<ChunkPos3>> m_waiters;
+	ChunkPos3 m_waiters_center_pos{};
+	ChunkLoadShape m_waiters_load_shape{};
+	std::atomic_size_t m_worker_count{0}, m_queued_count{0};
+	// Tasks found by ChunkTaskPoolLocked::FindRunningAround(): kSetBlock and kSetSunlight write the lights of the 27
+	// chunks around theirs, kMesh reads them
+	inline static constexpr bool is_tracked_around(ChunkTaskType type) {
+		return type == ChunkTaskType::kSetBlock || type == ChunkTaskType::kSetSunlight || type == ChunkTaskType::kMesh;
+	}
 	std::atomic_bool m_high_priority_producer_flag, m_tick_producer_flag;
 	std::mutex m_producer_mutex;
 
+	// Parking of idle workers, m_wake_epoch is bumped on every change that may create work
+	std::atomic_uint64_t m_wake_epoch{0};
+	std::atomic_uint32_t m_parked_count{0};
+	std::mutex m_park_mutex;
+	std::condition_variable m_park_condition;
+
+	inline static uint32_t get_region_shard_index(const ChunkPos3 &region) {
+		uint32_t h = uint32_t(region.x) * 73856093u ^ uint32_t(region.y) * 19349663u ^ uint32_t(region.z) * 83492791u;
+		return h % kDataShardCount;
+	}
+	inline static uint32_t get_data_shard_index(const ChunkPos3 &chunk_pos) {
+		return get_region_shard_index(chunk_pos >> kDataRegionShift);
+	}
+	inline DataShard &get_data_shard(const ChunkPos3 &chunk_pos) {
+		return m_data_shards[get_data_shard_index(chunk_pos)];
+	}
+	// Sorted indices of the shards of the regions within kPopRadius of chunk_pos, returns their count (at most 8)
+	inline static uint32_t get_pop_shard_indices(const ChunkPos3 &chunk_pos, uint32_t *p_indices) {
+		constexpr auto kRadius = ChunkPos1(kPopRadius);
+		ChunkPos3 min_region = (chunk_pos - kRadius) >> kDataRegionShift,
+		          max_region = (chunk_pos + kRadius) >> kDataRegionShift;
+		uint32_t count = 0;
+		ChunkPos3 region;
+		for (region.y = min_region.y; region.y <= max_region.y; ++region.y)
+			for (region.z = min_region.z; region.z <= max_region.z; ++region.z)
+				for (region.x = min_region.x; region.x <= max_region.x; ++region.x)
+					p_indices[count++] = get_region_shard_index(region);
+		std::sort(p_indices, p_indices + count);
+		return uint32_t(std::unique(p_indices, p_indices + count) - p_indices);
+	}
+
+	template <ChunkTaskPriority... TaskPriorities>
+	void pop_entry(ChunkTaskPoolLocked *p_locked_pool, ChunkTaskStatsRecorder *p_stats, const ChunkPos3 &chunk_pos,
+	               std::chrono::steady_clock::time_point pop_time, std::vector<RunnerDataVariant> *p_runner_data_vec);
 	template <ChunkTaskPriority... TaskPriorities>
-	void produce_runner_data(moodycamel::ConcurrentQueue<RunnerDataVariant> *p_queue,
-	                         const moodycamel::ProducerToken &token, std::size_t max_tasks);
+	void pop_entries(ChunkTaskPoolLocked *p_locked_pool, ChunkTaskStatsRecorder *p_stats,
+	                 std::span<const ChunkPos3> positions, std::size_t max_tasks,
+	                 std::vector<RunnerDataVariant> *p_runner_data_vec);
+	template <ChunkTaskPriority... TaskPriorities>
+	bool produce_runner_data(ChunkTaskPoolToken *p_token, bool high_priority, std::size_t max_tasks);
+	// Pop the tasks at the positions the last runner pushed to or unblocked, without the producer
+	void pop_local(ChunkTaskPoolToken *p_token);
+
+	void enqueue(std::size_t worker_index, bool high_priority, std::vector<RunnerDataVariant> &&vec);
+	bool dequeue_own(ChunkTaskPoolToken *p_token, bool high_priority, RunnerDataVariant *p_runner_data);
+	bool dequeue(ChunkTaskPoolToken *p_token, RunnerDataVariant *p_runner_data);
+	bool steal(ChunkTaskPoolToken *p_token, bool high_priority, RunnerDataVariant *p_runner_data);
+	// Remember positions pushed by the runner running on this thread
+	void record_spawn(const ChunkPos3 &chunk_pos);
+	// Reschedule the positions blocked on chunk_pos and append them to p_waiters
+	void notify_waiters(const ChunkPos3 &chunk_pos, std::vector<ChunkPos3> *p_waiters);
 
 	friend class ChunkTaskPoolToken;
 	friend class ChunkTaskPoolLocked;
@@ -109,77 +203,199 @@ public:
 	    : m_world{*p_world}, m_high_priority_producer_flag{false}, m_tick_producer_flag{false} {}
 
 	template <ChunkTaskType TaskType, typename... Args> inline void Push(const ChunkPos3 &chunk_pos, Args &&...args) {
-		bool high_priority = false;
-		m_data_map.uprase_fn(chunk_pos, [&](DataTuple &data_tuple, libcuckoo::UpsertContext) {
-			auto &data = std::get<static_cast<std::size_t>(TaskType)>(data_tuple);
+		bool high_priority;
+		{
+			DataShard &shard = get_data_shard(chunk_pos);
+			std::scoped_lock lock{shard.mutex};
+			auto [it, inserted] = shard.map.try_emplace(chunk_pos);
+			if (inserted)
+				m_data_count.fetch_add(1, std::memory_order_relaxed);
+			auto &data = std::get<static_cast<std::size_t>(TaskType)>(it->second);
+			if (!data.IsQueued())
+				data.m_push_time = std::chrono::steady_clock::now();
 			data.Push(std::forward<Args>(args)...);
 			high_priority = data.GetPriority() == ChunkTaskPriority::kHigh;
-			return false;
-		});
+		}
+		m_scheduler.Insert(chunk_pos);
+		record_spawn(chunk_pos);
 		if (high_priority)
 			m_high_priority_producer_flag.store(true, std::memory_order_release);
+		Wake();
 	}
 	inline void Clear() {
-		m_data_map.clear();
+		for (DataShard &shard : m_data_shards) {
+			std::scoped_lock lock{shard.mutex};
+			m_data_count.fetch_sub(shard.map.size(), std::memory_order_relaxed);
+			shard.map.clear();
+		}
+		m_scheduler.Clear();
+		m_spawn_owners.clear();
+		m_waiters.clear();
 		// clear queue
 	}
 
 	inline const World &GetWorld() const { return m_world; }
 	inline World &GetWorld() { return m_world; }
 
-	inline auto GetPendingTaskCount() const { return m_data_map.size(); }
-	inline auto GetRunningTaskCountApprox() const {
-		return m_low_priority_runner_data_queue.size_approx() + m_high_priority_runner_data_queue.size_approx();
+	inline std::size_t GetPendingTaskCount() const { return m_data_count.load(std::memory_order_relaxed); }
+	inline std::size_t GetRunningTaskCountApprox() const { return m_queued_count.load(std::memory_order_relaxed); }
+	// Bytes of the pending task data and of the queued runner data, without the chunks they reference and the empty
+	// slots of the data map
+	inline std::size_t GetMemoryBytes() const {
+		return GetPendingTaskCount() * sizeof(std::pair<ChunkPos3, DataTuple>) +
+		       GetRunningTaskCountApprox() * sizeof(RunnerDataVariant);
+	}
+	// Aggregate the per-worker task counters
+	ChunkTaskStats GetTaskStats() const;
+	// Whether any of the tasks runs within dist chunks of chunk_pos, see ChunkTaskPoolLocked::FindRunningAround()
+	template <ChunkTaskType... TaskTypes> bool AnyRunningAround(const ChunkPos3 &chunk_pos, int32_t dist);
+	// Returns false if there was nothing to do
+	bool Run(ChunkTaskPoolToken *p_token);
+	inline void ProduceTickTasks() {
+		m_tick_producer_flag.store(true, std::memory_order_release);
+		Wake();
+	}
+
+	inline uint64_t GetWakeEpoch() const { return m_wake_epoch.load(); }
+	// Block until woken after GetWakeEpoch() returned epoch, or the timeout expires
+	void Park(uint64_t epoch, std::chrono::milliseconds timeout);
+	inline void Wake(bool all = false) {
+		m_wake_epoch.fetch_add(1);
+		if (m_parked_count.load()) {
+			{ std::scoped_lock lock{m_park_mutex}; }
+			if (all)
+				m_park_condition.notify_all();
+			else
+				m_park_condition.notify_one();
+		}
 	}
-	void Run(ChunkTaskPoolToken *p_token);
-	inline void ProduceTickTasks() { m_tick_producer_flag.store(true, std::memory_order_release); }
 };
 
+// Task data locked for pops, either all of it (by the producer) or the regions read by a pop at a position
 class ChunkTaskPoolLocked {
 private:
 	using DataTuple = typename ChunkTaskDataTuple<>::Type;
 	using RunnerDataVariant = typename ChunkTaskRunnerDataVariant<>::Type;
 
+	ChunkTaskPool &m_pool;
 	World &m_world;
-	libcuckoo::cuckoohash_map<ChunkPos3, DataTuple>::locked_table m_data_map;
+	ChunkTaskScheduler &m_scheduler;
+	std::array<uint32_t, ChunkTaskPool::kDataShardCount> m_shard_indices;
+	uint32_t m_shard_count{0};
+	bool m_pushed{false};
+	mutable std::optional<ChunkPos3> m_blocker;
+
+	// Shards are always locked in the order of their indices
+	inline void lock() {
+		for (uint32_t i = 0; i < m_shard_count; ++i)
+			m_pool.m_data_shards[m_shard_indices[i]].mutex.lock();
+	}
+	inline const DataTuple *find(const ChunkPos3 &chunk_pos) const {
+		const auto &map = m_pool.m_data_shards[ChunkTaskPool::get_data_shard_index(chunk_pos)].map;
+		auto it = map.find(chunk_pos);
+		return it == map.end() ? nullptr : &it->second;
+	}
+	inline DataTuple *find(const ChunkPos3 &chunk_pos) {
+		return const_cast<DataTuple *>(std::as_const(*this).find(chunk_pos));
+	}
+	inline DataTuple &insert(const ChunkPos3 &chunk_pos) {
+		auto [it, inserted] = m_pool.get_data_shard(chunk_pos).map.try_emplace(chunk_pos);
+		if (inserted)
+			m_pool.m_data_count.fetch_add(1, std::memory_order_relaxed);
+		return it->second;
+	}
+	inline void erase(const ChunkPos3 &chunk_pos) {
+		if (m_pool.get_data_shard(chunk_pos).map.erase(chunk_pos))
+			m_pool.m_data_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	friend class ChunkTaskPool;
 
 public:
+	// Lock all the task data
 	inline explicit ChunkTaskPoolLocked(ChunkTaskPool *p_pool)
-	    : m_world{p_pool->m_world}, m_data_map{p_pool->m_data_map.lock_table()} {}
+	    : m_pool{*p_pool}, m_world{p_pool->m_world}, m_scheduler{p_pool->m_scheduler} {
+		for (; m_shard_count < ChunkTaskPool::kDataShardCount; ++m_shard_count)
+			m_shard_indices[m_shard_count] = m_shard_count;
+		lock();
+	}
+	// Lock the task data within ChunkTaskPool::kPopRadius of chunk_pos, which a pop at chunk_pos reads
+	inline ChunkTaskPoolLocked(ChunkTaskPool *p_pool, const ChunkPos3 &chunk_pos)
+	    : m_pool{*p_pool}, m_world{p_pool->m_world}, m_scheduler{p_pool->m_scheduler},
+	      m_shard_count{ChunkTaskPool::get_pop_shard_indices(chunk_pos, m_shard_indices.data())} {
+		lock();
+	}
+	inline ~ChunkTaskPoolLocked() {
+		for (uint32_t i = m_shard_count; i-- > 0;)
+			m_pool.m_data_shards[m_shard_indices[i]].mutex.unlock();
+		if (m_pushed)
+			m_pool.Wake();
+	}
+	ChunkTaskPoolLocked(const ChunkTaskPoolLocked &) = delete;
+	ChunkTaskPoolLocked &operator=(const ChunkTaskPoolLocked &) = delete;
+
 	[[nodiscard]] inline const World &GetWorld() const { return m_world; }
 	inline World &GetWorld() { return m_world; }
 
 	template <ChunkTaskType... TaskTypes> [[nodiscard]] inline bool AllNotIdle(const ChunkPos3 &chunk_pos) const {
-		auto it = m_data_map.find(chunk_pos);
-		return it != m_data_map.end() && (std::get<static_cast<std::size_t>(TaskTypes)>(it->second).NotIdle() && ...);
+		auto p_data = find(chunk_pos);
+		return p_data && (std::get<static_cast<std::size_t>(TaskTypes)>(*p_data).NotIdle() && ...);
 	}
 	template <ChunkTaskType... TaskTypes> [[nodiscard]] inline bool AnyNotIdle(const ChunkPos3 &chunk_pos) const {
-		auto it = m_data_map.find(chunk_pos);
-		return it != m_data_map.end() && (std::get<static_cast<std::size_t>(TaskTypes)>(it->second).NotIdle() || ...);
+		auto p_data = find(chunk_pos);
+		return p_data && (std::get<static_cast<std::size_t>(TaskTypes)>(*p_data).NotIdle() || ...);
 	}
 	template <ChunkTaskType... TaskTypes> [[nodiscard]] inline bool AllRunning(const ChunkPos3 &chunk_pos) const {
-		auto it = m_data_map.find(chunk_pos);
-		return it != m_data_map.end() && (std::get<static_cast<std::size_t>(TaskTypes)>(it->second).IsRunning() && ...);
+		auto p_data = find(chunk_pos);
+		return p_data && (std::get<static_cast<std::size_t>(TaskTypes)>(*p_data).IsRunning() && ...);
 	}
 	template <ChunkTaskType... TaskTypes> [[nodiscard]] inline bool AnyRunning(const ChunkPos3 &chunk_pos) const {
-		auto it = m_data_map.find(chunk_pos);
-		return it != m_data_map.end() && (std::get<static_cast<std::size_t>(TaskTypes)>(it->second).IsRunning() || ...);
+		auto p_data = find(chunk_pos);
+		return p_data && (std::get<static_cast<std::size_t>(TaskTypes)>(*p_data).IsRunning() || ...);
+	}
+	// A position within dist (at most ChunkTaskPool::kPopRadius) chunks of chunk_pos along every axis where any of
+	// the tasks is running. Only the few running tasks of the regions around are visited.
+	template <ChunkTaskType... TaskTypes>
+	[[nodiscard]] inline std::optional<ChunkPos3> FindRunningAround(const ChunkPos3 &chunk_pos, int32_t dist) const {
+		static_assert((ChunkTaskPool::is_tracked_around(TaskTypes) && ...));
+		std::array<uint32_t, 8> shard_indices;
+		uint32_t shard_count = ChunkTaskPool::get_pop_shard_indices(chunk_pos, shard_indices.data());
+		for (uint32_t i = 0; i < shard_count; ++i)
+			for (const auto &[pos, type] : m_pool.m_data_shards[shard_indices[i]].running)
+				if (((type == TaskTypes) || ...) && std::abs(pos.x - chunk_pos.x) <= dist &&
+				    std::abs(pos.y - chunk_pos.y) <= dist && std::abs(pos.z - chunk_pos.z) <= dist)
+					return pos;
+		return std::nullopt;
 	}
+	// Called by a failing Pop to wait until the tasks at chunk_pos finish (or its chunk gets generated) instead of
+	// being polled again
+	inline std::nullopt_t Block(const ChunkPos3 &chunk_pos) const {
+		m_blocker = chunk_pos;
+		return std::nullopt;
+	}
+
+	// chunk_pos must be within the locked regions
 	template <ChunkTaskType TaskType, typename... Args> inline void Push(const ChunkPos3 &chunk_pos, Args &&...args) {
-		auto it = m_data_map.insert(chunk_pos).first;
-		auto &data = std::get<static_cast<std::size_t>(TaskType)>(it->second);
+		auto &data = std::get<static_cast<std::size_t>(TaskType)>(insert(chunk_pos));
+		if (!data.IsQueued())
+			data.m_push_time = std::chrono::steady_clock::now();
 		data.Push(std::forward<Args>(args)...);
+		m_scheduler.Insert(chunk_pos);
+		m_pushed = true;
 	}
 	/* template <ChunkTaskType TaskType, typename Iterator, typename... Args>
 	inline void PushBulk(Iterator chunk_pos_begin, Iterator chunk_pos_end, Args &&...args) {
 	    for (Iterator it = chunk_pos_begin; it != chunk_pos_end; ++it)
 	        Push<TaskType>(*it, args...);
 	} */
-
-	[[nodiscard]] inline const auto &GetDataMap() const { return m_data_map; }
-	inline auto &GetDataMap() { return m_data_map; }
 };
 
+template <ChunkTaskType... TaskTypes>
+inline bool ChunkTaskPool::AnyRunningAround(const ChunkPos3 &chunk_pos, int32_t dist) {
+	ChunkTaskPoolLocked locked_pool{this, chunk_pos};
+	return locked_pool.FindRunningAround<TaskTypes...>(chunk_pos, dist).has_value();
+}
+
 struct ChunkTaskPoolProducerConfig {
 	std::size_t max_tasks, max_high_priority_tasks, max_tick_tasks;
 };
@@ -188,20 +404,19 @@ class ChunkTaskPoolToken {
 private:
 	using RunnerTuple = typename ChunkTaskRunnerTuple<>::Type;
 
-	moodycamel::ProducerToken m_high_priority_producer_token, m_low_priority_producer_token;
-	moodycamel::ConsumerToken m_high_priority_consumer_token, m_low_priority_consumer_token;
+	std::size_t m_worker_index;
 	RunnerTuple m_runners;
 
 	ChunkTaskPoolProducerConfig m_producer_config;
+	// Positions pushed to or unblocked by the runner running on this token, see ChunkTaskPool::pop_local()
+	std::vector<ChunkPos3> m_local_positions;
 
 	friend class ChunkTaskPool;
 
 public:
 	inline explicit ChunkTaskPoolToken(ChunkTaskPool *p_pool, const ChunkTaskPoolProducerConfig &producer_config)
-	    : m_high_priority_producer_token{p_pool->m_high_priority_runner_data_queue},
-	      m_high_priority_consumer_token{p_pool->m_high_priority_runner_data_queue},
-	      m_low_priority_producer_token{p_pool->m_low_priority_runner_data_queue},
-	      m_low_priority_consumer_token{p_pool->m_low_priority_runner_data_queue}, m_producer_config{producer_config} {}
+	    : m_worker_index{p_pool->m_worker_count.fetch_add(1) % ChunkTaskPool::kMaxWorkers},
+	      m_producer_config{producer_config} {}
 };
 
 } // namespace hc::client
@@ -0,0 +1,142 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_TASK_SCHEDULER_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_TASK_SCHEDULER_HPP
+
+#include <client/ChunkLoadShape.hpp>
+#include <common/Position.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace hc::client {
+
+// Camera state used to prioritize chunk tasks, quantized by World::SetCenterView() so that small camera changes don't
+// reorder the tasks
+struct ChunkTaskView {
+	inline static constexpr float kLookAheadSeconds = 1.0f;
+	inline static constexpr uint32_t kOutOfViewFactor = 4;
+	// Keys per chunk of distance, keys grow linearly with the distance so that large radii don't need many buckets
+	inline static constexpr float kKeysPerChunk = 4.0f;
+
+	glm::vec3 direction{0.0f}; // normalized, zero to disable the view test
+	glm::vec3 velocity{0.0f};  // chunks per second
+	// cosine and sine of the half angle of the cone enclosing the view frustum, which is below pi / 2
+	float half_angle_cos{1.0f}, half_angle_sin{0.0f};
+
+	inline bool operator==(const ChunkTaskView &r) const {
+		return direction == r.direction && velocity == r.velocity && half_angle_cos == r.half_angle_cos &&
+		       half_angle_sin == r.half_angle_sin;
+	}
+
+	// Whether the chunk at rel_pos relative to the center chunk may intersect the view cone. Keys are computed for
+	// every collected position, so the angles are compared by their cosines.
+	inline bool IsVisible(const ChunkPos3 &rel_pos) const {
+		if (direction == glm::vec3{0.0f} || ChunkPosLength2(rel_pos) <= 3)
+			return true;
+		glm::vec3 rel{rel_pos};
+		float dist2 = glm::dot(rel, rel), d = glm::dot(rel, direction);
+		// widen the cone by the angular radius of the chunk bounding sphere, the sum stays below pi
+		float margin_sin2 = std::min(1.0f, 0.87f * 0.87f / dist2), margin_sin = std::sqrt(margin_sin2),
+		      margin_cos = std::sqrt(1.0f - margin_sin2);
+		return d >= std::sqrt(dist2) * (half_angle_cos * margin_cos - half_angle_sin * margin_sin);
+	}
+	// Key of a distance in chunks, non-negative so rounding needs no std::lround()
+	inline static uint32_t GetLengthKey(float length) { return (uint32_t)(length * kKeysPerChunk + 0.5f); }
+	inline static uint32_t GetDistKey(uint32_t dist2) { return GetLengthKey(std::sqrt((float)dist2)); }
+	// Priority key of the chunk at rel_pos relative to the center chunk, lower first, at most
+	// max_dist_key * kOutOfViewFactor
+	inline uint32_t GetKey(const ChunkPos3 &rel_pos, uint32_t max_dist_key) const {
+		glm::vec3 ahead = glm::vec3{rel_pos} - velocity * kLookAheadSeconds;
+		uint32_t key = std::min(GetLengthKey(glm::length(ahead)), max_dist_key);
+		return IsVisible(rel_pos) ? key : key * kOutOfViewFactor;
+	}
+	// The key of a chunk is at least its distance key minus this, since the look ahead moves it by |velocity| seconds
+	inline uint32_t GetKeySlack() const {
+		return (uint32_t)std::ceil(glm::length(velocity) * kLookAheadSeconds * kKeysPerChunk) + 1;
+	}
+};
+
+// Positions with chunk task data, bucketed by distance to the center chunk and sharded by position so that pushes from
+// different workers rarely contend. Buckets are only rebuilt when the center or the shapes change. The view weighs the
+// positions as they are collected (see ChunkTaskView::GetKey), so a camera turn costs no re-bucketing and a producer
+// reads the most urgent positions without scanning or sorting the whole task table.
+class ChunkTaskScheduler {
+public:
+	inline static constexpr uint32_t kShardCount = 16;
+
+private:
+	struct Slot {
+		uint32_t bucket, index;
+	};
+	struct Candidate {
+		uint32_t key;
+		ChunkPos3 pos;
+	};
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<ChunkPos3, Slot> slots;
+		// [0, max distance key] by distance key, then one bucket beyond the load shape, one beyond the unload shape
+		// and one for blocked positions
+		std::vector<std::vector<ChunkPos3>> buckets{4};
+		ChunkPos3 center{};
+		ChunkLoadShape load_shape{}, unload_shape{};
+		ChunkPos1 max_y{};
+
+		inline uint32_t GetFarBucket() const { return ChunkTaskView::GetDistKey(load_shape.GetMaxDist2()) + 1; }
+		inline uint32_t GetUnloadBucket() const { return GetFarBucket() + 1; }
+		inline uint32_t GetBlockedBucket() const { return GetFarBucket() + 2; }
+		inline uint32_t GetBucket(const ChunkPos3 &chunk_pos) const {
+			ChunkPos3 rel_pos = chunk_pos - center;
+			if (chunk_pos.y > max_y)
+				return GetUnloadBucket();
+			return load_shape.Contains(rel_pos)
+			           ? ChunkTaskView::GetDistKey(ChunkPosLength2(rel_pos))
+			           : (unload_shape.Contains(rel_pos) ? GetFarBucket() : GetUnloadBucket());
+		}
+		void Insert(const ChunkPos3 &chunk_pos, uint32_t bucket);
+		void Remove(const Slot &slot);
+	};
+
+	std::array<Shard, kShardCount> m_shards;
+	ChunkPos3 m_center{};
+	ChunkTaskView m_view{};
+	ChunkLoadShape m_load_shape{}, m_unload_shape{};
+	ChunkPos1 m_max_y{};
+	// Kept between CollectNearest() calls to reuse their allocations
+	std::vector<Candidate> m_candidates;
+	std::vector<uint32_t> m_key_counts;
+
+	inline Shard &get_shard(const ChunkPos3 &chunk_pos) {
+		uint32_t h = uint32_t(chunk_pos.x) * 73856093u ^ uint32_t(chunk_pos.y) * 19349663u ^
+		             uint32_t(chunk_pos.z) * 83492791u;
+		return m_shards[h % kShardCount];
+	}
+
+public:
+	// Insert the position, or unblock it if present
+	void Insert(const ChunkPos3 &chunk_pos);
+	void Erase(const ChunkPos3 &chunk_pos);
+	// Skip the position in CollectNearest() until it is inserted again
+	void Block(const ChunkPos3 &chunk_pos);
+	// Move the position behind the others of the same distance, so that blocked tasks don't always occupy the front
+	void Defer(const ChunkPos3 &chunk_pos);
+	void Clear();
+
+	// Re-bucket all positions if the center or the shapes changed, and take the view for CollectNearest(). Only called
+	// by the producer.
+	void Update(const ChunkPos3 &center, const ChunkLoadShape &load_shape, const ChunkLoadShape &unload_shape,
+	            ChunkPos1 max_y, const ChunkTaskView &view);
+	// Append up to max_count positions within the load shape, most urgent by the view first
+	void CollectNearest(std::size_t max_count, std::vector<ChunkPos3> *p_positions);
+	// Append up to max_count positions beyond the unload shape
+	void CollectUnload(std::size_t max_count, std::vector<ChunkPos3> *p_positions);
+};
+
+} // namespace hc::client
+
+#endif
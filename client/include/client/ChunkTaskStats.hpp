@@ -0,0 +1,78 @@
+#ifndef HYPERCRAFT_CLIENT_CHUNK_TASK_STATS_HPP
+#define HYPERCRAFT_CLIENT_CHUNK_TASK_STATS_HPP
+
+#include <client/LatencyHistogram.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace hc::client {
+
+enum class ChunkTaskType { kGenerate, kSetBlock, kSetSunlight, kLight, kMesh, kFloodSunlight, kUpdateBlock, COUNT };
+enum class ChunkTaskPriority { kHigh, kTick, kLow };
+
+inline constexpr std::size_t kChunkTaskTypeCount = static_cast<std::size_t>(ChunkTaskType::COUNT);
+const char *GetChunkTaskTypeName(ChunkTaskType type);
+
+struct ChunkTaskTypeStats {
+	// Pops rejected because of neighbour dependencies, see ChunkTaskPoolLocked::Block()
+	uint64_t popped{}, rejected{}, completed{};
+	// From the push to the pop of a task, and of ChunkTaskRunner::Run()
+	LatencyHistogram queue_time, run_time;
+};
+
+// Aggregated counters of all workers, cumulative since the creation of the ChunkTaskPool
+struct ChunkTaskStats {
+	double seconds{};
+	std::array<ChunkTaskTypeStats, kChunkTaskTypeCount> types{};
+
+	inline const ChunkTaskTypeStats &Get(ChunkTaskType type) const { return types[static_cast<std::size_t>(type)]; }
+	inline double GetRate(uint64_t count) const { return seconds > 0.0 ? double(count) / seconds : 0.0; }
+	inline double GetTasksPerSecond(ChunkTaskType type) const { return GetRate(Get(type).completed); }
+	// Counters within [earlier, this)
+	ChunkTaskStats Since(const ChunkTaskStats &earlier) const;
+
+	// One row per task type
+	std::string ToCSV() const;
+	// Includes the histogram buckets
+	std::string ToJSON() const;
+};
+
+// Counters of a single worker. Only the worker writes them (without read-modify-write), so GetTaskStats() can read
+// them at any time without locks.
+class ChunkTaskStatsRecorder {
+private:
+	struct alignas(64) TypeCounters {
+		std::atomic_uint64_t popped, rejected, completed, queue_sum_us, run_sum_us;
+		std::array<std::atomic_uint64_t, LatencyHistogram::kBucketCount> queue_buckets, run_buckets;
+	};
+	std::array<TypeCounters, kChunkTaskTypeCount> m_types{};
+
+	inline static void add(std::atomic_uint64_t &counter, uint64_t value) {
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+	inline TypeCounters &get(ChunkTaskType type) { return m_types[static_cast<std::size_t>(type)]; }
+
+public:
+	inline void OnPop(ChunkTaskType type, uint64_t queue_us) {
+		auto &counters = get(type);
+		add(counters.popped, 1);
+		add(counters.queue_sum_us, queue_us);
+		add(counters.queue_buckets[LatencyHistogram::GetBucket(queue_us)], 1);
+	}
+	inline void OnReject(ChunkTaskType type) { add(get(type).rejected, 1); }
+	inline void OnComplete(ChunkTaskType type, uint64_t run_us) {
+		auto &counters = get(type);
+		add(counters.completed, 1);
+		add(counters.run_sum_us, run_us);
+		add(counters.run_buckets[LatencyHistogram::GetBucket(run_us)], 1);
+	}
+	// Add the counters to p_stats
+	void Accumulate(ChunkTaskStats *p_stats) const;
+};
+
+} // namespace hc::client
+
+#endif
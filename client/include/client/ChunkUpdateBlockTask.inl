@@ -1,4 +1,5 @@
 #include <client/Chunk.hpp>
+#include <client/ChunkNeighbourhood.hpp>
 
 #include <glm/gtx/hash.hpp>
 #include <unordered_map>
@@ -55,6 +56,10 @@ public:
 
 template <> class ChunkTaskRunner<ChunkTaskType::kUpdateBlock> {
 private:
+	// Covers update neighbours and the liquid detection distance, farther probes fall back to chunk lookups
+	inline static constexpr uint32_t kNeighbourhoodBorder = 8;
+	ChunkNeighbourhood<kNeighbourhoodBorder> m_neighbourhood;
+
 	block::Block m_update_neighbours[block::kBlockUpdateMaxNeighbours],
 	    m_update_set_blocks[block::kBlockUpdateMaxNeighbours];
 	InnerPos3 m_update_neighbour_pos[block::kBlockUpdateMaxNeighbours];
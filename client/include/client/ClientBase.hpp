@@ -25,6 +25,9 @@ public:
 	virtual void LoadChunks(std::span<const ChunkPos3> chunk_pos_s) = 0;
 	virtual void SetChunkBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks) = 0;
 	virtual void SetChunkSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights) = 0;
+	// Whether generated chunks should be passed to SetBakedChunk(), see BakedChunk.hpp
+	inline virtual bool IsBakingChunks() const { return false; }
+	inline virtual void SetBakedChunk(ChunkPos3 chunk_pos, std::vector<uint8_t> &&baked) {}
 };
 
 } // namespace hc::client
@@ -2,6 +2,7 @@
 #define HYPERCRAFT_CLIENT_CONFIG_HPP
 
 #include <cinttypes>
+#include <cstddef>
 
 namespace hc::client {
 
@@ -9,9 +10,21 @@ constexpr const char *kAppName = "HyperCraft";
 constexpr uint32_t kDefaultWidth = 1280, kDefaultHeight = 720;
 constexpr uint32_t kFrameCount = 3;
 
-constexpr float kCameraNear = 0.01f, kCameraFar = 640.0f;
+// The far plane follows the load shape (see ChunkLoadShape::GetFarDistance())
+constexpr float kCameraNear = 0.01f;
 
-constexpr uint32_t kWorldMaxLoadRadius = 20;
+constexpr uint32_t kWorldMaxLoadRadius = 64;
+constexpr std::size_t kChunkSlabPoolCapacity = 16384;
+// Bytes of the freed block and light layouts kept for the next chunks, see PaletteBufferPool
+constexpr std::size_t kChunkPaletteBufferCapacity = 32 * 1024 * 1024;
+// Bytes of the encoded chunks kept after being unloaded, see ChunkHibernationCache
+constexpr std::size_t kChunkHibernationCapacity = 64 * 1024 * 1024;
+// Unloaded chunks waiting for the workers to encode them, the oldest are not hibernated beyond this
+constexpr std::size_t kChunkHibernationMaxPending = 1024;
+// Ticks between memory budget checks, and the smallest radius the load shape shrinks to when over the budget
+constexpr uint32_t kMemoryBudgetTicks = 20, kMemoryBudgetMinLoadRadius = 4;
+// Positions visited by a single chunk task producing pass
+constexpr std::size_t kChunkTaskMaxVisits = 8192;
 
 } // namespace hc::client
 
@@ -40,6 +40,10 @@ private:
 
 	// Biome
 	inline static constexpr uint32_t kBiomeMapSize = 4, kSampleScale = 1, kOceanSampleScale = 16, kHeightRange = 256;
+	// Deepest non-stone layer below the surface among all biomes
+	inline static constexpr int32_t kMaxSurfaceDepth = 8;
+	// Highest block of the trees above the surface
+	inline static constexpr int32_t kMaxDecorationHeight = 40;
 	inline static constexpr Biome kBiomeMap[kBiomeMapSize][kBiomeMapSize] = {
 	    // [precipitation][temperature]
 	    {Biomes::kGlacier, Biomes::kTundra, Biomes::kDesert, Biomes::kDesert},
@@ -499,7 +503,7 @@ private:
 	};
 	struct XZInfo {
 		DecorationGroup decorations;
-		int32_t height_map[kChunkSize * kChunkSize]{}, max_height{INT32_MIN};
+		int32_t height_map[kChunkSize * kChunkSize]{}, max_height{INT32_MIN}, min_height{INT32_MAX};
 		int32_t light_map[kChunkSize * kChunkSize]{}; // the lowest spot with sunlight
 		uint16_t meta[kChunkSize * kChunkSize]{};
 		Biome biome_map[kChunkSize * kChunkSize]{};
@@ -541,7 +545,11 @@ public:
 	}
 	~DefaultTerrain() override = default;
 	inline static std::unique_ptr<TerrainBase> Create(uint32_t seed) { return std::make_unique<DefaultTerrain>(seed); }
+	inline uint32_t GetVersion() const override { return 1; }
 	void Generate(const std::shared_ptr<Chunk> &chunk_ptr) override;
+	std::optional<BlockPos1> GetMaxHeight() const override;
+	std::size_t GetCacheBytes() const override;
+	std::size_t TrimCaches(std::size_t bytes) override;
 };
 
 } // namespace hc::client
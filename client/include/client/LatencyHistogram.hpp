@@ -0,0 +1,85 @@
+#ifndef HYPERCRAFT_CLIENT_LATENCY_HISTOGRAM_HPP
+#define HYPERCRAFT_CLIENT_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+namespace hc::client {
+
+// Durations in power-of-two microsecond buckets, bucket i holds [2^(i-1), 2^i) us (bucket 0 holds 0 us)
+struct LatencyHistogram {
+	inline static constexpr uint32_t kBucketCount = 28;
+
+	std::array<uint64_t, kBucketCount> buckets{};
+	uint64_t sum_us{};
+
+	inline static uint32_t GetBucket(uint64_t us) { return std::min<uint32_t>(std::bit_width(us), kBucketCount - 1); }
+
+	inline uint64_t GetCount() const {
+		uint64_t count = 0;
+		for (uint64_t c : buckets)
+			count += c;
+		return count;
+	}
+	inline double GetMeanUs() const {
+		uint64_t count = GetCount();
+		return count ? double(sum_us) / double(count) : 0.0;
+	}
+	// Upper bound of the bucket holding the p-quantile (p in [0, 1]), 0 if empty
+	inline uint64_t GetQuantileUs(double p) const {
+		uint64_t count = GetCount();
+		if (count == 0)
+			return 0;
+		auto rank = std::max<uint64_t>(uint64_t(std::clamp(p, 0.0, 1.0) * double(count) + 0.5), 1);
+		uint64_t cumulative = 0;
+		for (uint32_t b = 0; b < kBucketCount; ++b)
+			if ((cumulative += buckets[b]) >= rank)
+				return uint64_t(1) << b;
+		return uint64_t(1) << (kBucketCount - 1);
+	}
+	// Durations added after earlier
+	inline LatencyHistogram Since(const LatencyHistogram &earlier) const {
+		LatencyHistogram ret;
+		for (uint32_t b = 0; b < kBucketCount; ++b)
+			ret.buckets[b] = buckets[b] - earlier.buckets[b];
+		ret.sum_us = sum_us - earlier.sum_us;
+		return ret;
+	}
+
+	// Summary and buckets
+	inline std::string ToJSON() const {
+		std::string json = "{\"count\":" + std::to_string(GetCount()) + ",\"mean_us\":" + std::to_string(GetMeanUs()) +
+		                   ",\"p50_us\":" + std::to_string(GetQuantileUs(0.5)) +
+		                   ",\"p90_us\":" + std::to_string(GetQuantileUs(0.9)) +
+		                   ",\"p99_us\":" + std::to_string(GetQuantileUs(0.99)) + ",\"buckets\":[";
+		for (uint32_t b = 0; b < kBucketCount; ++b)
+			json += (b ? "," : "") + std::to_string(buckets[b]);
+		return json + "]}";
+	}
+};
+
+// LatencyHistogram written by many threads at once
+class AtomicLatencyHistogram {
+private:
+	std::array<std::atomic_uint64_t, LatencyHistogram::kBucketCount> m_buckets{};
+	std::atomic_uint64_t m_sum_us{};
+
+public:
+	inline void Add(uint64_t us) {
+		m_buckets[LatencyHistogram::GetBucket(us)].fetch_add(1, std::memory_order_relaxed);
+		m_sum_us.fetch_add(us, std::memory_order_relaxed);
+	}
+	inline void Accumulate(LatencyHistogram *p_histogram) const {
+		for (uint32_t b = 0; b < LatencyHistogram::kBucketCount; ++b)
+			p_histogram->buckets[b] += m_buckets[b].load(std::memory_order_relaxed);
+		p_histogram->sum_us += m_sum_us.load(std::memory_order_relaxed);
+	}
+};
+
+} // namespace hc::client
+
+#endif
@@ -5,30 +5,45 @@
 #include <blockingconcurrentqueue.h>
 #include <client/ClientBase.hpp>
 #include <common/WorldDatabase.hpp>
+#include <common/WorldDatabaseWriter.hpp>
 #include <thread>
 
 namespace hc::client {
 
+struct LocalClientConfig {
+	WorldDatabaseWriterConfig writer;
+	// Store generated chunks in the database and load them instead of generating them again
+	bool bake_chunks{false};
+	// Threads reading requested chunks from the database, each one serving a share of the positions
+	std::size_t load_threads{2};
+};
+
 class LocalClient final : public ClientBase, public std::enable_shared_from_this<LocalClient> {
 private:
 	std::unique_ptr<WorldDatabase> m_world_database;
+	std::unique_ptr<WorldDatabaseWriter> m_world_database_writer;
+	bool m_bake_chunks{false};
 
-	moodycamel::BlockingConcurrentQueue<std::vector<ChunkPos3>> m_load_chunk_queue;
+	std::vector<std::unique_ptr<moodycamel::BlockingConcurrentQueue<std::vector<ChunkPos3>>>> m_load_chunk_queues;
 	std::atomic_bool m_thread_running{true};
-	std::thread m_tick_thread, m_load_chunk_thread;
+	std::thread m_tick_thread;
+	std::vector<std::thread> m_load_chunk_threads;
 
 	void tick_thread_func();
-	void load_chunk_thread_func();
+	void load_chunk_thread_func(std::size_t thread_index);
 
 public:
 	~LocalClient() final;
 	inline bool IsConnected() final { return true; }
 
-	static std::shared_ptr<LocalClient> Create(const std::shared_ptr<World> &world_ptr, const char *database_filename);
+	static std::shared_ptr<LocalClient> Create(const std::shared_ptr<World> &world_ptr, const char *database_filename,
+	                                           const LocalClientConfig &config = {});
 
 	void LoadChunks(std::span<const ChunkPos3> chunk_pos_s) final;
 	void SetChunkBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks) final;
 	void SetChunkSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights) final;
+	inline bool IsBakingChunks() const final { return m_bake_chunks; }
+	void SetBakedChunk(ChunkPos3 chunk_pos, std::vector<uint8_t> &&baked) final;
 };
 
 } // namespace hc::client
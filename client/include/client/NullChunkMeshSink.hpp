@@ -0,0 +1,56 @@
+#ifndef HYPERCRAFT_CLIENT_NULL_CHUNK_MESH_SINK_HPP
+#define HYPERCRAFT_CLIENT_NULL_CHUNK_MESH_SINK_HPP
+
+#include <client/ChunkMeshSink.hpp>
+#include <client/World.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace hc::client {
+
+// Drops the meshes of a World without a GPU, only counting and sizing them
+class NullChunkMeshSink final : public ChunkMeshSink {
+public:
+	struct Stats {
+		std::size_t chunks, meshes, vertices, indices, bytes;
+	};
+
+	inline static std::shared_ptr<NullChunkMeshSink> Create(const std::shared_ptr<World> &world_ptr) {
+		auto ret = std::make_shared<NullChunkMeshSink>(world_ptr);
+		world_ptr->m_mesh_sink_weak_ptr = ret;
+		return ret;
+	}
+
+private:
+	std::shared_ptr<World> m_world_ptr;
+	std::atomic_size_t m_chunks{0}, m_meshes{0}, m_vertices{0}, m_indices{0}, m_bytes{0};
+
+public:
+	inline explicit NullChunkMeshSink(std::shared_ptr<World> world_ptr) : m_world_ptr{std::move(world_ptr)} {}
+
+	inline void PushChunkMesh(const ChunkPos3 &chunk_pos, std::vector<BlockMesh> &&meshes) final {
+		std::size_t vertices = 0, indices = 0;
+		for (const auto &mesh : meshes) {
+			vertices += mesh.vertices.size();
+			indices += mesh.indices.size();
+		}
+		m_chunks.fetch_add(1, std::memory_order_relaxed);
+		m_meshes.fetch_add(meshes.size(), std::memory_order_relaxed);
+		m_vertices.fetch_add(vertices, std::memory_order_relaxed);
+		m_indices.fetch_add(indices, std::memory_order_relaxed);
+		m_bytes.fetch_add(vertices * sizeof(BlockVertex) + indices * sizeof(uint16_t), std::memory_order_relaxed);
+		m_world_ptr->OnChunkVisible(chunk_pos);
+	}
+	inline void EraseUnloadedMeshes() final {}
+
+	inline Stats GetStats() const {
+		return {m_chunks.load(std::memory_order_relaxed), m_meshes.load(std::memory_order_relaxed),
+		        m_vertices.load(std::memory_order_relaxed), m_indices.load(std::memory_order_relaxed),
+		        m_bytes.load(std::memory_order_relaxed)};
+	}
+};
+
+} // namespace hc::client
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef HYPERCRAFT_CLIENT_PALETTE_ARRAY_HPP
+#define HYPERCRAFT_CLIENT_PALETTE_ARRAY_HPP
+
+#include <client/PaletteBufferPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cinttypes>
+#include <concepts>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace hc::client {
+
+// Fixed-length array of small trivially-copyable values stored as a palette plus bit-packed indices.
+// Index width grows 0 -> 1 -> 2 -> 4 -> 8 -> ... bits on palette overflow; once it reaches the value width, values are
+// stored directly. Single writer, multiple readers: a widened layout is published atomically and the retired one is
+// kept alive until Compact(), so concurrent readers never touch freed memory.
+template <typename T, uint32_t Length>
+requires std::is_trivially_copyable_v<T> && (sizeof(T) == 1 || sizeof(T) == 2) && (Length % 64 == 0)
+class PaletteArray {
+private:
+	using Raw = std::conditional_t<sizeof(T) == 1, uint8_t, uint16_t>;
+	inline static constexpr uint32_t kDirectBits = sizeof(T) * 8;
+
+	// Header of a buffer holding the index words and then the palette
+	struct Layout {
+		uint32_t bits, palette_size;
+		uint64_t mask;
+		uint64_t *words;
+		T *palette;
+
+		inline explicit Layout(uint32_t bits)
+		    : bits{bits}, palette_size{0}, mask{(uint64_t(1) << bits) - 1},
+		      words{reinterpret_cast<uint64_t *>(this + 1)},
+		      palette{reinterpret_cast<T *>(words + GetWordCount(bits))} {
+			std::fill(words, words + GetWordCount(bits), 0);
+		}
+		inline static constexpr uint32_t GetWordCount(uint32_t bits) { return Length * bits / 64; }
+		inline static constexpr uint32_t GetPaletteCapacity(uint32_t bits) {
+			return bits == kDirectBits ? 0 : 1u << bits;
+		}
+		inline static constexpr std::size_t GetBufferSize(uint32_t bits) {
+			return sizeof(Layout) + GetWordCount(bits) * sizeof(uint64_t) + GetPaletteCapacity(bits) * sizeof(T);
+		}
+		inline bool IsDirect() const { return bits == kDirectBits; }
+		inline uint32_t GetWordCount() const { return GetWordCount(bits); }
+		inline uint32_t GetPaletteCapacity() const { return GetPaletteCapacity(bits); }
+		inline std::size_t GetHeapSize() const { return GetBufferSize(bits); }
+		inline uint64_t GetIndex(uint32_t idx) const {
+			uint32_t bit = idx * bits;
+			return (words[bit >> 6u] >> (bit & 63u)) & mask;
+		}
+		inline void SetIndex(uint32_t idx, uint64_t v) {
+			uint32_t bit = idx * bits;
+			uint64_t &word = words[bit >> 6u];
+			word = (word & ~(mask << (bit & 63u))) | (v << (bit & 63u));
+		}
+		inline T Get(uint32_t idx) const {
+			if (bits == 0)
+				return palette[0];
+			uint64_t v = GetIndex(idx);
+			return IsDirect() ? std::bit_cast<T>(Raw(v)) : palette[v];
+		}
+	};
+	static_assert(sizeof(Layout) % alignof(uint64_t) == 0);
+
+	// Returns the buffer of a layout to the pool it was allocated from
+	struct LayoutDeleter {
+		PaletteBufferPool *p_buffer_pool;
+		inline void operator()(Layout *layout) const {
+			std::size_t size = layout->GetHeapSize();
+			layout->~Layout();
+			if (p_buffer_pool)
+				p_buffer_pool->Deallocate(layout, size);
+			else
+				::operator delete(layout);
+		}
+	};
+	using LayoutPtr = std::unique_ptr<Layout, LayoutDeleter>;
+
+	PaletteBufferPool *m_buffer_pool;
+	std::atomic<Layout *> m_layout;
+	LayoutPtr m_layout_holder;
+	std::vector<LayoutPtr> m_retired;
+
+	inline LayoutPtr make_layout(uint32_t bits) const {
+		std::size_t size = Layout::GetBufferSize(bits);
+		void *buffer = m_buffer_pool ? m_buffer_pool->Allocate(size) : ::operator new(size);
+		return LayoutPtr{new (buffer) Layout(bits), LayoutDeleter{m_buffer_pool}};
+	}
+	inline void publish(LayoutPtr &&layout) {
+		m_layout.store(layout.get(), std::memory_order_release);
+		if (m_layout_holder)
+			m_retired.push_back(std::move(m_layout_holder));
+		m_layout_holder = std::move(layout);
+	}
+	inline LayoutPtr make_uniform(T value) const {
+		auto layout = make_layout(0);
+		layout->palette[0] = value;
+		layout->palette_size = 1;
+		return layout;
+	}
+	// Re-encode all values of src into a new layout of the given width
+	inline LayoutPtr make_widened(const Layout &src, uint32_t bits) const {
+		auto layout = make_layout(bits);
+		if (layout->IsDirect()) {
+			for (uint32_t i = 0; i < Length; ++i)
+				layout->SetIndex(i, std::bit_cast<Raw>(src.Get(i)));
+		} else {
+			std::copy(src.palette, src.palette + src.palette_size, layout->palette);
+			layout->palette_size = src.palette_size;
+			if (src.bits)
+				for (uint32_t i = 0; i < Length; ++i)
+					layout->SetIndex(i, src.GetIndex(i));
+		}
+		return layout;
+	}
+
+public:
+	inline static constexpr uint32_t kLength = Length;
+
+	// Layouts are allocated from p_buffer_pool if not null, which must outlive the array
+	inline explicit PaletteArray(T value = {}, PaletteBufferPool *p_buffer_pool = nullptr)
+	    : m_buffer_pool{p_buffer_pool} {
+		publish(make_uniform(value));
+	}
+	PaletteArray(const PaletteArray &) = delete;
+	PaletteArray &operator=(const PaletteArray &) = delete;
+
+	inline T Get(uint32_t idx) const { return m_layout.load(std::memory_order_acquire)->Get(idx); }
+	inline T operator[](uint32_t idx) const { return Get(idx); }
+
+	inline void Set(uint32_t idx, T value) {
+		Layout *layout = m_layout_holder.get();
+		if (layout->IsDirect()) {
+			layout->SetIndex(idx, std::bit_cast<Raw>(value));
+			return;
+		}
+		const T *palette = layout->palette;
+		uint32_t p = std::find(palette, palette + layout->palette_size, value) - palette;
+		if (p == layout->palette_size) {
+			if (p == layout->GetPaletteCapacity()) {
+				publish(make_widened(*layout, layout->bits ? layout->bits << 1u : 1u));
+				return Set(idx, value);
+			}
+			layout->palette[p] = value;
+			++layout->palette_size;
+		}
+		if (layout->bits)
+			layout->SetIndex(idx, p);
+	}
+
+	// Reset every element to value
+	inline void Fill(T value) { publish(make_uniform(value)); }
+
+	// Replace every element with values[0, Length), encoded with the narrowest index width
+	inline void Assign(const T *values) {
+		std::vector<T> used;
+		for (uint32_t i = 0; i < Length && used.size() <= (1u << (kDirectBits / 2)); ++i)
+			if (std::find(used.begin(), used.end(), values[i]) == used.end())
+				used.push_back(values[i]);
+
+		uint32_t bits = 0;
+		while ((1u << bits) < used.size())
+			bits = bits ? bits << 1u : 1u;
+
+		auto layout = make_layout(std::min(bits, kDirectBits));
+		if (layout->IsDirect()) {
+			for (uint32_t i = 0; i < Length; ++i)
+				layout->SetIndex(i, std::bit_cast<Raw>(values[i]));
+		} else {
+			std::copy(used.begin(), used.end(), layout->palette);
+			layout->palette_size = used.size();
+			if (bits)
+				for (uint32_t i = 0; i < Length; ++i)
+					layout->SetIndex(i, std::find(used.begin(), used.end(), values[i]) - used.begin());
+		}
+		publish(std::move(layout));
+	}
+
+	// Drop unused palette entries, shrink index width and free retired layouts.
+	// Must not race with readers.
+	inline void Compact() {
+		const Layout &src = *m_layout_holder;
+		std::vector<T> used;
+		std::vector<uint64_t> remap;
+		if (!src.IsDirect()) {
+			std::vector<bool> flags(src.palette_size, src.bits == 0);
+			if (src.bits)
+				for (uint32_t i = 0; i < Length; ++i)
+					flags[src.GetIndex(i)] = true;
+			remap.resize(src.palette_size);
+			for (uint32_t p = 0; p < src.palette_size; ++p)
+				if (flags[p]) {
+					remap[p] = used.size();
+					used.push_back(src.palette[p]);
+				}
+		} else {
+			for (uint32_t i = 0; i < Length && used.size() <= (1u << (kDirectBits / 2)); ++i) {
+				T v = src.Get(i);
+				if (std::find(used.begin(), used.end(), v) == used.end())
+					used.push_back(v);
+			}
+		}
+
+		uint32_t bits = 0;
+		while ((1u << bits) < used.size())
+			bits = bits ? bits << 1u : 1u;
+
+		if (bits >= src.bits) {
+			m_retired.clear();
+			return;
+		}
+
+		auto layout = make_layout(bits);
+		std::copy(used.begin(), used.end(), layout->palette);
+		layout->palette_size = used.size();
+		if (bits) {
+			for (uint32_t i = 0; i < Length; ++i) {
+				uint64_t v;
+				if (src.IsDirect()) {
+					T value = src.Get(i);
+					v = std::find(used.begin(), used.end(), value) - used.begin();
+				} else
+					v = remap[src.GetIndex(i)];
+				layout->SetIndex(i, v);
+			}
+		}
+		publish(std::move(layout));
+		m_retired.clear();
+	}
+
+	inline uint32_t GetBits() const { return m_layout.load(std::memory_order_acquire)->bits; }
+	inline bool IsUniform() const { return GetBits() == 0; }
+	// Only meaningful when IsUniform()
+	inline T GetUniform() const { return m_layout.load(std::memory_order_acquire)->palette[0]; }
+	inline std::size_t GetHeapSize() const {
+		std::size_t size = m_layout_holder->GetHeapSize();
+		for (const auto &layout : m_retired)
+			size += layout->GetHeapSize();
+		return size;
+	}
+
+	// Decode [begin, begin + count) into dst
+	inline void Copy(uint32_t begin, uint32_t count, T *dst) const {
+		const Layout *layout = m_layout.load(std::memory_order_acquire);
+		if (layout->bits == 0) {
+			std::fill(dst, dst + count, layout->palette[0]);
+			return;
+		}
+		if (layout->IsDirect()) {
+			for (uint32_t i = 0; i < count; ++i)
+				dst[i] = std::bit_cast<T>(Raw(layout->GetIndex(begin + i)));
+		} else {
+			for (uint32_t i = 0; i < count; ++i)
+				dst[i] = layout->palette[layout->GetIndex(begin + i)];
+		}
+	}
+};
+
+} // namespace hc::client
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HYPERCRAFT_CLIENT_PALETTE_BUFFER_POOL_HPP
+#define HYPERCRAFT_CLIENT_PALETTE_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace hc::client {
+
+// Recycles the buffers of PaletteArray layouts. The layouts only come in a few sizes (one per index width and value
+// type), so freed buffers are kept in exact-size free lists, up to the capacity in bytes beyond which they return to
+// the global heap.
+class PaletteBufferPool {
+public:
+	struct Stats {
+		std::size_t hits, misses, buffers, bytes;
+	};
+
+private:
+	struct FreeList {
+		std::size_t size;
+		std::vector<void *> buffers;
+	};
+	std::mutex m_mutex;
+	std::vector<FreeList> m_free_lists;
+	std::size_t m_capacity, m_bytes{}, m_buffers{}, m_hits{}, m_misses{};
+
+	FreeList &get_free_list(std::size_t size);
+
+public:
+	inline explicit PaletteBufferPool(std::size_t capacity) : m_capacity{capacity} {}
+	PaletteBufferPool(const PaletteBufferPool &) = delete;
+	PaletteBufferPool &operator=(const PaletteBufferPool &) = delete;
+	~PaletteBufferPool();
+
+	void *Allocate(std::size_t size);
+	void Deallocate(void *buffer, std::size_t size);
+
+	inline void SetCapacity(std::size_t capacity) {
+		std::scoped_lock lock{m_mutex};
+		m_capacity = capacity;
+	}
+	Stats GetStats();
+	// Frees the buffers kept, returns the bytes freed
+	std::size_t Release();
+};
+
+} // namespace hc::client
+
+#endif
@@ -5,9 +5,11 @@
 #include <cinttypes>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <shared_mutex>
 #include <unordered_map>
 
+#include <common/Position.hpp>
 #include <spdlog/spdlog.h>
 
 namespace hc::client {
@@ -21,8 +23,18 @@ public:
 	inline explicit TerrainBase(uint32_t seed) : m_seed{seed} {}
 	virtual ~TerrainBase() = default;
 	inline uint32_t GetSeed() const { return m_seed; }
+	// Bumped whenever the generated chunks change
+	virtual uint32_t GetVersion() const = 0;
+	// Identifies the chunks generated with this seed and version, see WorldDatabase::GetChunks()
+	inline uint32_t GetBakedVersion() const { return GetVersion() * 0x9e3779b1u ^ m_seed; }
 
 	virtual void Generate(const std::shared_ptr<Chunk> &chunk_ptr) = 0;
+	// Bound of the heights of the generated non-air blocks, if any, so that the chunks above are not loaded
+	virtual std::optional<BlockPos1> GetMaxHeight() const { return std::nullopt; }
+	// Approximate bytes of the caches of intermediate data
+	virtual std::size_t GetCacheBytes() const { return 0; }
+	// Drop the oldest cache entries to free about bytes, returns the bytes freed
+	virtual std::size_t TrimCaches(std::size_t bytes) { return 0; }
 };
 
 template <typename Key, typename T, uint32_t SIZE> class TerrainCache {
@@ -31,8 +43,27 @@ private:
 	uint32_t m_cache_queue_pointer{0};
 	std::unordered_map<Key, std::weak_ptr<T>> m_cache_map;
 	std::shared_mutex m_cache_map_mutex;
+	std::atomic_size_t m_cache_queue_size{0};
 
 public:
+	// Number of entries held in the queue
+	inline std::size_t GetSize() const { return m_cache_queue_size.load(std::memory_order_relaxed); }
+	// Drop up to count entries from the oldest, returns the number of entries dropped
+	inline std::size_t Trim(std::size_t count) {
+		std::scoped_lock cache_write_lock{m_cache_map_mutex};
+		std::size_t trimmed = 0;
+		for (uint32_t i = 0; i < SIZE && trimmed < count; ++i) {
+			auto &entry = m_cache_queue[(m_cache_queue_pointer + i) % SIZE];
+			if (!entry.second)
+				continue;
+			m_cache_map.erase(entry.first);
+			entry = {};
+			++trimmed;
+		}
+		m_cache_queue_size.fetch_sub(trimmed, std::memory_order_relaxed);
+		return trimmed;
+	}
+
 	template <typename Generator> std::shared_ptr<const T> Acquire(const Key &key, Generator &&generator) {
 		{ // try to acquire it first
 			std::shared_lock cache_read_lock{m_cache_map_mutex};
@@ -56,6 +87,8 @@ public:
 				// remove deprecated cache
 				if (m_cache_queue[m_cache_queue_pointer].second)
 					m_cache_map.erase(m_cache_queue[m_cache_queue_pointer].first);
+				else
+					m_cache_queue_size.fetch_add(1, std::memory_order_relaxed);
 
 				// update map
 				m_cache_map[key] = generated;
@@ -10,11 +10,13 @@
 #include <cuckoohash_map.hh>
 
 #include <atomic>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <client/Chunk.hpp>
+#include <client/ChunkMeshSink.hpp>
 #include <client/ChunkPool.hpp>
 #include <client/ChunkTaskPool.hpp>
 
@@ -22,19 +24,33 @@
 
 namespace hc::client {
 
-class WorldRenderer;
 class ClientBase;
 
 class World : public std::enable_shared_from_this<World> {
 public:
-	inline static std::shared_ptr<World> Create(ChunkPos1 load_chunk_radius, ChunkPos1 unload_chunk_radius) {
-		return std::make_shared<World>(load_chunk_radius, unload_chunk_radius);
+	// Approximate bytes held by the subsystems
+	struct MemoryStats {
+		std::size_t chunks, chunk_tasks, terrain_caches, hibernated_chunks, meshes;
+		inline std::size_t GetTotal() const {
+			return chunks + chunk_tasks + terrain_caches + hibernated_chunks + meshes;
+		}
+	};
+
+	inline static std::shared_ptr<World> Create(const ChunkLoadShape &load_shape, ChunkPos1 unload_chunk_radius,
+	                                            ChunkPoolStorage chunk_storage = ChunkPoolStorage::kHashMap) {
+		return std::make_shared<World>(load_shape, unload_chunk_radius, chunk_storage);
+	}
+	inline static std::shared_ptr<World> Create(ChunkPos1 load_chunk_radius, ChunkPos1 unload_chunk_radius,
+	                                            ChunkPoolStorage chunk_storage = ChunkPoolStorage::kHashMap) {
+		return Create(ChunkLoadShape{.radius = load_chunk_radius, .height = load_chunk_radius}, unload_chunk_radius,
+		              chunk_storage);
 	}
 
 private:
 	// Parent weak_ptrs
-	std::weak_ptr<WorldRenderer> m_world_renderer_weak_ptr;
+	std::weak_ptr<ChunkMeshSink> m_mesh_sink_weak_ptr;
 	friend class WorldRenderer;
+	friend class NullChunkMeshSink;
 
 	std::weak_ptr<ClientBase> m_client_weak_ptr;
 	friend class LocalClient;
@@ -49,18 +65,32 @@ private:
 	std::atomic_uint64_t m_tick;
 	static_assert(sizeof(ChunkPos3) <= sizeof(uint64_t));
 	std::atomic_uint64_t m_center_chunk_pos;
-	std::atomic<ChunkPos1> m_load_chunk_radius, m_unload_chunk_radius;
+	std::atomic<ChunkPos1> m_load_chunk_radius, m_unload_chunk_radius, m_load_chunk_height, m_max_load_chunk_y;
+	std::atomic<ChunkLoadShape::Type> m_load_shape_type;
+	// Chunks the load and unload shapes are shrunk by to stay within the memory budget, 0 for no budget
+	std::atomic<ChunkPos1> m_budget_shrink{0};
+	std::atomic_size_t m_memory_budget{0};
+	mutable std::mutex m_center_view_mutex;
+	ChunkTaskView m_center_view{};
 
 	// Chunks
 	ChunkPool m_chunk_pool;
 	ChunkTaskPool m_chunk_task_pool;
+	ChunkLifecycleRecorder m_chunk_lifecycle_recorder;
 
 	void update();
+	// Called every kMemoryBudgetTicks ticks
+	void enforce_memory_budget();
+	inline ChunkLoadShape get_requested_load_shape() const {
+		return {m_load_shape_type.load(std::memory_order_acquire), GetLoadChunkRadius(), GetLoadChunkHeight()};
+	}
 
 public:
-	inline explicit World(ChunkPos1 load_chunk_radius, ChunkPos1 unload_chunk_radius)
-	    : m_chunk_pool{this}, m_chunk_task_pool{this}, m_load_chunk_radius{load_chunk_radius},
-	      m_unload_chunk_radius{unload_chunk_radius} {}
+	inline explicit World(const ChunkLoadShape &load_shape, ChunkPos1 unload_chunk_radius,
+	                      ChunkPoolStorage chunk_storage = ChunkPoolStorage::kHashMap)
+	    : m_load_chunk_radius{load_shape.radius}, m_unload_chunk_radius{unload_chunk_radius},
+	      m_load_chunk_height{load_shape.height}, m_max_load_chunk_y{INT16_MAX}, m_load_shape_type{load_shape.type},
+	      m_chunk_pool{this, chunk_storage, GetLoadShape(), GetUnloadShape()}, m_chunk_task_pool{this} {}
 	~World() = default;
 
 	inline void Start() { update(); }
@@ -80,9 +110,10 @@ public:
 		uint64_t u64 = m_center_chunk_pos.load(std::memory_order_acquire);
 		return *((const ChunkPos3 *)(&u64));
 	}
+	// Growing the shapes beyond the extents of a ring map ChunkPool rebuilds it larger on the next update
 	inline void SetLoadChunkRadius(ChunkPos1 radius) {
 		radius = std::min(radius, (ChunkPos1)kWorldMaxLoadRadius);
-		if (radius != GetLoadChunkRadius())
+		if (radius == GetLoadChunkRadius())
 			return;
 		m_load_chunk_radius.store(radius, std::memory_order_release);
 
@@ -91,7 +122,7 @@ public:
 	inline ChunkPos1 GetLoadChunkRadius() const { return m_load_chunk_radius.load(std::memory_order_acquire); }
 
 	inline void SetUnloadChunkRadius(ChunkPos1 radius) {
-		if (radius != GetUnloadChunkRadius())
+		if (radius == GetUnloadChunkRadius())
 			return;
 		m_unload_chunk_radius.store(radius, std::memory_order_release);
 
@@ -99,16 +130,96 @@ public:
 	}
 	inline ChunkPos1 GetUnloadChunkRadius() const { return m_unload_chunk_radius.load(std::memory_order_acquire); }
 
-	inline const std::weak_ptr<WorldRenderer> &GetWorldRendererWeakPtr() const { return m_world_renderer_weak_ptr; }
-	inline std::shared_ptr<WorldRenderer> LockRenderer() const { return m_world_renderer_weak_ptr.lock(); }
+	inline void SetLoadChunkHeight(ChunkPos1 height) {
+		height = std::min(height, (ChunkPos1)kWorldMaxLoadRadius);
+		if (height == GetLoadChunkHeight())
+			return;
+		m_load_chunk_height.store(height, std::memory_order_release);
+
+		update();
+	}
+	inline ChunkPos1 GetLoadChunkHeight() const { return m_load_chunk_height.load(std::memory_order_acquire); }
+
+	inline void SetLoadShapeType(ChunkLoadShape::Type type) {
+		if (type == m_load_shape_type.load(std::memory_order_acquire))
+			return;
+		m_load_shape_type.store(type, std::memory_order_release);
+
+		update();
+	}
+	// The load shape, and the load shape grown to the unload radius, both shrunk to stay within the memory budget
+	inline ChunkLoadShape GetLoadShape() const {
+		return get_requested_load_shape().Shrink(GetBudgetShrink(), kMemoryBudgetMinLoadRadius);
+	}
+	inline ChunkLoadShape GetUnloadShape() const {
+		ChunkLoadShape load_shape = get_requested_load_shape();
+		return load_shape.Shrink(GetBudgetShrink(), kMemoryBudgetMinLoadRadius)
+		    .Grow(ChunkPos1(std::max(GetUnloadChunkRadius() - load_shape.radius, 0)));
+	}
+
+	// Bytes the subsystems should stay within, 0 for no budget. Over the budget, the terrain caches and the hibernated
+	// chunks are trimmed first, then the load shape shrinks by a chunk every kMemoryBudgetTicks ticks (its
+	// horizontal and vertical radii separately down to kMemoryBudgetMinLoadRadius), unloading the
+	// farthest chunks and declining to load beyond. It grows back while the budget allows.
+	inline void SetMemoryBudget(std::size_t bytes) { m_memory_budget.store(bytes, std::memory_order_release); }
+	inline std::size_t GetMemoryBudget() const { return m_memory_budget.load(std::memory_order_acquire); }
+	inline ChunkPos1 GetBudgetShrink() const { return m_budget_shrink.load(std::memory_order_acquire); }
+	MemoryStats GetMemoryStats() const;
+
+	// Bytes of the unloaded chunks kept to be restored without loading them, see ChunkHibernationCache
+	inline void SetChunkHibernationCapacity(std::size_t bytes) {
+		m_chunk_pool.GetHibernationCache().SetCapacity(bytes);
+	}
+	// Encodes up to max_count unloaded chunks queued for the ChunkHibernationCache, the WorldWorker threads call it
+	// between tasks. Returns the number of chunks encoded.
+	inline std::size_t EncodeHibernatingChunks(std::size_t max_count) {
+		return m_chunk_pool.GetHibernationCache().EncodePending(max_count);
+	}
+	inline ChunkHibernationCache::Stats GetChunkHibernationStats() const {
+		return m_chunk_pool.GetHibernationCache().GetStats();
+	}
+
+	// Chunks above are neither loaded nor scheduled, set by the client to the top of the terrain
+	inline void SetMaxLoadChunkY(ChunkPos1 y) {
+		if (y == GetMaxLoadChunkY())
+			return;
+		m_max_load_chunk_y.store(y, std::memory_order_release);
+
+		update();
+	}
+	inline ChunkPos1 GetMaxLoadChunkY() const { return m_max_load_chunk_y.load(std::memory_order_acquire); }
+
+	// Camera direction, field of view and velocity (in blocks per second) used to prioritize chunk tasks, returns
+	// whether the quantized view changed
+	bool SetCenterView(const glm::vec3 &direction, float fov, float aspect_ratio, const glm::vec3 &velocity);
+	inline ChunkTaskView GetCenterView() const {
+		std::scoped_lock lock{m_center_view_mutex};
+		return m_center_view;
+	}
+	// Whether all chunks within radius around the center chunk and in the view are meshed. A mesh needs the lights of
+	// its neighbours, which need their own neighbours generated, so the chunks outside the load shape shrunk by 4
+	// chunks are skipped.
+	bool IsViewMeshed(ChunkPos1 radius) const;
+
+	inline const std::weak_ptr<ChunkMeshSink> &GetMeshSinkWeakPtr() const { return m_mesh_sink_weak_ptr; }
+	inline std::shared_ptr<ChunkMeshSink> LockMeshSink() const { return m_mesh_sink_weak_ptr.lock(); }
+	// Called by the ChunkMeshSink once a mesh of the chunk is visible, records the lifecycle of its first mesh
+	inline void OnChunkVisible(const ChunkPos3 &chunk_pos) {
+		auto chunk = m_chunk_pool.FindRawChunk(chunk_pos);
+		if (chunk && chunk->IsMeshed() && chunk->GetLifecycle().Reach(ChunkStage::kVisible))
+			m_chunk_lifecycle_recorder.Add(chunk->GetLifecycle());
+	}
+	inline ChunkLifecycleStats GetChunkLifecycleStats() const { return m_chunk_lifecycle_recorder.GetStats(); }
 
 	inline const std::weak_ptr<ClientBase> &GetClientWeakPtr() const { return m_client_weak_ptr; }
 	inline std::shared_ptr<ClientBase> LockClient() const { return m_client_weak_ptr.lock(); }
 
 	inline uint64_t GetCurrentTick() const { return m_tick.load(std::memory_order_acquire); }
 	inline void NextTick() {
-		m_tick.fetch_add(1, std::memory_order_acq_rel);
+		uint64_t tick = m_tick.fetch_add(1, std::memory_order_acq_rel) + 1;
 		m_chunk_task_pool.ProduceTickTasks();
+		if (tick % kMemoryBudgetTicks == 0)
+			enforce_memory_budget();
 	}
 
 	const auto &GetChunkPool() const { return m_chunk_pool; }
@@ -20,7 +20,7 @@
 
 namespace hc::client {
 
-class WorldRenderer : public std::enable_shared_from_this<WorldRenderer> {
+class WorldRenderer final : public ChunkMeshSink, public std::enable_shared_from_this<WorldRenderer> {
 private:
 	std::shared_ptr<ChunkMeshPool> m_chunk_mesh_pool;
 	std::shared_ptr<World> m_world_ptr;
@@ -40,7 +40,7 @@ public:
 	inline static std::shared_ptr<WorldRenderer> Create(const myvk::Ptr<myvk::Device> &device,
 	                                                    const std::shared_ptr<World> &world_ptr) {
 		auto ret = std::make_shared<WorldRenderer>(device, world_ptr);
-		world_ptr->m_world_renderer_weak_ptr = ret;
+		world_ptr->m_mesh_sink_weak_ptr = ret;
 		return ret;
 	}
 
@@ -51,7 +51,7 @@ public:
 		m_thread = std::thread{&WorldRenderer::thread_func, this};
 	}
 
-	inline ~WorldRenderer() {
+	inline ~WorldRenderer() final {
 		auto locked_meshes = m_chunk_mesh_map.lock_table();
 		for (auto &i : locked_meshes) {
 			for (auto &m : i.second)
@@ -66,7 +66,10 @@ public:
 
 	inline const std::shared_ptr<World> &GetWorldPtr() const { return m_world_ptr; }
 
-	inline void PushChunkMesh(const ChunkPos3 &chunk_pos, std::vector<BlockMesh> &&meshes) {
+	inline void PushChunkMesh(const ChunkPos3 &chunk_pos, std::vector<BlockMesh> &&meshes) final {
+		// Nothing to upload
+		if (meshes.empty())
+			m_world_ptr->OnChunkVisible(chunk_pos);
 		ChunkMeshHandleTransaction transaction{m_chunk_mesh_pool};
 
 		glm::i32vec3 base_position = (glm::i32vec3)chunk_pos * (int32_t)Chunk::kSize;
@@ -93,7 +96,11 @@ public:
 	inline void CmdUpdateClusters(const myvk::Ptr<myvk::CommandBuffer> &command_buffer,
 	                              std::vector<std::shared_ptr<ChunkMeshCluster>> *p_prepared_clusters,
 	                              std::vector<ChunkMeshPool::PostUpdateEntry> *p_post_updates) {
+		std::size_t post_update_count = p_post_updates->size();
 		m_chunk_mesh_pool->CmdLocalUpdate(command_buffer, p_prepared_clusters, p_post_updates, m_max_transfer_bytes);
+		for (std::size_t i = post_update_count; i < p_post_updates->size(); ++i)
+			if (const auto *p_insert = std::get_if<ChunkMeshPool::LocalInsert>(&(*p_post_updates)[i]))
+				m_world_ptr->OnChunkVisible(p_insert->mesh_info.m_info.base_position / (int32_t)Chunk::kSize);
 	}
 
 	inline void PushPostUpdates(std::vector<ChunkMeshPool::PostUpdateEntry> &&post_updates) {
@@ -102,7 +109,12 @@ public:
 		m_post_update_queue.enqueue(std::move(post_updates));
 	}
 
-	inline void EraseUnloadedMeshes() { m_post_update_queue.enqueue({}); }
+	inline void EraseUnloadedMeshes() final { m_post_update_queue.enqueue({}); }
+	// Clusters are allocated as a whole
+	inline std::size_t GetMeshBytes() const final {
+		return m_chunk_mesh_pool->GetClusterCount() *
+		       (m_chunk_mesh_pool->GetVertexBlockSize() + m_chunk_mesh_pool->GetIndexBlockSize());
+	}
 
 	inline myvk::Ptr<ChunkMeshInfoBuffer> CreateChunkMeshInfoBuffer(VkBufferUsageFlags usages) {
 		return ChunkMeshInfoBuffer::Create(m_chunk_mesh_pool, usages);
@@ -3,6 +3,7 @@
 #include <client/World.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -16,6 +17,9 @@ public:
 	}
 
 private:
+	inline static constexpr uint32_t kSpinRounds = 256, kYieldRounds = 16;
+	inline static constexpr std::chrono::milliseconds kParkTimeout{100};
+
 	std::atomic_bool m_running{true};
 	std::shared_ptr<World> m_world_ptr;
 	std::vector<std::thread> m_worker_threads;
@@ -4,6 +4,7 @@
 #include "MeshCluster.hpp"
 #include "MeshInfo.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <shared_mutex>
 #include <unordered_set>
@@ -99,6 +100,10 @@ public:
 	inline uint32_t GetMaxMeshesPerCluster() const { return m_max_meshes_per_cluster; }
 	inline VkDeviceSize GetVertexBlockSize() const { return m_vertex_block_size; }
 	inline VkDeviceSize GetIndexBlockSize() const { return m_index_block_size; }
+	inline std::size_t GetClusterCount() const {
+		std::shared_lock read_lock{m_clusters_mutex};
+		return std::count_if(m_clusters.begin(), m_clusters.end(), [](const auto &i) { return !i.expired(); });
+	}
 
 	inline void PostUpdate(std::vector<PostUpdateEntry> &&post_updates) {
 		if (post_updates.empty())
@@ -13,7 +13,7 @@ private:
 
 	myvk::Ptr<myvk::GraphicsPipeline> m_pipeline;
 
-	float m_day_night = 0.0;
+	float m_day_night = 0.0, m_z_near = 0.0f, m_z_far = 0.0f;
 
 public:
 	inline void Initialize(myvk_rg::ImageInput block_texture_image, myvk_rg::ImageInput light_map_image,
@@ -49,6 +49,10 @@ public:
 		AddInput<myvk_rg::Usage::kDrawIndirectBuffer>({"draw_count"}, draw_count_buffer);
 	}
 	inline void SetDayNight(float day_night) { m_day_night = day_night; }
+	inline void SetClipPlanes(float z_near, float z_far) {
+		m_z_near = z_near;
+		m_z_far = z_far;
+	}
 	inline void Update(const std::vector<std::shared_ptr<ChunkMeshCluster>> &prepared_clusters) {
 		m_p_prepared_clusters = &prepared_clusters;
 	}
@@ -57,7 +61,7 @@ public:
 		auto pipeline_layout =
 		    myvk::PipelineLayout::Create(GetRenderGraphPtr()->GetDevicePtr(), {GetVkDescriptorSetLayout()},
 		                                 {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t)},
-		                                  {VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), sizeof(float)}});
+		                                  {VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), 3 * sizeof(float)}});
 
 		const auto &device = GetRenderGraphPtr()->GetDevicePtr();
 
@@ -117,6 +121,7 @@ public:
 
 		const auto &draw_cmd_buffer = GetInput({"draw_cmd"})->GetResource<myvk_rg::BufferBase>()->GetVkBuffer();
 		const auto &draw_count_buffer = GetInput({"draw_count"})->GetResource<myvk_rg::BufferBase>()->GetVkBuffer();
+		float frag_pc_data[] = {m_day_night, m_z_near, m_z_far};
 
 		for (const auto &cluster : *m_p_prepared_clusters) {
 			command_buffer->CmdBindVertexBuffer(cluster->GetVertexBuffer(), 0);
@@ -125,7 +130,7 @@ public:
 			command_buffer->CmdPushConstants(m_pipeline->GetPipelineLayoutPtr(), VK_SHADER_STAGE_VERTEX_BIT, 0,
 			                                 sizeof(uint32_t), vert_pc_data);
 			command_buffer->CmdPushConstants(m_pipeline->GetPipelineLayoutPtr(), VK_SHADER_STAGE_FRAGMENT_BIT,
-			                                 sizeof(uint32_t), sizeof(float), &m_day_night);
+			                                 sizeof(uint32_t), sizeof(frag_pc_data), frag_pc_data);
 			command_buffer->CmdDrawIndexedIndirectCount(
 			    draw_cmd_buffer, vert_pc_data[0] * sizeof(VkDrawIndexedIndirectCommand), //
 			    draw_count_buffer, cluster->GetClusterOffset() * sizeof(uint32_t),       //
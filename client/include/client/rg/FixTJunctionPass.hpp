@@ -9,6 +9,8 @@ class FixTJunctionPass final : public myvk_rg::GraphicsPassBase {
 private:
 	myvk::Ptr<myvk::GraphicsPipeline> m_pipeline;
 
+	float m_z_near = 0.0f, m_z_far = 0.0f;
+
 public:
 	inline void Initialize(myvk_rg::ImageInput color_image, myvk_rg::ImageInput depth_image,
 	                       myvk_rg::ImageInput fixed_color_image, myvk_rg::ImageInput fixed_depth_image) {
@@ -27,9 +29,15 @@ public:
 		Initialize(color_image, depth_image, fixed_color_image, fixed_depth_image);
 	}
 
+	inline void SetClipPlanes(float z_near, float z_far) {
+		m_z_near = z_near;
+		m_z_far = z_far;
+	}
+
 	inline void CreatePipeline() final {
 		auto pipeline_layout =
-		    myvk::PipelineLayout::Create(GetRenderGraphPtr()->GetDevicePtr(), {GetVkDescriptorSetLayout()}, {});
+		    myvk::PipelineLayout::Create(GetRenderGraphPtr()->GetDevicePtr(), {GetVkDescriptorSetLayout()},
+		                                 {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, 2 * sizeof(float)}});
 
 		const auto &device = GetRenderGraphPtr()->GetDevicePtr();
 
@@ -67,6 +75,9 @@ public:
 	inline void CmdExecute(const myvk::Ptr<myvk::CommandBuffer> &command_buffer) const final {
 		command_buffer->CmdBindPipeline(m_pipeline);
 		command_buffer->CmdBindDescriptorSets({GetVkDescriptorSet()}, m_pipeline);
+		float pc_data[] = {m_z_near, m_z_far};
+		command_buffer->CmdPushConstants(m_pipeline->GetPipelineLayoutPtr(), VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+		                                 sizeof(pc_data), pc_data);
 		command_buffer->CmdDraw(3, 1, 0, 0);
 	}
 
@@ -31,6 +31,9 @@ public:
 		camera_ptr->Update((Camera::UniformData *)GetResource<myvk_rg::StaticBuffer<myvk::Buffer>>({"camera"})
 		                       ->GetBuffer()
 		                       ->GetMappedData());
+		// The transparent and post process shaders linearize depth with the planes of the projection
+		GetPass<ChunkTransparentPass>({"chunk_transparent_pass"})->SetClipPlanes(kCameraNear, camera_ptr->m_far);
+		GetPass<FixTJunctionPass>({"fix_t_junction_pass"})->SetClipPlanes(kCameraNear, camera_ptr->m_far);
 	}
 	inline void UpdateDepthHierarchy() { GetPass<DepthHierarchyPass>({"depth_hierarchy_pass"})->UpdateLevelCount(); }
 	inline void SetDayNight(float day_night) {
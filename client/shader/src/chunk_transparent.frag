@@ -14,14 +14,15 @@ layout(location = 6) in vec2 vTexcoord;
 layout(location = 0) out vec4 oAccum;
 layout(location = 1) out float oReveal;
 
-layout(push_constant) uniform uuPushConstant { layout(offset = 4) float uDayNight; };
+layout(push_constant) uniform uuPushConstant {
+	layout(offset = 4) float uDayNight;
+	float uZNear, uZFar;
+};
 
 const vec3 kFaceNormal[6] = {vec3(1, 0, 0),  vec3(-1, 0, 0), vec3(0, 1, 0),
                              vec3(0, -1, 0), vec3(0, 0, 1),  vec3(0, 0, -1)};
 
-#define Z_NEAR 0.01
-#define Z_FAR 640.0
-float linearize_depth(in const float d) { return Z_NEAR * Z_FAR / (Z_FAR + d * (Z_NEAR - Z_FAR)); }
+float linearize_depth(in const float d) { return uZNear * uZFar / (uZFar + d * (uZNear - uZFar)); }
 
 void main() {
 	vec4 tex = texture(uBlockTexture, vec3(vTexcoord, vTexture));
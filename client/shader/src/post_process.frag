@@ -5,11 +5,11 @@ layout(set = 0, binding = 1) uniform sampler2D uDepth;
 layout(location = 0) out vec4 oColor;
 layout(location = 1) out float oDepth;
 
-#define Z_NEAR 0.01
-#define Z_FAR 640.0
-float linearize_depth(in const float d) { return Z_NEAR * Z_FAR / (Z_FAR + d * (Z_NEAR - Z_FAR)); }
-vec2 linearize_depth(in const vec2 d) { return Z_NEAR * Z_FAR / (Z_FAR + d * (Z_NEAR - Z_FAR)); }
-float nonlinearize_depth(in const float ld) { return ((ld - Z_NEAR) * Z_FAR) / (ld * (Z_FAR - Z_NEAR)); }
+layout(push_constant) uniform uuPushConstant { float uZNear, uZFar; };
+
+float linearize_depth(in const float d) { return uZNear * uZFar / (uZFar + d * (uZNear - uZFar)); }
+vec2 linearize_depth(in const vec2 d) { return uZNear * uZFar / (uZFar + d * (uZNear - uZFar)); }
+float nonlinearize_depth(in const float ld) { return ((ld - uZNear) * uZFar) / (ld * (uZFar - uZNear)); }
 
 void main() {
 	ivec2 coord = ivec2(gl_FragCoord.xy);
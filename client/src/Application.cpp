@@ -11,8 +11,10 @@
 
 #include <client/ENetClient.hpp>
 #include <client/LocalClient.hpp>
+#include <common/Trace.hpp>
 #include <common/WorldDatabase.hpp>
 
+#include <fstream>
 #include <random>
 
 namespace hc::client {
@@ -255,6 +257,93 @@ Application::Application() {
 	m_world->Start();
 }
 
+void Application::task_stats_gui() {
+	ChunkTaskStats stats = m_world->GetChunkTaskPool().GetTaskStats();
+	if (stats.seconds - m_task_stats.seconds >= 1.0) {
+		m_task_stats_window = stats.Since(m_task_stats);
+		m_task_stats = stats;
+	}
+	if (!ImGui::CollapsingHeader("chunk tasks"))
+		return;
+	if (ImGui::BeginTable("chunk tasks", 5)) {
+		ImGui::TableSetupColumn("type");
+		ImGui::TableSetupColumn("tasks/s");
+		ImGui::TableSetupColumn("rejected/s");
+		ImGui::TableSetupColumn("queue p50");
+		ImGui::TableSetupColumn("run p50");
+		ImGui::TableHeadersRow();
+		for (std::size_t t = 0; t < kChunkTaskTypeCount; ++t) {
+			auto type = static_cast<ChunkTaskType>(t);
+			const auto &s = m_task_stats_window.Get(type);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(GetChunkTaskTypeName(type));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", m_task_stats_window.GetTasksPerSecond(type));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", m_task_stats_window.GetRate(s.rejected));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu us", (unsigned long long)s.queue_time.GetQuantileUs(0.5));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu us", (unsigned long long)s.run_time.GetQuantileUs(0.5));
+		}
+		ImGui::EndTable();
+	}
+	if (ImGui::Button("dump task stats")) {
+		std::ofstream{"task_stats.csv"} << stats.ToCSV();
+		std::ofstream{"task_stats.json"} << stats.ToJSON();
+		spdlog::info("Chunk task stats dumped to task_stats.csv and task_stats.json");
+	}
+#ifdef HYPERCRAFT_TRACE
+	ImGui::SameLine();
+	if (ImGui::Button("dump trace")) {
+		std::ofstream{"trace.json"} << Trace::ToChromeJSON();
+		spdlog::info("Trace dumped to trace.json");
+	}
+#endif
+}
+
+void Application::chunk_lifecycle_gui() {
+	ChunkLifecycleStats stats = m_world->GetChunkLifecycleStats();
+	auto cur_time = std::chrono::steady_clock::now();
+	if (cur_time - m_chunk_lifecycle_time >= std::chrono::seconds(1)) {
+		m_chunk_lifecycle_stats_window = stats.Since(m_chunk_lifecycle_stats);
+		m_chunk_lifecycle_stats = stats;
+		m_chunk_lifecycle_time = cur_time;
+	}
+	if (!ImGui::CollapsingHeader("chunk lifecycle"))
+		return;
+	if (ImGui::BeginTable("chunk lifecycle", 4)) {
+		ImGui::TableSetupColumn("stage");
+		ImGui::TableSetupColumn("chunks/s");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p90");
+		ImGui::TableHeadersRow();
+		for (std::size_t s = 0; s < kChunkStageCount; ++s) {
+			// The whole lifecycle is in the last row
+			auto stage = static_cast<ChunkStage>((s + 1) % kChunkStageCount);
+			const auto &h = m_chunk_lifecycle_stats_window.Get(stage);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			auto from = stage == ChunkStage::kInsert ? ChunkStage::kInsert : static_cast<ChunkStage>(s);
+			auto to = stage == ChunkStage::kInsert ? ChunkStage::kVisible : stage;
+			ImGui::Text("%s -> %s", GetChunkStageName(from), GetChunkStageName(to));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)h.GetCount());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f ms", double(h.GetQuantileUs(0.5)) / 1000.0);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f ms", double(h.GetQuantileUs(0.9)) / 1000.0);
+		}
+		ImGui::EndTable();
+	}
+	if (ImGui::Button("dump chunk lifecycle")) {
+		std::ofstream{"chunk_lifecycle.csv"} << stats.ToCSV();
+		std::ofstream{"chunk_lifecycle.json"} << stats.ToJSON();
+		spdlog::info("Chunk lifecycle stats dumped to chunk_lifecycle.csv and chunk_lifecycle.json");
+	}
+}
+
 void Application::Run() {
 	std::chrono::time_point<std::chrono::steady_clock> prev_time = std::chrono::steady_clock::now();
 
@@ -266,6 +355,9 @@ void Application::Run() {
 		std::chrono::time_point<std::chrono::steady_clock> cur_time = std::chrono::steady_clock::now();
 		std::chrono::duration<double, std::ratio<1, 1>> delta = cur_time - prev_time;
 		prev_time = cur_time;
+		glm::vec3 prev_camera_position = m_camera->m_position;
+		ChunkPos3 prev_center_pos = m_world->GetCenterChunkPos();
+		m_camera->m_far = m_world->GetLoadShape().GetFarDistance();
 		if (m_mouse_captured) {
 			m_camera->MoveControl(m_window, delta.count());
 			m_world->SetCenterPos(m_camera->m_position);
@@ -274,6 +366,17 @@ void Application::Run() {
 		} else {
 			m_selected_pos = m_outer_selected_pos = std::nullopt;
 		}
+		if (delta.count() > 0.0)
+			m_camera_velocity = glm::mix(m_camera_velocity,
+			                             (m_camera->m_position - prev_camera_position) / (float)delta.count(), 0.1f);
+		if (m_world->SetCenterView(m_camera->GetViewDirection(), m_camera->m_fov, m_camera->m_aspect_ratio,
+		                           m_camera_velocity) ||
+		    m_world->GetCenterChunkPos() != prev_center_pos)
+			m_view_change_time = cur_time;
+		if (m_view_change_time && m_world->IsViewMeshed(m_world->GetLoadChunkRadius() - 4)) {
+			m_view_meshed_ms = std::chrono::duration<double, std::milli>(cur_time - *m_view_change_time).count();
+			m_view_change_time = std::nullopt;
+		}
 
 		myvk::ImGuiNewFrame();
 
@@ -283,6 +386,25 @@ void Application::Run() {
 		ImGui::Text("cam: %f %f %f", m_camera->m_position.x, m_camera->m_position.y, m_camera->m_position.z);
 		ImGui::Text("pending tasks: %zu", m_world->GetChunkTaskPool().GetPendingTaskCount());
 		ImGui::Text("running tasks (approx): %zu", m_world->GetChunkTaskPool().GetRunningTaskCountApprox());
+		ImGui::Text("view meshed in: %.0f ms%s", m_view_meshed_ms, m_view_change_time ? " (meshing)" : "");
+		ImGui::Text("uniform chunks: %zu", Chunk::GetUniformChunkCount());
+		auto slab_stats = m_world->GetChunkPool().GetSlabPool()->GetStats();
+		ImGui::Text("chunk slab: %zu/%zu used (peak %zu), hit %zu, miss %zu", slab_stats.in_use, slab_stats.slots,
+		            slab_stats.peak, slab_stats.hits, slab_stats.misses);
+		ImGui::Text("palette buffers: %zu kept, %.0f MiB, hit %zu, miss %zu", slab_stats.palette_buffers.buffers,
+		            double(slab_stats.palette_buffers.bytes) / (1024.0 * 1024.0), slab_stats.palette_buffers.hits,
+		            slab_stats.palette_buffers.misses);
+		auto memory_stats = m_world->GetMemoryStats();
+		constexpr double kMiB = 1024.0 * 1024.0;
+		ImGui::Text("memory: chunks %.0f MiB, tasks %.0f MiB, terrain %.0f MiB, meshes %.0f MiB, shrink %d",
+		            double(memory_stats.chunks) / kMiB, double(memory_stats.chunk_tasks) / kMiB,
+		            double(memory_stats.terrain_caches) / kMiB, double(memory_stats.meshes) / kMiB,
+		            m_world->GetBudgetShrink());
+		auto hibernation_stats = m_world->GetChunkHibernationStats();
+		ImGui::Text("hibernated chunks: %zu, %.0f MiB, hit %zu, miss %zu", hibernation_stats.chunks,
+		            double(hibernation_stats.bytes) / kMiB, hibernation_stats.hits, hibernation_stats.misses);
+		task_stats_gui();
+		chunk_lifecycle_gui();
 		ImGui::DragFloat("day night", &m_day_night, 0.01f, 0.0f, 1.0f);
 
 		if (ImGui::DragInt("concurrency", &concurrency, 1, 1, (int)std::thread::hardware_concurrency()))
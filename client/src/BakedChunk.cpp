@@ -0,0 +1,121 @@
+#include <client/BakedChunk.hpp>
+
+#include <client/Chunk.hpp>
+#include <common/Varint.hpp>
+
+#include <array>
+#include <unordered_map>
+
+namespace hc::client {
+
+namespace {
+inline constexpr uint8_t kBakedChunkFormat = 1;
+inline constexpr uint32_t kBlockCount = Chunk::kSize * Chunk::kSize * Chunk::kSize,
+                          kSunlightCount = Chunk::kSize * Chunk::kSize;
+
+template <typename GetValueFunc>
+void put_runs(std::vector<uint8_t> *p_record, uint32_t count, GetValueFunc &&get_value_func) {
+	for (uint32_t i = 0; i < count;) {
+		uint32_t value = get_value_func(i), j = i + 1;
+		while (j < count && get_value_func(j) == value)
+			++j;
+		PutVarint(p_record, value);
+		PutVarint(p_record, j - i - 1);
+		i = j;
+	}
+}
+
+template <typename SetValueFunc>
+bool get_runs(const uint8_t **p_data, const uint8_t *end, uint32_t count, SetValueFunc &&set_value_func) {
+	for (uint32_t i = 0; i < count;) {
+		if (*p_data >= end)
+			return false;
+		uint32_t value = GetVarint(p_data, end), length = GetVarint(p_data, end) + 1;
+		if (length > count - i || !set_value_func(i, length, value))
+			return false;
+		i += length;
+	}
+	return true;
+}
+
+// Chunks are also encoded when unloaded (see ChunkHibernationCache), so uniform chunks skip the copy and the palette
+// is looked up once per run
+void put_blocks(std::vector<uint8_t> *p_record, const Chunk &chunk) {
+	if (chunk.IsUniform()) {
+		PutVarint(p_record, 1);
+		PutVarint(p_record, chunk.GetUniformBlock().GetData());
+		PutVarint(p_record, 0);
+		PutVarint(p_record, kBlockCount - 1);
+		return;
+	}
+	std::vector<block::Block> blocks(kBlockCount);
+	chunk.GetBlockStorage().Copy(0, kBlockCount, blocks.data());
+	std::vector<uint16_t> palette;
+	std::unordered_map<uint16_t, uint32_t> palette_map;
+	std::vector<std::pair<uint32_t, uint32_t>> runs; // palette index and length
+	for (uint32_t i = 0; i < kBlockCount;) {
+		uint16_t block_data = blocks[i].GetData();
+		uint32_t j = i + 1;
+		while (j < kBlockCount && blocks[j].GetData() == block_data)
+			++j;
+		auto [it, inserted] = palette_map.try_emplace(block_data, (uint32_t)palette.size());
+		if (inserted)
+			palette.push_back(block_data);
+		runs.emplace_back(it->second, j - i);
+		i = j;
+	}
+	PutVarint(p_record, (uint32_t)palette.size());
+	for (uint16_t block_data : palette)
+		PutVarint(p_record, block_data);
+	for (auto [palette_index, length] : runs) {
+		PutVarint(p_record, palette_index);
+		PutVarint(p_record, length - 1);
+	}
+}
+} // namespace
+
+std::vector<uint8_t> EncodeBakedChunk(const Chunk &chunk) {
+	std::vector<uint8_t> record{kBakedChunkFormat};
+
+	put_blocks(&record, chunk);
+	put_runs(&record, kSunlightCount, [&](uint32_t i) { return (uint32_t)chunk.GetSunlightHeight(i); });
+	return record;
+}
+
+bool DecodeBakedChunk(std::span<const uint8_t> record, Chunk *p_chunk) {
+	if (record.empty() || record[0] != kBakedChunkFormat)
+		return false;
+	const uint8_t *ptr = record.data() + 1, *end = record.data() + record.size();
+
+	uint32_t palette_size = GetVarint(&ptr, end);
+	if (palette_size == 0 || palette_size > kBlockCount)
+		return false;
+	std::vector<block::Block> palette(palette_size);
+	for (auto &block : palette)
+		block.SetData((uint16_t)GetVarint(&ptr, end));
+
+	std::vector<block::Block> blocks(kBlockCount);
+	std::array<InnerPos1, kSunlightCount> sunlight_heights{};
+	if (!get_runs(&ptr, end, kBlockCount,
+	              [&](uint32_t begin, uint32_t length, uint32_t palette_index) {
+		              if (palette_index >= palette_size)
+			              return false;
+		              std::fill(blocks.begin() + begin, blocks.begin() + begin + length, palette[palette_index]);
+		              return true;
+	              }) ||
+	    !get_runs(&ptr, end, kSunlightCount, [&](uint32_t begin, uint32_t length, uint32_t height) {
+		    std::fill(sunlight_heights.begin() + begin, sunlight_heights.begin() + begin + length, (InnerPos1)height);
+		    return true;
+	    }))
+		return false;
+
+	if (palette_size == 1)
+		p_chunk->FillBlocks(palette[0]);
+	else
+		p_chunk->AssignBlocks(blocks.data());
+	for (uint32_t i = 0; i < kSunlightCount; ++i)
+		p_chunk->SetSunlightHeight(i, sunlight_heights[i]);
+	return true;
+}
+
+} // namespace hc::client
@@ -81,7 +81,7 @@ void Camera::MoveControl(GLFWwindow *window, double delta) {
 }
 
 glm::mat4 Camera::fetch_matrix() const {
-	glm::mat4 ret = glm::perspective(m_fov, m_aspect_ratio, kCameraNear, kCameraFar);
+	glm::mat4 ret = glm::perspective(m_fov, m_aspect_ratio, kCameraNear, m_far);
 	ret[1][1] *= -1;
 	ret = glm::rotate(ret, -m_pitch, glm::vec3(1.0f, 0.0f, 0.0f));
 	ret = glm::rotate(ret, -m_yaw, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -3,6 +3,7 @@
 #include <client/World.hpp>
 
 #include <glm/gtx/hash.hpp>
+#include <unordered_set>
 
 namespace hc::client {
 
@@ -14,14 +15,14 @@ ChunkTaskData<ChunkTaskType::kFloodSunlight>::Pop(const ChunkTaskPoolLocked &tas
 	ChunkPos3 up_chunk_pos = {chunk_pos.x, chunk_pos.y + 1, chunk_pos.z};
 
 	if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate, ChunkTaskType::kSetBlock>(chunk_pos))
-		return std::nullopt;
+		return task_pool.Block(chunk_pos);
 	if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate, ChunkTaskType::kSetSunlight>(up_chunk_pos))
-		return std::nullopt;
+		return task_pool.Block(up_chunk_pos);
 	std::shared_ptr<Chunk> chunk, up_chunk;
 	if (!(chunk = task_pool.GetWorld().GetChunkPool().FindChunk(chunk_pos)))
-		return std::nullopt;
+		return task_pool.Block(chunk_pos);
 	if (!(up_chunk = task_pool.GetWorld().GetChunkPool().FindChunk(up_chunk_pos)))
-		return std::nullopt;
+		return task_pool.Block(up_chunk_pos);
 
 	auto xz_updates = std::move(m_xz_updates);
 	m_xz_updates.clear();
@@ -38,11 +39,17 @@ void ChunkTaskRunner<ChunkTaskType::kFloodSunlight>::Run(ChunkTaskPool *p_task_p
 
 	const auto &up_chunk = data.GetUpChunkPtr(), &chunk = data.GetChunkPtr();
 
+	// every column of a uniform chunk has the same height
+	bool uniform = chunk->IsUniform();
+	InnerPos1 uniform_sl = uniform && !chunk->GetUniformBlock().GetVerticalLightPass() ? kChunkSize : 0;
+
 	for (auto xz_idx : xz_updates) {
 		auto up_sl = up_chunk->GetSunlightHeight(xz_idx); //, sl = chunk->GetSunlightHeight(xz_idx);
 		if (up_sl > 0) {
 			// if (sl != kChunkSize)
 			set_sunlights.push_back({.index = xz_idx, .sunlight = kChunkSize});
+		} else if (uniform) {
+			set_sunlights.push_back({.index = xz_idx, .sunlight = uniform_sl});
 		} else {
 			InnerPos1 y;
 			for (y = kChunkSize - 1;
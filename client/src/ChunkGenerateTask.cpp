@@ -1,3 +1,4 @@
+#include <client/BakedChunk.hpp>
 #include <client/ChunkTaskPool.hpp>
 #include <client/ClientBase.hpp>
 
@@ -26,15 +27,24 @@ void ChunkTaskRunner<ChunkTaskType::kGenerate>::Run(ChunkTaskPool *p_task_pool,
 
 	const auto &chunk_ptr = data.GetChunkPtr();
 
-	client->GetTerrain()->Generate(chunk_ptr);
-	// apply block updates
+	const auto &baked = data.GetChunkEntry().baked;
+	if (baked.empty() || !DecodeBakedChunk(baked, chunk_ptr.get())) {
+		client->GetTerrain()->Generate(chunk_ptr);
+		if (client->IsBakingChunks())
+			client->SetBakedChunk(data.GetChunkPos(), EncodeBakedChunk(*chunk_ptr));
+	}
+	// apply block updates, entries matching the generated block (e.g. reverted edits) are skipped so that uniform
+	// chunks are not widened
 	for (const auto &block_entry : data.GetChunkEntry().blocks)
-		chunk_ptr->SetBlock(block_entry.GetIndex(), block_entry.GetBlock());
+		if (chunk_ptr->GetBlock(block_entry.GetIndex()) != block_entry.GetBlock())
+			chunk_ptr->SetBlock(block_entry.GetIndex(), block_entry.GetBlock());
 	for (const auto &sunlight_entry : data.GetChunkEntry().sunlights)
 		chunk_ptr->SetSunlightHeight(sunlight_entry.GetIndex(), sunlight_entry.GetSunlight());
+	chunk_ptr->CompactBlocks();
 
 	chunk_ptr->SetGeneratedFlag();
 
+	p_task_pool->Push<ChunkTaskType::kLight>(data.GetChunkPos());
 	p_task_pool->Push<ChunkTaskType::kMesh>(data.GetChunkPos());
 }
 
@@ -0,0 +1,66 @@
+#include <client/ChunkLifecycle.hpp>
+
+#include <cstdio>
+
+namespace hc::client {
+
+const char *GetChunkStageName(ChunkStage stage) {
+	constexpr const char *kNames[kChunkStageCount] = {"insert", "load", "generate", "light", "mesh", "visible"};
+	return kNames[static_cast<std::size_t>(stage)];
+}
+
+ChunkLifecycleStats ChunkLifecycleStats::Since(const ChunkLifecycleStats &earlier) const {
+	ChunkLifecycleStats ret;
+	for (std::size_t s = 0; s < kChunkStageCount; ++s)
+		ret.stages[s] = stages[s].Since(earlier.stages[s]);
+	ret.restored = restored.Since(earlier.restored);
+	ret.cold = cold.Since(earlier.cold);
+	return ret;
+}
+
+std::string ChunkLifecycleStats::ToCSV() const {
+	std::string csv = "from,to,count,mean_us,p50_us,p90_us,p99_us\n";
+	char line[256];
+	const auto add_row = [&](ChunkStage from, ChunkStage to, const LatencyHistogram &h) {
+		snprintf(line, sizeof(line), "%s,%s,%llu,%.1f,%llu,%llu,%llu\n", GetChunkStageName(from),
+		         GetChunkStageName(to), (unsigned long long)h.GetCount(), h.GetMeanUs(),
+		         (unsigned long long)h.GetQuantileUs(0.5), (unsigned long long)h.GetQuantileUs(0.9),
+		         (unsigned long long)h.GetQuantileUs(0.99));
+		csv += line;
+	};
+	for (std::size_t s = 1; s < kChunkStageCount; ++s)
+		add_row(static_cast<ChunkStage>(s - 1), static_cast<ChunkStage>(s), stages[s]);
+	add_row(ChunkStage::kInsert, ChunkStage::kVisible, stages[0]);
+	return csv;
+}
+
+std::string ChunkLifecycleStats::ToJSON() const {
+	std::string json = "{\"total\":" + stages[0].ToJSON();
+	for (std::size_t s = 1; s < kChunkStageCount; ++s)
+		json += std::string{",\""} + GetChunkStageName(static_cast<ChunkStage>(s)) + "\":" + stages[s].ToJSON();
+	return json + ",\"restored\":" + restored.ToJSON() + ",\"cold\":" + cold.ToJSON() + "}";
+}
+
+void ChunkLifecycleRecorder::Add(const ChunkLifecycle &lifecycle) {
+	// Stages not recorded by the client (e.g. kLoad for remote chunks) are skipped
+	const auto add = [&lifecycle](AtomicLatencyHistogram *p_histogram, ChunkStage from, ChunkStage to) {
+		int64_t begin = lifecycle.GetTime(from), end = lifecycle.GetTime(to);
+		if (begin && end)
+			p_histogram->Add(end > begin ? uint64_t(end - begin) / 1000u : 0u);
+	};
+	for (std::size_t s = 1; s < kChunkStageCount; ++s)
+		add(&m_stages[s], static_cast<ChunkStage>(s - 1), static_cast<ChunkStage>(s));
+	add(&m_stages[0], ChunkStage::kInsert, ChunkStage::kVisible);
+	add(lifecycle.IsRestored() ? &m_restored : &m_cold, ChunkStage::kInsert, ChunkStage::kVisible);
+}
+
+ChunkLifecycleStats ChunkLifecycleRecorder::GetStats() const {
+	ChunkLifecycleStats stats;
+	for (std::size_t s = 0; s < kChunkStageCount; ++s)
+		m_stages[s].Accumulate(&stats.stages[s]);
+	m_restored.Accumulate(&stats.restored);
+	m_cold.Accumulate(&stats.cold);
+	return stats;
+}
+
+} // namespace hc::client
@@ -0,0 +1,110 @@
+#include <client/ChunkTaskPool.hpp>
+
+#include <client/World.hpp>
+
+namespace hc::client {
+
+std::optional<ChunkTaskRunnerData<ChunkTaskType::kLight>>
+ChunkTaskData<ChunkTaskType::kLight>::Pop(const ChunkTaskPoolLocked &task_pool, const ChunkPos3 &chunk_pos) {
+	if (!m_queued)
+		return std::nullopt;
+
+	std::array<std::shared_ptr<Chunk>, 27> chunks;
+
+	for (uint32_t i = 0; i < 27; ++i) {
+		ChunkPos3 nei_pos;
+		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+		nei_pos += chunk_pos;
+
+		if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate>(nei_pos))
+			return task_pool.Block(nei_pos);
+		// blocks and sunlights around must not change while propagating
+		if (task_pool.AnyRunning<ChunkTaskType::kSetBlock, ChunkTaskType::kSetSunlight>(nei_pos))
+			return task_pool.Block(nei_pos);
+
+		std::shared_ptr<Chunk> nei_chunk = task_pool.GetWorld().GetChunkPool().FindChunk(nei_pos);
+		if (nei_chunk == nullptr)
+			return task_pool.Block(nei_pos);
+		chunks[i] = std::move(nei_chunk);
+	}
+
+	m_queued = false;
+	if (chunks.back()->IsLightValid())
+		return std::nullopt;
+	return ChunkTaskRunnerData<ChunkTaskType::kLight>{std::move(chunks)};
+}
+
+void ChunkTaskRunner<ChunkTaskType::kLight>::Run(ChunkTaskPool *p_task_pool,
+                                                 ChunkTaskRunnerData<ChunkTaskType::kLight> &&data) {
+	const auto &neighbour_chunks = data.GetChunkPtrArray();
+	const auto &chunk = neighbour_chunks.back();
+
+	// An opaque uniform chunk only keeps its initial lights
+	if (chunk->IsUniform() && !chunk->GetUniformBlock().GetIndirectLightPass()) {
+		block::LightLvl torchlight = chunk->GetUniformBlock().GetLightLevel();
+		for (uint32_t i = 0; i < kChunkSize * kChunkSize * kChunkSize; ++i) {
+			auto pos = InnerPos3FromIndex(i);
+			m_chunk_lights[i] = block::Light{block::LightLvl(chunk->GetSunlight(pos.x, pos.y, pos.z) ? 15 : 0), torchlight};
+		}
+		chunk->AssignLights(m_chunk_lights.get());
+		chunk->CompactLights();
+		chunk->SetLightValidFlag();
+		return;
+	}
+
+	m_neighbourhood.GatherBlocks(neighbour_chunks);
+	m_neighbourhood.GatherInitialLights(neighbour_chunks);
+
+	for (InnerPos1 y = -15; y < (InnerPos1)kChunkSize + 15; ++y)
+		for (InnerPos1 z = -15; z < (InnerPos1)kChunkSize + 15; ++z)
+			for (InnerPos1 x = -15; x < (InnerPos1)kChunkSize + 15; ++x) {
+				auto torchlight = m_neighbourhood.GetLight(x, y, z).GetTorchlight();
+				if (LightAlgo::IsBorderLightInterfere(x, y, z, torchlight))
+					m_torchlight_entries.push({{x, y, z}, torchlight});
+			}
+
+	const auto get_sunlight = [this](auto x, auto y, auto z) -> block::LightLvl {
+		return m_neighbourhood.GetLight(x, y, z).GetSunlight();
+	};
+	for (InnerPos1 y = -15; y < (InnerPos1)kChunkSize + 15; ++y)
+		for (InnerPos1 z = -15; z < (InnerPos1)kChunkSize + 15; ++z)
+			for (InnerPos1 x = -15; x < (InnerPos1)kChunkSize + 15; ++x) {
+				auto sunlight = get_sunlight(x, y, z);
+				if (LightAlgo::IsBorderLightInterfere(x, y, z, sunlight)) {
+					if ((x == -15 || get_sunlight(InnerPos1(x - 1), y, z) == 15) &&
+					    (x == (InnerPos1)kChunkSize + 14 || get_sunlight(InnerPos1(x + 1), y, z) == 15) &&
+					    (z == -15 || get_sunlight(x, y, InnerPos1(z - 1)) == 15) &&
+					    (z == (InnerPos1)kChunkSize + 14 || get_sunlight(x, y, InnerPos1(z + 1)) == 15) &&
+					    (y == -15 || get_sunlight(x, InnerPos1(y - 1), z) == 15) &&
+					    (y == (InnerPos1)kChunkSize + 14 || get_sunlight(x, InnerPos1(y + 1), z) == 15))
+						continue;
+					m_sunlight_entries.push({{x, y, z}, sunlight});
+				}
+			}
+
+	const auto get_block = [this](auto x, auto y, auto z) -> block::Block {
+		return m_neighbourhood.GetBlock(x, y, z);
+	};
+	LightAlgo algo{};
+	algo.PropagateLight(&m_sunlight_entries, get_block, get_sunlight,
+	                    [this](auto x, auto y, auto z, block::LightLvl lvl) {
+		                    m_neighbourhood.GetLightRef(x, y, z).SetSunlight(lvl);
+	                    });
+	algo.PropagateLight(
+	    &m_torchlight_entries, get_block,
+	    [this](auto x, auto y, auto z) -> block::LightLvl { return m_neighbourhood.GetLight(x, y, z).GetTorchlight(); },
+	    [this](auto x, auto y, auto z, block::LightLvl lvl) {
+		    m_neighbourhood.GetLightRef(x, y, z).SetTorchlight(lvl);
+	    });
+
+	for (uint32_t y = 0; y < kChunkSize; ++y)
+		for (uint32_t z = 0; z < kChunkSize; ++z)
+			std::copy_n(m_neighbourhood.GetLightData() + m_neighbourhood.GetIndex(0u, y, z), kChunkSize,
+			            m_chunk_lights.get() + InnerIndex3FromPos(0u, y, z));
+	chunk->AssignLights(m_chunk_lights.get());
+	// The lights are not read before they are valid
+	chunk->CompactLights();
+	chunk->SetLightValidFlag();
+}
+
+} // namespace hc::client
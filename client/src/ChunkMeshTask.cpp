@@ -1,14 +1,34 @@
 #include <client/ChunkTaskPool.hpp>
 
-#include <client/BlockLightAlgo.hpp>
 #include <client/BlockMeshAlgo.hpp>
 #include <client/World.hpp>
-#include <client/WorldRenderer.hpp>
 
 namespace hc::client {
 
-template <std::signed_integral T> static inline constexpr uint32_t chunk_xyz_extended15_to_index(T x, T y, T z) {
-	return x + 15 + ((z + 15) + (y + 15) * (kChunkSize + 30)) * (kChunkSize + 30);
+// A uniform chunk produces no faces if its block hides its own faces and those facing the (uniform) neighbours
+static bool uniform_chunk_mesh_empty(const std::array<std::shared_ptr<Chunk>, 27> &neighbour_chunks) {
+	const auto &chunk = neighbour_chunks.back();
+	if (!chunk->IsUniform())
+		return false;
+	block::Block block = chunk->GetUniformBlock();
+	if (block.HaveCustomMesh())
+		return false;
+	for (block::BlockFace face = 0; face < 6; ++face) {
+		auto texture = block.GetTexture(face);
+		if (texture.Empty())
+			continue;
+		if (texture.Show(block.GetTexture(block::BlockFaceOpposite(face))))
+			return false;
+		InnerPos1 cmp_xyz[3] = {};
+		block::BlockFaceProceed(cmp_xyz, face);
+		const auto &nei_chunk = neighbour_chunks[CmpXYZ2NeighbourIndex(cmp_xyz[0], cmp_xyz[1], cmp_xyz[2])];
+		if (!nei_chunk->IsUniform())
+			return false;
+		block::Block nei_block = nei_chunk->GetUniformBlock();
+		if (nei_block.HaveCustomMesh() || texture.Show(nei_block.GetTexture(block::BlockFaceOpposite(face))))
+			return false;
+	}
+	return true;
 }
 
 std::optional<ChunkTaskRunnerData<ChunkTaskType::kMesh>>
@@ -16,6 +36,10 @@ ChunkTaskData<ChunkTaskType::kMesh>::Pop(const ChunkTaskPoolLocked &task_pool, c
 	if (!m_queued)
 		return std::nullopt;
 
+	// light writers up to two chunks away compact the lights read here
+	if (auto pos = task_pool.FindRunningAround<ChunkTaskType::kSetBlock, ChunkTaskType::kSetSunlight>(chunk_pos, 2))
+		return task_pool.Block(*pos);
+
 	std::array<std::shared_ptr<Chunk>, 27> chunks;
 
 	for (uint32_t i = 0; i < 27; ++i) {
@@ -23,13 +47,12 @@ ChunkTaskData<ChunkTaskType::kMesh>::Pop(const ChunkTaskPoolLocked &task_pool, c
 		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
 		nei_pos += chunk_pos;
 
-		if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate /*, ChunkTaskType::kSetBlock , ChunkTaskType::kSetSunlight*/>(
-		        nei_pos))
-			return std::nullopt;
+		if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate, ChunkTaskType::kLight>(nei_pos))
+			return task_pool.Block(nei_pos);
 
 		std::shared_ptr<Chunk> nei_chunk = task_pool.GetWorld().GetChunkPool().FindChunk(nei_pos);
-		if (nei_chunk == nullptr)
-			return std::nullopt;
+		if (nei_chunk == nullptr || !nei_chunk->IsLightValid())
+			return task_pool.Block(nei_pos);
 		chunks[i] = std::move(nei_chunk);
 	}
 
@@ -45,85 +68,32 @@ void ChunkTaskRunner<ChunkTaskType::kMesh>::Run(ChunkTaskPool *p_task_pool,
 
 	std::vector<BlockMesh> meshes;
 
-	// Always recalculate lighting
-	for (InnerPos1 y = -15; y < (InnerPos1)kChunkSize + 15; ++y)
-		for (InnerPos1 z = -15; z < (InnerPos1)kChunkSize + 15; ++z)
-			for (InnerPos1 x = -15; x < (InnerPos1)kChunkSize + 15; ++x) {
-				block::Light light = {};
-				uint32_t nei_idx = Chunk::GetBlockNeighbourIndex(x, y, z);
-				light.SetTorchlight(neighbour_chunks[nei_idx]->GetBlockFromNeighbour(x, y, z).GetLightLevel());
-				light.SetSunlight(neighbour_chunks[nei_idx]->GetSunlightFromNeighbour(x, y, z) ? 15 : 0);
-				m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)] = light;
-				if (LightAlgo::IsBorderLightInterfere(x, y, z, light.GetTorchlight()))
-					m_torchlight_entries.push({{x, y, z}, light.GetTorchlight()});
-			}
-
-	for (InnerPos1 y = -15; y < (InnerPos1)kChunkSize + 15; ++y)
-		for (InnerPos1 z = -15; z < (InnerPos1)kChunkSize + 15; ++z)
-			for (InnerPos1 x = -15; x < (InnerPos1)kChunkSize + 15; ++x) {
-				auto sunlight = m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)].GetSunlight();
-				if (LightAlgo::IsBorderLightInterfere(x, y, z, sunlight)) {
-					if ((x == -15 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(InnerPos1(x - 1), y, z)].GetSunlight() ==
-					         15) &&
-					    (x == (InnerPos1)kChunkSize + 14 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(InnerPos1(x + 1), y, z)].GetSunlight() ==
-					         15) &&
-					    (z == -15 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, InnerPos1(z - 1))].GetSunlight() ==
-					         15) &&
-					    (z == (InnerPos1)kChunkSize + 14 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, InnerPos1(z + 1))].GetSunlight() ==
-					         15) &&
-					    (y == -15 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(x, InnerPos1(y - 1), z)].GetSunlight() ==
-					         15) &&
-					    (y == (InnerPos1)kChunkSize + 14 ||
-					     m_extend_light_buffer[chunk_xyz_extended15_to_index(x, InnerPos1(y + 1), z)].GetSunlight() ==
-					         15))
-						continue;
-					m_sunlight_entries.push({{x, y, z}, sunlight});
-				}
-			}
-
-	LightAlgo algo{};
-	algo.PropagateLight(
-	    &m_sunlight_entries,
-	    [&neighbour_chunks](auto x, auto y, auto z) -> block::Block {
-		    return neighbour_chunks[Chunk::GetBlockNeighbourIndex(x, y, z)]->GetBlockFromNeighbour(x, y, z);
-	    },
-	    [this](auto x, auto y, auto z) -> block::LightLvl {
-		    return m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)].GetSunlight();
-	    },
-	    [this](auto x, auto y, auto z, block::LightLvl lvl) {
-		    m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)].SetSunlight(lvl);
-	    });
-	algo.PropagateLight(
-	    &m_torchlight_entries,
-	    [&neighbour_chunks](auto x, auto y, auto z) -> block::Block {
-		    return neighbour_chunks[Chunk::GetBlockNeighbourIndex(x, y, z)]->GetBlockFromNeighbour(x, y, z);
-	    },
-	    [this](auto x, auto y, auto z) -> block::LightLvl {
-		    return m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)].GetTorchlight();
-	    },
-	    [this](auto x, auto y, auto z, block::LightLvl lvl) {
-		    m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)].SetTorchlight(lvl);
-	    });
+	if (uniform_chunk_mesh_empty(neighbour_chunks)) {
+		// Flag before the push, the sink may report the chunk visible right away
+		chunk->SetMeshedFlag();
+		auto mesh_sink = p_task_pool->GetWorld().LockMeshSink();
+		if (mesh_sink)
+			mesh_sink->PushChunkMesh(chunk->GetPosition(), std::move(meshes));
+		return;
+	}
+
+	// Lights are propagated by kLight and kept up to date by kSetBlock and kSetSunlight
+	m_neighbourhood.GatherBlocks(neighbour_chunks);
+	m_neighbourhood.GatherLights(neighbour_chunks);
 
+	const auto get_block = [this](auto x, auto y, auto z) -> block::Block {
+		return m_neighbourhood.GetBlock(x, y, z);
+	};
 	meshes =
 	    BlockMeshAlgo<BlockAlgoConfig<InnerPos1, BlockAlgoBound<InnerPos1>{0, 0, 0, kChunkSize, kChunkSize, kChunkSize},
 	                                  kBlockAlgoSwizzleYZX>>{}
-	        .Generate(
-	            [&neighbour_chunks](auto x, auto y, auto z) -> block::Block {
-		            return neighbour_chunks[Chunk::GetBlockNeighbourIndex(x, y, z)]->GetBlockFromNeighbour(x, y, z);
-	            },
-	            [this](auto x, auto y, auto z) -> block::Light {
-		            return m_extend_light_buffer[chunk_xyz_extended15_to_index(x, y, z)];
-	            });
-
-	auto renderer = p_task_pool->GetWorld().LockRenderer();
-	if (renderer)
-		renderer->PushChunkMesh(chunk->GetPosition(), std::move(meshes));
+	        .Generate(get_block,
+	                  [this](auto x, auto y, auto z) -> block::Light { return m_neighbourhood.GetLight(x, y, z); });
+
+	chunk->SetMeshedFlag();
+	auto mesh_sink = p_task_pool->GetWorld().LockMeshSink();
+	if (mesh_sink)
+		mesh_sink->PushChunkMesh(chunk->GetPosition(), std::move(meshes));
 }
 
 } // namespace hc::client
\ No newline at end of file
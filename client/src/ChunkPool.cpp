@@ -3,30 +3,152 @@
 #include <client/ClientBase.hpp>
 #include <client/World.hpp>
 
+#include <algorithm>
+#include <cmath>
+
+#include <spdlog/spdlog.h>
+
 namespace hc::client {
 
-#include "WorldLoadingList.inl"
+namespace {
+
+template <typename Columns, typename HalfHeightFunc>
+inline void build_columns(int32_t extent, HalfHeightFunc &&get_half_height, Columns *p_columns) {
+	p_columns->extent = extent;
+	p_columns->half_heights.clear();
+	for (int32_t z = -extent; z <= extent; ++z)
+		for (int32_t x = -extent; x <= extent; ++x)
+			p_columns->half_heights.push_back(get_half_height(x, z));
+}
+
+// Calls func on the positions inside shape a but not in shape b, visiting only the columns of a, so that moving a shape
+// by a chunk costs its surface instead of its volume. Shapes are cut above their max_y.
+template <typename Columns, typename Func>
+inline void for_each_shape_difference(const ChunkPos3 &a_center, const Columns &a_columns, int32_t a_max_y,
+                                      const std::optional<ChunkPos3> &b_center, const Columns *p_b_columns,
+                                      int32_t b_max_y, Func &&func) {
+	glm::i32vec3 offset = b_center ? glm::i32vec3(a_center) - glm::i32vec3(*b_center) : glm::i32vec3{};
+	for (int32_t z = -a_columns.extent; z <= a_columns.extent; ++z)
+		for (int32_t x = -a_columns.extent; x <= a_columns.extent; ++x) {
+			int32_t h = a_columns.Get(x, z), a_y_max = std::min(h, a_max_y - a_center.y);
+			const auto func_range = [&](int32_t y_min, int32_t y_max) {
+				for (int32_t y = y_min; y <= y_max; ++y)
+					func(ChunkPos3(a_center.x + x, a_center.y + y, a_center.z + z));
+			};
+			// The column of b, relative to the center of a
+			int32_t b_h = b_center ? p_b_columns->Get(x + offset.x, z + offset.z) : -1,
+			        b_y_min = -offset.y - b_h, b_y_max = std::min(-offset.y + b_h, b_max_y - a_center.y);
+			if (b_h < 0 || b_y_min > b_y_max) {
+				func_range(-h, a_y_max);
+				continue;
+			}
+			func_range(-h, std::min(a_y_max, b_y_min - 1));
+			func_range(std::max(-h, b_y_max + 1), a_y_max);
+		}
+}
+
+} // namespace
+
+void ChunkPool::grow_ring_chunks(uint32_t extent_xz, uint32_t extent_y) {
+	RingMap *p_prev_ring_chunks = get_ring_chunks();
+	auto ring_chunks = std::make_unique<RingMap>(std::max(extent_xz, p_prev_ring_chunks->GetExtentXZ()),
+	                                             std::max(extent_y, p_prev_ring_chunks->GetExtentY()));
+	// The chunks kept fit the previous extents, so they don't share slots in the larger ones
+	p_prev_ring_chunks->ForEachFn([&ring_chunks](const ChunkPos3 &position, const std::shared_ptr<Chunk> &chunk) {
+		ring_chunks->Insert(position, std::shared_ptr<Chunk>{chunk});
+	});
+	spdlog::info("Chunk ring map grown from {}x{}x{} to {}x{}x{}", p_prev_ring_chunks->GetExtentXZ(),
+	             p_prev_ring_chunks->GetExtentY(), p_prev_ring_chunks->GetExtentXZ(), ring_chunks->GetExtentXZ(),
+	             ring_chunks->GetExtentY(), ring_chunks->GetExtentXZ());
+	m_ring_chunks_heap_size.fetch_add(ring_chunks->GetHeapSize(), std::memory_order_relaxed);
+	m_ring_chunks.store(ring_chunks.get(), std::memory_order_release);
+	m_ring_chunk_maps.push_back(std::move(ring_chunks));
+	// A lookup still in the previous ring map finds no chunk, as if not loaded yet
+	p_prev_ring_chunks->Clear();
+}
+
 void ChunkPool::Update() {
+	std::scoped_lock update_lock{m_update_mutex};
 	auto chunk_pos = m_world.GetCenterChunkPos();
-	auto load_radius = m_world.GetLoadChunkRadius(), unload_radius = m_world.GetUnloadChunkRadius();
+	auto load_shape = m_world.GetLoadShape(), unload_shape = m_world.GetUnloadShape();
 
-	std::vector<ChunkPos3> generate_chunk_pos_vec;
-	{
-		auto locked_chunks = m_chunks.lock_table();
-		for (auto it = locked_chunks.begin(); it != locked_chunks.end();) {
-			if (ChunkPosDistance2(chunk_pos, it->first) > uint32_t(unload_radius * unload_radius))
-				it = locked_chunks.erase(it);
-			else
-				++it;
-		}
-		for (const ChunkPos3 *i = kWorldLoadingList; i != kWorldLoadingRadiusEnd[load_radius]; ++i) {
-			ChunkPos3 pos = chunk_pos + *i;
-			if (locked_chunks.find(pos) == locked_chunks.end()) {
-				locked_chunks.insert(pos, Chunk::Create(pos));
-				generate_chunk_pos_vec.push_back(pos);
-			}
+	Shape shape{chunk_pos, load_shape, unload_shape, m_world.GetMaxLoadChunkY()};
+	if (m_prev_shape && m_prev_shape->load_shape == load_shape && m_prev_shape->unload_shape == unload_shape) {
+		shape.load_columns = m_prev_shape->load_columns;
+		shape.keep_columns = m_prev_shape->keep_columns;
+	} else {
+		// The load shape grown by a chunk, so that the chunks inside the shape have all their neighbours
+		build_columns(load_shape.radius + 1, [&load_shape](int32_t x, int32_t z) {
+			int32_t h = -1;
+			for (int32_t dz = -1; dz <= 1; ++dz)
+				for (int32_t dx = -1; dx <= 1; ++dx)
+					h = std::max(h, load_shape.GetHalfHeight(x + dx, z + dz));
+			return h < 0 ? -1 : h + 1;
+		}, &shape.load_columns);
+		// Keep the loaded chunks as well
+		build_columns(std::max(load_shape.radius + 1, (int32_t)unload_shape.radius), [&](int32_t x, int32_t z) {
+			return std::max(shape.load_columns.Get(x, z), unload_shape.GetHalfHeight(x, z));
+		}, &shape.keep_columns);
+
+		if (RingMap *p_ring_chunks = get_ring_chunks()) {
+			int32_t keep_height = std::ranges::max(shape.keep_columns.half_heights);
+			uint32_t extent_xz = 2 * shape.keep_columns.extent + 1, extent_y = 2 * std::max(keep_height, 0) + 1;
+			if (!p_ring_chunks->Holds(extent_xz, extent_y))
+				grow_ring_chunks(extent_xz, extent_y);
 		}
 	}
+
+	// Unload the chunks left behind, the generated ones are queued to be encoded by the workers in case they are loaded
+	// again soon
+	bool hibernate = m_hibernation.GetCapacity(), any_hibernated = false;
+	if (m_prev_shape)
+		for_each_shape_difference(m_prev_shape->center, m_prev_shape->keep_columns, m_prev_shape->max_y, chunk_pos,
+		                          &shape.keep_columns, shape.max_y,
+		                          [this, hibernate, &any_hibernated](const ChunkPos3 &pos) {
+			                          if (auto chunk = FindRawChunk(pos); hibernate && chunk && chunk->IsGenerated())
+				                          any_hibernated |= m_hibernation.Hibernate(std::move(chunk));
+			                          erase_chunk(pos);
+		                          });
+
+	// Load the chunks entering the shape, nearest first
+	std::vector<ChunkPos3> generate_chunk_pos_vec;
+	for_each_shape_difference(
+	    chunk_pos, shape.load_columns, shape.max_y, m_prev_shape ? std::optional{m_prev_shape->center} : std::nullopt,
+	    m_prev_shape ? &m_prev_shape->load_columns : nullptr, m_prev_shape ? m_prev_shape->max_y : 0,
+	    [&generate_chunk_pos_vec](const ChunkPos3 &pos) { generate_chunk_pos_vec.push_back(pos); });
+	std::sort(generate_chunk_pos_vec.begin(), generate_chunk_pos_vec.end(),
+	          [&chunk_pos](const ChunkPos3 &l, const ChunkPos3 &r) {
+		          return ChunkPosDistance2(chunk_pos, l) < ChunkPosDistance2(chunk_pos, r);
+	          });
+	std::vector<std::pair<ChunkPos3, std::vector<uint8_t>>> restore_records;
+	std::erase_if(generate_chunk_pos_vec, [this, hibernate, &restore_records](const ChunkPos3 &pos) {
+		// Still kept from an earlier visit
+		if (contains_chunk(pos))
+			return true;
+		auto chunk = m_slab_pool->AllocateChunk(pos);
+		Chunk &chunk_ref = *chunk;
+		chunk_ref.GetLifecycle().Reach(ChunkStage::kInsert);
+		// The ring map is grown with the shapes above, so this should not fail
+		if (!insert_chunk(pos, std::move(chunk))) {
+			spdlog::error("Chunk ({}, {}, {}) not inserted, the ring map is too small", pos.x, pos.y, pos.z);
+			return true;
+		}
+		auto record = hibernate ? m_hibernation.Take(pos) : std::nullopt;
+		if (!record)
+			return false;
+		chunk_ref.GetLifecycle().SetRestored();
+		chunk_ref.GetLifecycle().Reach(ChunkStage::kLoad);
+		restore_records.emplace_back(pos, std::move(*record));
+		return true;
+	});
+	m_prev_shape = std::move(shape);
+
+	// Decoded by the generate tasks instead of the terrain
+	for (auto &[pos, record] : restore_records)
+		m_world.m_chunk_task_pool.Push<ChunkTaskType::kGenerate>(pos, PackedChunkEntry{.baked = std::move(record)});
+	if (any_hibernated)
+		m_world.m_chunk_task_pool.Wake();
+
 	auto client = m_world.LockClient();
 	if (client)
 		client->LoadChunks(generate_chunk_pos_vec);
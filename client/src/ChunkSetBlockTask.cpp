@@ -4,6 +4,7 @@
 #include <client/World.hpp>
 
 #include <bitset>
+#include <unordered_set>
 
 namespace hc::client {
 
@@ -13,25 +14,34 @@ ChunkTaskData<ChunkTaskType::kSetBlock>::Pop(const ChunkTaskPoolLocked &task_poo
 		return std::nullopt;
 
 	if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate>(chunk_pos))
-		return std::nullopt;
+		return task_pool.Block(chunk_pos);
 
-	// if any chunks are being updated around, postpone
-	if (task_pool.AnyRunning<ChunkTaskType::kUpdateBlock, ChunkTaskType::kFloodSunlight>(chunk_pos))
-		return std::nullopt;
+	// if any chunks are being updated around, or their lights are being written, postpone
+	if (task_pool.AnyRunning<ChunkTaskType::kUpdateBlock, ChunkTaskType::kFloodSunlight, ChunkTaskType::kSetSunlight,
+	                         ChunkTaskType::kLight>(chunk_pos))
+		return task_pool.Block(chunk_pos);
 	for (uint32_t i = 0; i < 26; ++i) {
 		ChunkPos3 nei_pos;
 		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
 		nei_pos += chunk_pos;
-		if (task_pool.AnyRunning<ChunkTaskType::kUpdateBlock>(nei_pos))
-			return std::nullopt;
+		if (task_pool.AnyRunning<ChunkTaskType::kUpdateBlock, ChunkTaskType::kLight>(nei_pos))
+			return task_pool.Block(nei_pos);
 	}
+	// lights are written in the 27 chunks around, which the light writers up to two chunks away also write
+	if (auto pos = task_pool.FindRunningAround<ChunkTaskType::kSetBlock, ChunkTaskType::kSetSunlight>(chunk_pos, 2))
+		return task_pool.Block(*pos);
 
-	std::shared_ptr<Chunk> chunk;
-	if (!(chunk = task_pool.GetWorld().GetChunkPool().FindChunk(chunk_pos)))
-		return std::nullopt;
+	std::array<std::shared_ptr<Chunk>, 27> chunks;
+	if (!(chunks[26] = task_pool.GetWorld().GetChunkPool().FindChunk(chunk_pos)))
+		return task_pool.Block(chunk_pos);
+	for (uint32_t i = 0; i < 26; ++i) {
+		ChunkPos3 nei_pos;
+		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+		chunks[i] = task_pool.GetWorld().GetChunkPool().FindChunk(nei_pos + chunk_pos);
+	}
 	auto set_block_map = std::move(m_set_block_map);
 	m_set_block_map.clear();
-	return ChunkTaskRunnerData<ChunkTaskType::kSetBlock>{std::move(chunk), std::move(set_block_map)};
+	return ChunkTaskRunnerData<ChunkTaskType::kSetBlock>{std::move(chunks), std::move(set_block_map)};
 }
 
 void ChunkTaskRunner<ChunkTaskType::kSetBlock>::Run(ChunkTaskPool *p_task_pool,
@@ -42,7 +52,7 @@ void ChunkTaskRunner<ChunkTaskType::kSetBlock>::Run(ChunkTaskPool *p_task_pool,
 
 	const auto &chunk = data.GetChunkPtr();
 
-	std::bitset<27> neighbour_remesh_set{};
+	m_light_updater.Reset(data.GetChunkPtrArray());
 
 	std::unordered_set<InnerIndex2> flood_sunlights;
 	std::unordered_set<InnerIndex3> block_updates[27], block_activates[27];
@@ -90,23 +100,22 @@ void ChunkTaskRunner<ChunkTaskType::kSetBlock>::Run(ChunkTaskPool *p_task_pool,
 			continue;
 
 		chunk->SetBlock(block_idx, new_block);
+		m_light_updater.OnBlockChange(block_pos, local_old_block, new_block);
 
 		foreach_neighbours_7(block_pos, [&block_updates](uint32_t chunk_idx, InnerIndex3 block_idx) {
 			block_updates[chunk_idx].insert(block_idx);
 		});
 
 		flood_sunlights.emplace(InnerIndex2FromPos(block_pos.x, block_pos.z));
-
-		neighbour_remesh_set[26] = true;
-		for (uint32_t i = 0; i < 26; ++i) {
-			if (neighbour_remesh_set[i])
-				continue;
-			ChunkPos3 nei_chunk_pos;
-			Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_chunk_pos));
-			neighbour_remesh_set[i] = ChunkShouldRemesh(block_pos - InnerPos3(nei_chunk_pos) * InnerPos1(kChunkSize));
-		}
 	}
 
+	m_light_updater.Propagate();
+	// Meshes up to two chunks away may still read the retired light layouts, new ones wait for this task (see
+	// ChunkTaskData<ChunkTaskType::kMesh>::Pop), otherwise the layouts are freed by a later compaction
+	if (!p_task_pool->AnyRunningAround<ChunkTaskType::kMesh>(chunk->GetPosition(), 2))
+		m_light_updater.CompactLights();
+	const auto &neighbour_remesh_set = m_light_updater.GetRemeshSet();
+
 	client->SetChunkBlocks(chunk->GetPosition(), client_set_blocks);
 
 	auto current_tick = p_task_pool->GetWorld().GetCurrentTick();
@@ -11,18 +11,38 @@ ChunkTaskData<ChunkTaskType::kSetSunlight>::Pop(const ChunkTaskPoolLocked &task_
 		return std::nullopt;
 
 	if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate>(chunk_pos))
-		return std::nullopt;
+		return task_pool.Block(chunk_pos);
 
 	// if the bottom chunk is flooding, postpone
-	if (task_pool.AnyRunning<ChunkTaskType::kFloodSunlight>({chunk_pos.x, chunk_pos.y - 1, chunk_pos.z}))
-		return std::nullopt;
-
-	std::shared_ptr<Chunk> chunk;
-	if (!(chunk = task_pool.GetWorld().GetChunkPool().FindChunk(chunk_pos)))
-		return std::nullopt;
+	if (ChunkPos3 down_chunk_pos = {chunk_pos.x, chunk_pos.y - 1, chunk_pos.z};
+	    task_pool.AnyRunning<ChunkTaskType::kFloodSunlight>(down_chunk_pos))
+		return task_pool.Block(down_chunk_pos);
+
+	// if lights around are being written, postpone
+	if (task_pool.AnyRunning<ChunkTaskType::kSetBlock, ChunkTaskType::kLight>(chunk_pos))
+		return task_pool.Block(chunk_pos);
+	for (uint32_t i = 0; i < 26; ++i) {
+		ChunkPos3 nei_pos;
+		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+		nei_pos += chunk_pos;
+		if (task_pool.AnyRunning<ChunkTaskType::kLight>(nei_pos))
+			return task_pool.Block(nei_pos);
+	}
+	// see ChunkTaskData<ChunkTaskType::kSetBlock>::Pop
+	if (auto pos = task_pool.FindRunningAround<ChunkTaskType::kSetBlock, ChunkTaskType::kSetSunlight>(chunk_pos, 2))
+		return task_pool.Block(*pos);
+
+	std::array<std::shared_ptr<Chunk>, 27> chunks;
+	if (!(chunks[26] = task_pool.GetWorld().GetChunkPool().FindChunk(chunk_pos)))
+		return task_pool.Block(chunk_pos);
+	for (uint32_t i = 0; i < 26; ++i) {
+		ChunkPos3 nei_pos;
+		Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_pos));
+		chunks[i] = task_pool.GetWorld().GetChunkPool().FindChunk(nei_pos + chunk_pos);
+	}
 	auto set_sunlight_map = std::move(m_set_sunlight_map);
 	m_set_sunlight_map.clear();
-	return ChunkTaskRunnerData<ChunkTaskType::kSetSunlight>{std::move(chunk), std::move(set_sunlight_map)};
+	return ChunkTaskRunnerData<ChunkTaskType::kSetSunlight>{std::move(chunks), std::move(set_sunlight_map)};
 }
 
 void ChunkTaskRunner<ChunkTaskType::kSetSunlight>::Run(ChunkTaskPool *p_task_pool,
@@ -33,7 +53,7 @@ void ChunkTaskRunner<ChunkTaskType::kSetSunlight>::Run(ChunkTaskPool *p_task_poo
 
 	const auto &chunk = data.GetChunkPtr();
 
-	std::bitset<27> neighbour_remesh_set{};
+	m_light_updater.Reset(data.GetChunkPtrArray());
 
 	std::vector<InnerIndex2> xz_updates;
 	std::vector<ChunkSetSunlightEntry> client_set_sunlights;
@@ -56,23 +76,18 @@ void ChunkTaskRunner<ChunkTaskType::kSetSunlight>::Run(ChunkTaskPool *p_task_poo
 			continue;
 
 		chunk->SetSunlightHeight(xz_idx, new_sunlight);
+		m_light_updater.OnSunlightHeightChange(xz_pos.x, xz_pos.y, local_old_sunlight, new_sunlight);
 
 		// activate flood
 		xz_updates.push_back(xz_idx);
-
-		// update remesh set
-		neighbour_remesh_set[26] = true;
-		for (uint32_t i = 0; i < 26; ++i) {
-			if (neighbour_remesh_set[i])
-				continue;
-			ChunkPos3 nei_chunk_pos;
-			Chunk::NeighbourIndex2CmpXYZ(i, glm::value_ptr(nei_chunk_pos));
-			neighbour_remesh_set[i] =
-			    ChunkShouldRemesh({xz_pos.x, std::min(local_old_sunlight, new_sunlight), xz_pos.y}) ||
-			    ChunkShouldRemesh({xz_pos.x, std::max(local_old_sunlight, new_sunlight) - 1, xz_pos.y});
-		}
 	}
 
+	m_light_updater.Propagate();
+	// see ChunkTaskRunner<ChunkTaskType::kSetBlock>::Run
+	if (!p_task_pool->AnyRunningAround<ChunkTaskType::kMesh>(chunk->GetPosition(), 2))
+		m_light_updater.CompactLights();
+	const auto &neighbour_remesh_set = m_light_updater.GetRemeshSet();
+
 	client->SetChunkSunlights(chunk->GetPosition(), client_set_sunlights);
 
 	for (uint32_t i = 0; i < 27; ++i) {
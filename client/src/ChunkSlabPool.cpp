@@ -0,0 +1,81 @@
+#include <client/ChunkSlabPool.hpp>
+
+#include <algorithm>
+
+namespace hc::client {
+
+void *ChunkSlabPool::allocate_slot() {
+	std::scoped_lock lock{m_mutex};
+	m_peak = std::max(m_peak, ++m_in_use);
+
+	if (!m_free_slots.empty()) {
+		++m_hits;
+		void *slot = m_free_slots.back();
+		m_free_slots.pop_back();
+		return slot;
+	}
+
+	++m_misses;
+	if ((m_slabs.size() + 1) * kSlabSlots > m_capacity)
+		return ::operator new(kSlotSize);
+
+	auto slab = std::make_unique<std::byte[]>(kSlotSize * kSlabSlots);
+	std::byte *base = slab.get();
+	m_slabs.insert(std::upper_bound(m_slabs.begin(), m_slabs.end(), base,
+	                                [](const std::byte *l, const auto &r) { return l < r.get(); }),
+	               std::move(slab));
+	for (std::size_t i = kSlabSlots - 1; i > 0; --i)
+		m_free_slots.push_back(base + i * kSlotSize);
+	return base;
+}
+
+std::size_t ChunkSlabPool::find_slab(const void *slot) const {
+	const auto *p = static_cast<const std::byte *>(slot);
+	auto it = std::upper_bound(m_slabs.begin(), m_slabs.end(), p,
+	                           [](const std::byte *l, const auto &r) { return l < r.get(); });
+	return it != m_slabs.begin() && p < (it - 1)->get() + kSlotSize * kSlabSlots ? it - 1 - m_slabs.begin()
+	                                                                               : m_slabs.size();
+}
+
+bool ChunkSlabPool::owns_slot(const void *slot) const { return find_slab(slot) != m_slabs.size(); }
+
+void ChunkSlabPool::deallocate_slot(void *slot) {
+	std::scoped_lock lock{m_mutex};
+	--m_in_use;
+	if (owns_slot(slot))
+		m_free_slots.push_back(slot);
+	else
+		::operator delete(slot);
+}
+
+ChunkSlabPool::Stats ChunkSlabPool::GetStats() {
+	PaletteBufferPool::Stats palette_buffer_stats = m_palette_buffers.GetStats();
+	std::scoped_lock lock{m_mutex};
+	return {.hits = m_hits,
+	        .misses = m_misses,
+	        .in_use = m_in_use,
+	        .peak = m_peak,
+	        .slots = m_slabs.size() * kSlabSlots,
+	        .capacity = m_capacity,
+	        .palette_buffers = palette_buffer_stats};
+}
+
+std::size_t ChunkSlabPool::ReleaseEmptySlabs() {
+	std::scoped_lock lock{m_mutex};
+	std::vector<std::size_t> free_counts(m_slabs.size());
+	for (void *slot : m_free_slots)
+		++free_counts[find_slab(slot)];
+	std::erase_if(m_free_slots,
+	              [this, &free_counts](void *slot) { return free_counts[find_slab(slot)] == kSlabSlots; });
+
+	std::size_t released = 0;
+	for (std::size_t i = 0; i < m_slabs.size(); ++i)
+		if (free_counts[i] == kSlabSlots) {
+			m_slabs[i].reset();
+			++released;
+		}
+	std::erase_if(m_slabs, [](const auto &slab) { return !slab; });
+	return released * kSlabSlots * kSlotSize;
+}
+
+} // namespace hc::client
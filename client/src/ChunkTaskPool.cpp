@@ -1,118 +1,315 @@
 #include <client/ChunkTaskPool.hpp>
 
 #include <client/ClientBase.hpp>
+#include <client/Config.hpp>
 #include <client/World.hpp>
+#include <common/Trace.hpp>
 
 #include <algorithm>
+#include <tuple>
 
 namespace hc::client {
 
-struct ChunkTaskSortEntry {
-	ChunkPos3 pos;
-	uint16_t dist2;
-	inline bool operator<(const ChunkTaskSortEntry &r) const { return dist2 < r.dist2; }
-};
+// Worker whose runner is running on this thread, if any
+static thread_local ChunkTaskPoolToken *t_running_token = nullptr;
+
+void ChunkTaskPool::record_spawn(const ChunkPos3 &chunk_pos) {
+	if (t_running_token) {
+		m_spawn_owners.insert_or_assign(chunk_pos, t_running_token->m_worker_index);
+		t_running_token->m_local_positions.push_back(chunk_pos);
+	}
+}
+
+void ChunkTaskPool::notify_waiters(const ChunkPos3 &chunk_pos, std::vector<ChunkPos3> *p_waiters) {
+	std::size_t begin = p_waiters->size();
+	m_waiters.erase_fn(chunk_pos, [p_waiters](std::vector<ChunkPos3> &vec) {
+		p_waiters->insert(p_waiters->end(), vec.begin(), vec.end());
+		return true;
+	});
+	for (std::size_t i = begin; i < p_waiters->size(); ++i)
+		m_scheduler.Insert((*p_waiters)[i]);
+}
+
+template <ChunkTaskPriority... TaskPriorities>
+void ChunkTaskPool::pop_entry(ChunkTaskPoolLocked *p_locked_pool, ChunkTaskStatsRecorder *p_stats,
+                              const ChunkPos3 &chunk_pos, std::chrono::steady_clock::time_point pop_time,
+                              std::vector<RunnerDataVariant> *p_runner_data_vec) {
+	DataTuple *p_data_tuple = p_locked_pool->find(chunk_pos);
+	if (p_data_tuple == nullptr) {
+		m_scheduler.Erase(chunk_pos);
+		return;
+	}
+	// The position is blocked if every queued task failed to pop because of a blocker
+	bool popped = false, skipped = false, erase;
+	std::array<ChunkPos3, static_cast<std::size_t>(ChunkTaskType::COUNT)> blockers;
+	std::size_t attempt_count = 0, blocker_count = 0;
+	std::apply(
+	    [&](auto &&...data) {
+		    (
+		        [&] {
+			        if (data.m_running || !data.IsQueued())
+				        return;
+			        {
+				        auto p = data.GetPriority();
+				        if (((p != TaskPriorities) && ...)) {
+					        skipped = true;
+					        return;
+				        }
+			        }
+			        ++attempt_count;
+			        p_locked_pool->m_blocker.reset();
+			        auto runner_data_opt = data.Pop(*p_locked_pool, chunk_pos);
+			        constexpr ChunkTaskType kType = std::decay_t<decltype(data)>::kType;
+			        if (runner_data_opt.has_value()) {
+				        p_runner_data_vec->emplace_back(std::move(runner_data_opt.value()));
+				        p_stats->OnPop(kType,
+				                       std::chrono::duration_cast<std::chrono::microseconds>(pop_time - data.m_push_time)
+				                           .count());
+
+				        data.m_running = true;
+				        if constexpr (is_tracked_around(kType))
+					        get_data_shard(chunk_pos).running.emplace_back(chunk_pos, kType);
+				        popped = true;
+			        } else if (p_locked_pool->m_blocker.has_value()) {
+				        blockers[blocker_count++] = p_locked_pool->m_blocker.value();
+				        p_stats->OnReject(kType);
+			        }
+		        }(),
+		        ...);
+		    erase = !(data.NotIdle() || ...);
+	    },
+	    *p_data_tuple);
+	bool blocked = !popped && !skipped && attempt_count && blocker_count == attempt_count;
+
+	if (erase) {
+		p_locked_pool->erase(chunk_pos);
+		m_scheduler.Erase(chunk_pos);
+		m_spawn_owners.erase(chunk_pos);
+	} else if (blocked) {
+		// Blockers are within kPopRadius, so the tasks finishing there can't reach notify_waiters() before the regions
+		// are unlocked
+		for (std::size_t i = 0; i < blocker_count; ++i)
+			m_waiters.uprase_fn(blockers[i], [&chunk_pos](std::vector<ChunkPos3> &waiters, libcuckoo::UpsertContext) {
+				if (std::find(waiters.begin(), waiters.end(), chunk_pos) == waiters.end())
+					waiters.push_back(chunk_pos);
+				return false;
+			});
+		m_scheduler.Block(chunk_pos);
+	} else if (!popped)
+		m_scheduler.Defer(chunk_pos);
+}
+
+template <ChunkTaskPriority... TaskPriorities>
+void ChunkTaskPool::pop_entries(ChunkTaskPoolLocked *p_locked_pool, ChunkTaskStatsRecorder *p_stats,
+                                std::span<const ChunkPos3> positions, std::size_t max_tasks,
+                                std::vector<RunnerDataVariant> *p_runner_data_vec) {
+	auto pop_time = std::chrono::steady_clock::now();
+	for (const auto &chunk_pos : positions) {
+		pop_entry<TaskPriorities...>(p_locked_pool, p_stats, chunk_pos, pop_time, p_runner_data_vec);
+		if (p_runner_data_vec->size() > max_tasks)
+			break;
+	}
+}
 
 template <ChunkTaskPriority... TaskPriorities>
-void ChunkTaskPool::produce_runner_data(moodycamel::ConcurrentQueue<ChunkTaskPool::RunnerDataVariant> *p_queue,
-                                        const moodycamel::ProducerToken &token, std::size_t max_tasks) {
-	auto center_pos = m_world.GetCenterChunkPos();
-	auto load_radius = m_world.GetLoadChunkRadius(), unload_radius = m_world.GetUnloadChunkRadius();
+bool ChunkTaskPool::produce_runner_data(ChunkTaskPoolToken *p_token, bool high_priority, std::size_t max_tasks) {
+	ChunkPos3 center_pos = m_world.GetCenterChunkPos();
+	ChunkLoadShape load_shape = m_world.GetLoadShape();
+	m_scheduler.Update(center_pos, load_shape, m_world.GetUnloadShape(), m_world.GetMaxLoadChunkY(),
+	                   m_world.GetCenterView());
+	if (center_pos != m_waiters_center_pos || load_shape != m_waiters_load_shape) {
+		m_waiters_center_pos = center_pos;
+		m_waiters_load_shape = load_shape;
+		// Blockers that left the loaded area may never finish, so all blocked positions are polled once again
+		auto locked_waiters = m_waiters.lock_table();
+		for (const auto &it : locked_waiters)
+			for (const auto &waiter : it.second)
+				m_scheduler.Insert(waiter);
+		locked_waiters.clear();
+	}
+
+	std::vector<ChunkPos3> unload_positions, positions;
+	m_scheduler.CollectUnload(kChunkTaskMaxVisits, &unload_positions);
+	m_scheduler.CollectNearest(kChunkTaskMaxVisits, &positions);
 
 	std::vector<RunnerDataVariant> runner_data_vec;
 	{
-		std::vector<ChunkTaskSortEntry> sort_entries;
-
 		ChunkTaskPoolLocked locked_pool{this};
-		auto &locked_data_map = locked_pool.GetDataMap();
+
 		// Unload and Erase empty data
-		for (auto it = locked_data_map.begin(); it != locked_data_map.end();) {
-			bool erase = false;
-			const auto &chunk_pos = it->first;
-			uint32_t dist2 = ChunkPosDistance2(chunk_pos, center_pos);
-			bool unload = dist2 > uint32_t(unload_radius * unload_radius),
-			     load = dist2 <= uint32_t(load_radius * load_radius);
-			std::apply(
-			    [&erase, unload](auto &&...data) {
-				    if (unload)
+		for (const auto &chunk_pos : unload_positions) {
+			DataTuple *p_data_tuple = locked_pool.find(chunk_pos);
+			bool erase = p_data_tuple == nullptr;
+			if (!erase)
+				std::apply(
+				    [&erase](auto &&...data) {
 					    ([&] { data.OnUnload(); }(), ...);
-				    erase = !(data.NotIdle() || ...);
-			    },
-			    it->second);
-
-			if (erase)
-				it = locked_data_map.erase(it);
-			else {
-				if (load)
-					sort_entries.push_back({chunk_pos, uint16_t(dist2)});
-				++it;
+					    erase = !(data.NotIdle() || ...);
+				    },
+				    *p_data_tuple);
+			if (erase) {
+				if (p_data_tuple)
+					locked_pool.erase(chunk_pos);
+				m_scheduler.Erase(chunk_pos);
+				m_spawn_owners.erase(chunk_pos);
 			}
 		}
 
-		// Sort entries
-		std::sort(sort_entries.begin(), sort_entries.end());
-
-		// Push Entries
-		for (const auto &e : sort_entries) {
-			std::apply(
-			    [&e, &runner_data_vec, &locked_pool](auto &&...data) {
-				    (
-				        [&] {
-					        if (data.m_running)
-						        return;
-					        {
-						        auto p = data.GetPriority();
-						        if (((p != TaskPriorities) && ...))
-							        return;
-					        }
-					        auto runner_data_opt = data.Pop(locked_pool, e.pos);
-					        if (runner_data_opt.has_value()) {
-						        runner_data_vec.emplace_back(std::move(runner_data_opt.value()));
-
-						        data.m_running = true;
-					        }
-				        }(),
-				        ...);
-			    },
-			    locked_data_map.find(e.pos)->second);
-			if (runner_data_vec.size() > max_tasks)
-				break;
-		}
+		// Pop from the nearest entries
+		pop_entries<TaskPriorities...>(&locked_pool, &m_stats_recorders[p_token->m_worker_index], positions, max_tasks,
+		                               &runner_data_vec);
+	}
+	if (runner_data_vec.empty())
+		return false;
+
+	// Tasks pushed by a runner go to the worker that ran it, so that neighbouring chunk work stays on one thread
+	std::size_t worker_count = std::min(m_worker_count.load(std::memory_order_relaxed), kMaxWorkers);
+	std::vector<std::vector<RunnerDataVariant>> worker_runner_data_vecs(worker_count);
+	for (auto &runner_data : runner_data_vec) {
+		ChunkPos3 chunk_pos = std::visit(
+		    [](const auto &runner_data) -> ChunkPos3 {
+			    if constexpr (std::is_same_v<std::decay_t<decltype(runner_data)>, std::monostate>)
+				    return {};
+			    else
+				    return runner_data.GetChunkPos();
+		    },
+		    runner_data);
+		std::size_t worker_index = p_token->m_worker_index;
+		m_spawn_owners.erase_fn(chunk_pos, [&worker_index, worker_count](std::size_t owner) {
+			if (owner < worker_count)
+				worker_index = owner;
+			return true;
+		});
+		worker_runner_data_vecs[worker_index].push_back(std::move(runner_data));
+	}
+	for (std::size_t i = 0; i < worker_count; ++i)
+		if (!worker_runner_data_vecs[i].empty())
+			enqueue(i, high_priority, std::move(worker_runner_data_vecs[i]));
+
+	if (runner_data_vec.size() > 1)
+		Wake(true);
+	return true;
+}
+
+void ChunkTaskPool::pop_local(ChunkTaskPoolToken *p_token) {
+	auto &positions = p_token->m_local_positions;
+	if (positions.empty())
+		return;
+	HC_TRACE_ZONE("ChunkTaskPool::PopLocal");
+	// Like the producer, only pop inside the load shape
+	ChunkPos3 center_pos = m_world.GetCenterChunkPos();
+	ChunkLoadShape load_shape = m_world.GetLoadShape();
+	ChunkPos1 max_y = m_world.GetMaxLoadChunkY();
+	auto pop_time = std::chrono::steady_clock::now();
+	std::vector<RunnerDataVariant> runner_data_vec;
+	for (std::size_t i = 0; i < positions.size(); ++i) {
+		const ChunkPos3 &chunk_pos = positions[i];
+		if (chunk_pos.y > max_y || !load_shape.Contains(chunk_pos - center_pos) ||
+		    std::find(positions.begin(), positions.begin() + (std::ptrdiff_t)i, chunk_pos) !=
+		        positions.begin() + (std::ptrdiff_t)i)
+			continue;
+		ChunkTaskPoolLocked locked_pool{this, chunk_pos};
+		pop_entry<ChunkTaskPriority::kHigh, ChunkTaskPriority::kLow>(
+		    &locked_pool, &m_stats_recorders[p_token->m_worker_index], chunk_pos, pop_time, &runner_data_vec);
 	}
-	if (!runner_data_vec.empty()) {
-		p_queue->enqueue_bulk(token, std::make_move_iterator(runner_data_vec.begin()), runner_data_vec.size());
+	positions.clear();
+	if (runner_data_vec.empty())
+		return;
+	bool wake = runner_data_vec.size() > 1;
+	enqueue(p_token->m_worker_index, false, std::move(runner_data_vec));
+	if (wake)
+		Wake(true);
+}
+
+void ChunkTaskPool::enqueue(std::size_t worker_index, bool high_priority, std::vector<RunnerDataVariant> &&vec) {
+	m_queued_count.fetch_add(vec.size(), std::memory_order_relaxed);
+	WorkerQueue &queue = m_worker_queues[worker_index];
+	std::scoped_lock lock{queue.mutex};
+	auto &deque = high_priority ? queue.high_priority : queue.low_priority;
+	deque.insert(deque.end(), std::make_move_iterator(vec.begin()), std::make_move_iterator(vec.end()));
+}
+
+bool ChunkTaskPool::dequeue_own(ChunkTaskPoolToken *p_token, bool high_priority, RunnerDataVariant *p_runner_data) {
+	WorkerQueue &queue = m_worker_queues[p_token->m_worker_index];
+	std::scoped_lock lock{queue.mutex};
+	auto &deque = high_priority ? queue.high_priority : queue.low_priority;
+	if (deque.empty())
+		return false;
+	*p_runner_data = std::move(deque.front());
+	deque.pop_front();
+	m_queued_count.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool ChunkTaskPool::dequeue(ChunkTaskPoolToken *p_token, RunnerDataVariant *p_runner_data) {
+	return dequeue_own(p_token, true, p_runner_data) || steal(p_token, true, p_runner_data) ||
+	       dequeue_own(p_token, false, p_runner_data) || steal(p_token, false, p_runner_data);
+}
+
+bool ChunkTaskPool::steal(ChunkTaskPoolToken *p_token, bool high_priority, RunnerDataVariant *p_runner_data) {
+	std::size_t worker_count = std::min(m_worker_count.load(std::memory_order_relaxed), kMaxWorkers);
+	for (std::size_t i = 1; i < worker_count; ++i) {
+		WorkerQueue &queue = m_worker_queues[(p_token->m_worker_index + i) % worker_count];
+		std::scoped_lock lock{queue.mutex};
+		auto &deque = high_priority ? queue.high_priority : queue.low_priority;
+		if (deque.empty())
+			continue;
+		*p_runner_data = std::move(deque.back());
+		deque.pop_back();
+		m_queued_count.fetch_sub(1, std::memory_order_relaxed);
+		return true;
 	}
+	return false;
+}
+
+ChunkTaskStats ChunkTaskPool::GetTaskStats() const {
+	ChunkTaskStats stats;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_stats_begin_time).count();
+	for (const auto &recorder : m_stats_recorders)
+		recorder.Accumulate(&stats);
+	return stats;
+}
+
+void ChunkTaskPool::Park(uint64_t epoch, std::chrono::milliseconds timeout) {
+	std::unique_lock lock{m_park_mutex};
+	m_parked_count.fetch_add(1);
+	m_park_condition.wait_for(lock, timeout, [this, epoch] { return m_wake_epoch.load() != epoch; });
+	m_parked_count.fetch_sub(1);
 }
 
-void ChunkTaskPool::Run(ChunkTaskPoolToken *p_token) {
+bool ChunkTaskPool::Run(ChunkTaskPoolToken *p_token) {
+	// The tick and high priority tasks only go to the queues, so a worker goes on to run queued or produced tasks and
+	// is idle only if nothing was produced nor run
+	bool produced = false;
 	if (p_token->m_producer_config.max_tick_tasks) {
 		if (m_tick_producer_flag.exchange(false, std::memory_order_acq_rel)) {
+			HC_TRACE_ZONE("ChunkTaskPool::ProduceTick");
 			std::scoped_lock lock{m_producer_mutex};
-			produce_runner_data<ChunkTaskPriority::kTick>(&m_high_priority_runner_data_queue,
-			                                              p_token->m_high_priority_producer_token,
-			                                              p_token->m_producer_config.max_tick_tasks);
-			return;
+			HC_TRACE_ZONE("producer locked");
+			produced |= produce_runner_data<ChunkTaskPriority::kTick>(p_token, true,
+			                                                          p_token->m_producer_config.max_tick_tasks);
 		}
 	}
 	if (p_token->m_producer_config.max_high_priority_tasks) {
 		if (m_high_priority_producer_flag.exchange(false, std::memory_order_acq_rel)) {
+			HC_TRACE_ZONE("ChunkTaskPool::ProduceHighPriority");
 			std::scoped_lock lock{m_producer_mutex};
-			produce_runner_data<ChunkTaskPriority::kHigh>(&m_high_priority_runner_data_queue,
-			                                              p_token->m_high_priority_producer_token,
-			                                              p_token->m_producer_config.max_high_priority_tasks);
-			return;
+			HC_TRACE_ZONE("producer locked");
+			produced |= produce_runner_data<ChunkTaskPriority::kHigh>(
+			    p_token, true, p_token->m_producer_config.max_high_priority_tasks);
 		}
 	}
 
 	RunnerDataVariant runner_data = std::monostate{};
-	if (!m_high_priority_runner_data_queue.try_dequeue(p_token->m_high_priority_consumer_token, runner_data) &&
-	    !m_low_priority_runner_data_queue.try_dequeue(p_token->m_low_priority_consumer_token, runner_data)) {
+	if (!dequeue(p_token, &runner_data)) {
+		// The outer zone includes the wait for the producer mutex
+		HC_TRACE_ZONE("ChunkTaskPool::Produce");
 		std::scoped_lock lock{m_producer_mutex};
-		if (!m_low_priority_runner_data_queue.try_dequeue(p_token->m_low_priority_consumer_token, runner_data)) {
-			produce_runner_data<ChunkTaskPriority::kHigh, ChunkTaskPriority::kLow>(
-			    &m_low_priority_runner_data_queue, p_token->m_low_priority_producer_token,
-			    p_token->m_producer_config.max_tasks);
-			return;
+		HC_TRACE_ZONE("producer locked");
+		if (!dequeue(p_token, &runner_data)) {
+			produced |= produce_runner_data<ChunkTaskPriority::kHigh, ChunkTaskPriority::kLow>(
+			    p_token, false, p_token->m_producer_config.max_tasks);
+			return produced;
 		}
 	}
 
@@ -120,12 +317,32 @@ void ChunkTaskPool::Run(ChunkTaskPoolToken *p_token) {
 	    [this, p_token](auto &&runner_data) {
 		    using T = std::decay_t<decltype(runner_data)>;
 		    if constexpr (!std::is_same_v<T, std::monostate>) {
-			    std::get<ChunkTaskRunner<T::kType>>(p_token->m_runners).Run(this, std::forward<T>(runner_data));
-			    m_data_map.find_fn(runner_data.GetChunkPos(), [](auto &data) {
-				    std::get<static_cast<std::size_t>(T::kType)>(data).m_running = false;
-			    });
+			    auto run_time = std::chrono::steady_clock::now();
+			    t_running_token = p_token;
+			    {
+				    HC_TRACE_ZONE(GetChunkTaskTypeName(T::kType));
+				    std::get<ChunkTaskRunner<T::kType>>(p_token->m_runners).Run(this, std::forward<T>(runner_data));
+			    }
+			    t_running_token = nullptr;
+			    m_stats_recorders[p_token->m_worker_index].OnComplete(
+			        T::kType, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+			                                                                        run_time)
+			                      .count());
+			    {
+				    DataShard &shard = get_data_shard(runner_data.GetChunkPos());
+				    std::scoped_lock lock{shard.mutex};
+				    auto it = shard.map.find(runner_data.GetChunkPos());
+				    if (it != shard.map.end())
+					    std::get<static_cast<std::size_t>(T::kType)>(it->second).m_running = false;
+				    if constexpr (is_tracked_around(T::kType))
+					    shard.running.erase(std::find(shard.running.begin(), shard.running.end(),
+					                                  std::pair{runner_data.GetChunkPos(), T::kType}));
+			    }
+			    notify_waiters(runner_data.GetChunkPos(), &p_token->m_local_positions);
+			    pop_local(p_token);
 		    }
 	    },
 	    runner_data);
+	return true;
 }
 } // namespace hc::client
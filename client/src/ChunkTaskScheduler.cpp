@@ -0,0 +1,164 @@
+#include <client/ChunkTaskScheduler.hpp>
+
+#include <algorithm>
+
+namespace hc::client {
+
+void ChunkTaskScheduler::Shard::Insert(const ChunkPos3 &chunk_pos, uint32_t bucket) {
+	auto &positions = buckets[bucket];
+	slots[chunk_pos] = {bucket, (uint32_t)positions.size()};
+	positions.push_back(chunk_pos);
+}
+
+void ChunkTaskScheduler::Shard::Remove(const Slot &slot) {
+	auto &positions = buckets[slot.bucket];
+	if (slot.index + 1 != positions.size()) {
+		positions[slot.index] = positions.back();
+		slots[positions[slot.index]].index = slot.index;
+	}
+	positions.pop_back();
+}
+
+void ChunkTaskScheduler::Insert(const ChunkPos3 &chunk_pos) {
+	Shard &shard = get_shard(chunk_pos);
+	std::scoped_lock lock{shard.mutex};
+	auto it = shard.slots.find(chunk_pos);
+	if (it == shard.slots.end())
+		shard.Insert(chunk_pos, shard.GetBucket(chunk_pos));
+	else if (Slot slot = it->second; slot.bucket == shard.GetBlockedBucket()) {
+		shard.Remove(slot);
+		shard.Insert(chunk_pos, shard.GetBucket(chunk_pos));
+	}
+}
+
+void ChunkTaskScheduler::Block(const ChunkPos3 &chunk_pos) {
+	Shard &shard = get_shard(chunk_pos);
+	std::scoped_lock lock{shard.mutex};
+	auto it = shard.slots.find(chunk_pos);
+	if (it == shard.slots.end() || it->second.bucket >= shard.GetUnloadBucket())
+		return;
+	Slot slot = it->second;
+	shard.Remove(slot);
+	shard.Insert(chunk_pos, shard.GetBlockedBucket());
+}
+
+void ChunkTaskScheduler::Erase(const ChunkPos3 &chunk_pos) {
+	Shard &shard = get_shard(chunk_pos);
+	std::scoped_lock lock{shard.mutex};
+	auto it = shard.slots.find(chunk_pos);
+	if (it == shard.slots.end())
+		return;
+	Slot slot = it->second;
+	shard.slots.erase(it);
+	shard.Remove(slot);
+}
+
+void ChunkTaskScheduler::Defer(const ChunkPos3 &chunk_pos) {
+	Shard &shard = get_shard(chunk_pos);
+	std::scoped_lock lock{shard.mutex};
+	auto it = shard.slots.find(chunk_pos);
+	if (it == shard.slots.end())
+		return;
+	Slot slot = it->second;
+	shard.Remove(slot);
+	shard.Insert(chunk_pos, slot.bucket);
+}
+
+void ChunkTaskScheduler::Clear() {
+	for (Shard &shard : m_shards) {
+		std::scoped_lock lock{shard.mutex};
+		shard.slots.clear();
+		for (auto &positions : shard.buckets)
+			positions.clear();
+	}
+}
+
+void ChunkTaskScheduler::Update(const ChunkPos3 &center, const ChunkLoadShape &load_shape,
+                                const ChunkLoadShape &unload_shape, ChunkPos1 max_y, const ChunkTaskView &view) {
+	m_view = view;
+	if (center == m_center && load_shape == m_load_shape && unload_shape == m_unload_shape && max_y == m_max_y)
+		return;
+	m_center = center;
+	m_load_shape = load_shape;
+	m_unload_shape = unload_shape;
+	m_max_y = max_y;
+
+	std::vector<ChunkPos3> positions;
+	for (Shard &shard : m_shards) {
+		std::scoped_lock lock{shard.mutex};
+		shard.center = center;
+		shard.load_shape = load_shape;
+		shard.unload_shape = unload_shape;
+		shard.max_y = max_y;
+
+		// Blocked positions stay blocked unless they are to be unloaded
+		std::size_t blocked_begin = 0;
+		positions.clear();
+		for (uint32_t b = 0; b < shard.buckets.size(); ++b) {
+			auto &bucket = shard.buckets[b];
+			if (b + 1 == shard.buckets.size())
+				blocked_begin = positions.size();
+			positions.insert(positions.end(), bucket.begin(), bucket.end());
+			bucket.clear();
+		}
+		shard.buckets.resize(shard.GetBlockedBucket() + 1);
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			uint32_t bucket = shard.GetBucket(positions[i]);
+			if (i >= blocked_begin && bucket != shard.GetUnloadBucket())
+				bucket = shard.GetBlockedBucket();
+			shard.Insert(positions[i], bucket);
+		}
+	}
+}
+
+void ChunkTaskScheduler::CollectNearest(std::size_t max_count, std::vector<ChunkPos3> *p_positions) {
+	if (max_count == 0)
+		return;
+	uint32_t max_dist_key = ChunkTaskView::GetDistKey(m_load_shape.GetMaxDist2()), far_bucket = max_dist_key + 1,
+	         slack = m_view.GetKeySlack();
+
+	// Keys are small, so the candidates are counting-sorted, which keeps positions of the same key in bucket order
+	// (deferred positions stay behind). Positions in bucket b have keys of at least b - slack, so the buckets are walked
+	// until max_count candidates have keys that none of the rest can go below.
+	m_candidates.clear();
+	m_key_counts.assign(max_dist_key * ChunkTaskView::kOutOfViewFactor + 1, 0);
+	std::size_t final_count = 0;
+	uint32_t final_key = 0;
+	for (uint32_t b = 0; b < far_bucket && final_count < max_count; ++b) {
+		for (Shard &shard : m_shards) {
+			std::scoped_lock lock{shard.mutex};
+			for (const auto &pos : shard.buckets[b]) {
+				uint32_t key = m_view.GetKey(pos - m_center, max_dist_key);
+				m_candidates.push_back({key, pos});
+				++m_key_counts[key];
+			}
+		}
+		for (; final_key + slack <= b && final_count < max_count; ++final_key)
+			final_count += m_key_counts[final_key];
+	}
+
+	std::size_t count = std::min(m_candidates.size(), max_count);
+	std::size_t begin = p_positions->size();
+	p_positions->resize(begin + count);
+	for (uint32_t key = 0, offset = 0; key < m_key_counts.size(); ++key) {
+		uint32_t key_count = m_key_counts[key];
+		m_key_counts[key] = offset;
+		offset += key_count;
+	}
+	for (const auto &candidate : m_candidates)
+		if (uint32_t index = m_key_counts[candidate.key]++; index < count)
+			(*p_positions)[begin + index] = candidate.pos;
+}
+
+void ChunkTaskScheduler::CollectUnload(std::size_t max_count, std::vector<ChunkPos3> *p_positions) {
+	for (Shard &shard : m_shards) {
+		std::scoped_lock lock{shard.mutex};
+		const auto &bucket = shard.buckets[shard.GetUnloadBucket()];
+		std::size_t n = std::min(bucket.size(), max_count);
+		p_positions->insert(p_positions->end(), bucket.begin(), bucket.begin() + (std::ptrdiff_t)n);
+		if ((max_count -= n) == 0)
+			break;
+	}
+}
+
+} // namespace hc::client
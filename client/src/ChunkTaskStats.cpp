@@ -0,0 +1,74 @@
+#include <client/ChunkTaskStats.hpp>
+
+#include <cstdio>
+
+namespace hc::client {
+
+const char *GetChunkTaskTypeName(ChunkTaskType type) {
+	constexpr const char *kNames[kChunkTaskTypeCount] = {"generate", "set_block",      "set_sunlight", "light",
+	                                                     "mesh",     "flood_sunlight", "update_block"};
+	return kNames[static_cast<std::size_t>(type)];
+}
+
+ChunkTaskStats ChunkTaskStats::Since(const ChunkTaskStats &earlier) const {
+	ChunkTaskStats ret;
+	ret.seconds = seconds - earlier.seconds;
+	for (std::size_t t = 0; t < kChunkTaskTypeCount; ++t) {
+		const auto &l = types[t], &r = earlier.types[t];
+		ret.types[t] = {l.popped - r.popped, l.rejected - r.rejected, l.completed - r.completed,
+		                l.queue_time.Since(r.queue_time), l.run_time.Since(r.run_time)};
+	}
+	return ret;
+}
+
+std::string ChunkTaskStats::ToCSV() const {
+	std::string csv = "type,popped,rejected,completed,tasks_per_second,queue_mean_us,queue_p50_us,queue_p90_us,"
+	                  "queue_p99_us,run_mean_us,run_p50_us,run_p90_us,run_p99_us\n";
+	char line[512];
+	for (std::size_t t = 0; t < kChunkTaskTypeCount; ++t) {
+		auto type = static_cast<ChunkTaskType>(t);
+		const auto &s = types[t];
+		snprintf(line, sizeof(line), "%s,%llu,%llu,%llu,%.2f,%.1f,%llu,%llu,%llu,%.1f,%llu,%llu,%llu\n",
+		         GetChunkTaskTypeName(type), (unsigned long long)s.popped, (unsigned long long)s.rejected,
+		         (unsigned long long)s.completed, GetTasksPerSecond(type), s.queue_time.GetMeanUs(),
+		         (unsigned long long)s.queue_time.GetQuantileUs(0.5),
+		         (unsigned long long)s.queue_time.GetQuantileUs(0.9),
+		         (unsigned long long)s.queue_time.GetQuantileUs(0.99), s.run_time.GetMeanUs(),
+		         (unsigned long long)s.run_time.GetQuantileUs(0.5), (unsigned long long)s.run_time.GetQuantileUs(0.9),
+		         (unsigned long long)s.run_time.GetQuantileUs(0.99));
+		csv += line;
+	}
+	return csv;
+}
+
+std::string ChunkTaskStats::ToJSON() const {
+	std::string json = "{\"seconds\":" + std::to_string(seconds) + ",\"types\":{";
+	for (std::size_t t = 0; t < kChunkTaskTypeCount; ++t) {
+		auto type = static_cast<ChunkTaskType>(t);
+		const auto &s = types[t];
+		json += std::string{t ? "," : ""} + "\"" + GetChunkTaskTypeName(type) + "\":{" +
+		        "\"popped\":" + std::to_string(s.popped) + ",\"rejected\":" + std::to_string(s.rejected) +
+		        ",\"completed\":" + std::to_string(s.completed) +
+		        ",\"tasks_per_second\":" + std::to_string(GetTasksPerSecond(type)) +
+		        ",\"queue_time\":" + s.queue_time.ToJSON() + ",\"run_time\":" + s.run_time.ToJSON() + "}";
+	}
+	return json + "}}";
+}
+
+void ChunkTaskStatsRecorder::Accumulate(ChunkTaskStats *p_stats) const {
+	for (std::size_t t = 0; t < kChunkTaskTypeCount; ++t) {
+		const auto &counters = m_types[t];
+		auto &s = p_stats->types[t];
+		s.popped += counters.popped.load(std::memory_order_relaxed);
+		s.rejected += counters.rejected.load(std::memory_order_relaxed);
+		s.completed += counters.completed.load(std::memory_order_relaxed);
+		s.queue_time.sum_us += counters.queue_sum_us.load(std::memory_order_relaxed);
+		s.run_time.sum_us += counters.run_sum_us.load(std::memory_order_relaxed);
+		for (uint32_t b = 0; b < LatencyHistogram::kBucketCount; ++b) {
+			s.queue_time.buckets[b] += counters.queue_buckets[b].load(std::memory_order_relaxed);
+			s.run_time.buckets[b] += counters.run_buckets[b].load(std::memory_order_relaxed);
+		}
+	}
+}
+
+} // namespace hc::client
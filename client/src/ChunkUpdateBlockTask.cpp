@@ -18,11 +18,11 @@ ChunkTaskData<ChunkTaskType::kUpdateBlock>::Pop(const ChunkTaskPoolLocked &task_
 		nei_pos += chunk_pos;
 
 		if (task_pool.AnyNotIdle<ChunkTaskType::kGenerate, ChunkTaskType::kSetBlock>(nei_pos))
-			return std::nullopt;
+			return task_pool.Block(nei_pos);
 
 		std::shared_ptr<Chunk> nei_chunk = task_pool.GetWorld().GetChunkPool().FindChunk(nei_pos);
 		if (nei_chunk == nullptr)
-			return std::nullopt;
+			return task_pool.Block(nei_pos);
 		chunks[i] = std::move(nei_chunk);
 	}
 
@@ -53,8 +53,15 @@ void ChunkTaskRunner<ChunkTaskType::kUpdateBlock>::Run(ChunkTaskPool *p_task_poo
 	const auto &neighbour_chunks = data.GetChunkPtrArray();
 	const auto &chunk = neighbour_chunks.back();
 
-	const auto get_block = [&neighbour_chunks](auto x, auto y, auto z) -> block::Block {
-		return neighbour_chunks[Chunk::GetBlockNeighbourIndex(x, y, z)]->GetBlockFromNeighbour(x, y, z);
+	m_neighbourhood.GatherBlocks(neighbour_chunks);
+	const auto get_block = [this](auto x, auto y, auto z) -> block::Block { return m_neighbourhood.GetBlock(x, y, z); };
+	const auto get_far_block = [&neighbour_chunks, &get_block](InnerPos3 pos) -> block::Block {
+		using Neighbourhood = decltype(m_neighbourhood);
+		if (glm::all(glm::greaterThanEqual(pos, InnerPos3(Neighbourhood::kMin))) &&
+		    glm::all(glm::lessThan(pos, InnerPos3(Neighbourhood::kMax))))
+			return get_block(pos.x, pos.y, pos.z);
+		return neighbour_chunks[Chunk::GetBlockNeighbourIndex(pos.x, pos.y, pos.z)]->GetBlockFromNeighbour(
+		    pos.x, pos.y, pos.z);
 	};
 
 	std::vector<ChunkBlockEntry> set_blocks[27];
@@ -67,14 +74,13 @@ void ChunkTaskRunner<ChunkTaskType::kUpdateBlock>::Run(ChunkTaskPool *p_task_poo
 		for (uint32_t i = 0; i < p_blk_event->update_neighbour_count; ++i) {
 			InnerPos3 pos = update_pos + p_blk_event->update_neighbours[i];
 			m_update_neighbour_pos[i] = pos;
-			m_update_neighbours[i] = get_block(pos.x, pos.y, pos.z);
+			m_update_neighbours[i] = get_far_block(pos);
 		}
 		std::copy(m_update_neighbours, m_update_neighbours + p_blk_event->update_neighbour_count, m_update_set_blocks);
 
 		p_blk_event->on_update_func(m_update_neighbours, m_update_set_blocks,
-		                            [&update_pos, &get_block](glm::i8vec3 pos) {
-			                            pos += update_pos;
-			                            return get_block(pos.x, pos.y, pos.z);
+		                            [&update_pos, &get_far_block](glm::i8vec3 pos) {
+			                            return get_far_block(update_pos + InnerPos3(pos));
 		                            });
 		for (uint32_t i = 0; i < p_blk_event->update_neighbour_count; ++i) {
 			block::Block set_blk = m_update_set_blocks[i];
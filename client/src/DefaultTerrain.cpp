@@ -2,127 +2,136 @@
 
 #include <client/Chunk.hpp>
 #include <climits>
+#include <common/Trace.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <random>
 
 namespace hc::client {
 
 void DefaultTerrain::Generate(const std::shared_ptr<Chunk> &chunk_ptr) {
+	HC_TRACE_ZONE("DefaultTerrain::Generate");
 #if 1
 	std::shared_ptr<const XZInfo> xz_info = m_xz_cache.Acquire(
 	    chunk_ptr->GetPosition().xz(), [this](const ChunkPos2 &pos, XZInfo *info) { generate_xz_info(pos, info); });
 
 	// base biome blocks
-	for (uint32_t y = 0; y < kChunkSize; ++y) {
-		uint32_t noise_index = 0;
-		for (uint32_t z = 0; z < kChunkSize; ++z) {
-			for (uint32_t x = 0; x < kChunkSize; ++x, ++noise_index) {
-				int32_t height = xz_info->height_map[noise_index],
-				        cur_height = chunk_ptr->GetPosition().y * (int)kChunkSize + (int)y;
-				Biome biome = xz_info->biome_map[noise_index];
-				auto meta = xz_info->meta[noise_index];
-
-				if (xz_info->is_ocean[noise_index]) {
-					Block surface = Blocks::kSand;
-					if (biome == Biomes::kBorealForest || biome == Biomes::kTropicalForest)
-						surface = Blocks::kGravel;
-					else if (biome == Biomes::kTundra)
-						surface = Blocks::kCobblestone;
-					else if (biome == Biomes::kGlacier)
-						surface = Blocks::kSnow;
-					if (cur_height <= height) {
-						int32_t sand_height = -int32_t(meta % 4u);
-						chunk_ptr->SetBlock(x, y, z, (cur_height >= sand_height ? surface : Blocks::kStone));
-					} else if (cur_height <= 0) {
-						chunk_ptr->SetBlock(x, y, z, Blocks::kWater);
+	BlockPos1 base_height = chunk_ptr->GetPosition().y * (BlockPos1)kChunkSize,
+	          top_height = base_height + (BlockPos1)kChunkSize - 1;
+	if (top_height < std::min(xz_info->min_height, 0) - kMaxSurfaceDepth) {
+		// only stone below every surface layer
+		chunk_ptr->FillBlocks(Blocks::kStone);
+	} else if (base_height <= std::max(xz_info->max_height, 0)) { // chunks above terrain and sea level stay uniform air
+		for (uint32_t y = 0; y < kChunkSize; ++y) {
+			uint32_t noise_index = 0;
+			for (uint32_t z = 0; z < kChunkSize; ++z) {
+				for (uint32_t x = 0; x < kChunkSize; ++x, ++noise_index) {
+					int32_t height = xz_info->height_map[noise_index],
+					        cur_height = chunk_ptr->GetPosition().y * (int)kChunkSize + (int)y;
+					Biome biome = xz_info->biome_map[noise_index];
+					auto meta = xz_info->meta[noise_index];
+
+					if (xz_info->is_ocean[noise_index]) {
+						Block surface = Blocks::kSand;
+						if (biome == Biomes::kBorealForest || biome == Biomes::kTropicalForest)
+							surface = Blocks::kGravel;
+						else if (biome == Biomes::kTundra)
+							surface = Blocks::kCobblestone;
+						else if (biome == Biomes::kGlacier)
+							surface = Blocks::kSnow;
+						if (cur_height <= height) {
+							int32_t sand_height = -int32_t(meta % 4u);
+							chunk_ptr->SetBlock(x, y, z, (cur_height >= sand_height ? surface : Blocks::kStone));
+						} else if (cur_height <= 0) {
+							chunk_ptr->SetBlock(x, y, z, Blocks::kWater);
+						}
+						continue;
 					}
-					continue;
-				}
 
-				switch (biome) {
-				case Biomes::kPlain:
-					if (cur_height == height) {
-						chunk_ptr->SetBlock(x, y, z, {Blocks::kGrassBlock, BlockVariants::Grass::kPlain, 0});
-					} else if (cur_height < height) {
-						int32_t dirt_height = height - int32_t(meta % 4u) - 1;
-						chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-					}
-					break;
-				case Biomes::kSavanna:
-					if (cur_height == height) {
-						chunk_ptr->SetBlock(x, y, z, {Blocks::kGrassBlock, BlockVariants::Grass::kSavanna, 0});
-					} else if (cur_height < height) {
-						int32_t dirt_height = height - int32_t(meta % 6u) - 3;
-						chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-					}
-					break;
-					// TODO: Better tundra generation
-				case Biomes::kTundra: {
-					if (cur_height <= height) {
-						if ((meta % (height + 64)) == 0) {
-							int32_t dirt_height = height - int32_t(meta % 3u);
+					switch (biome) {
+					case Biomes::kPlain:
+						if (cur_height == height) {
+							chunk_ptr->SetBlock(x, y, z, {Blocks::kGrassBlock, BlockVariants::Grass::kPlain, 0});
+						} else if (cur_height < height) {
+							int32_t dirt_height = height - int32_t(meta % 4u) - 1;
 							chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-						} else if ((meta % (std::max(128 - height, 1))) == 0) {
-							int32_t snow_height = height - int32_t(meta % 2u);
-							chunk_ptr->SetBlock(x, y, z, cur_height >= snow_height ? Blocks::kSnow : Blocks::kStone);
-						} else
-							chunk_ptr->SetBlock(x, y, z, Blocks::kStone);
-					}
-				} break;
-				case Biomes::kGlacier: {
-					int32_t ice_height = height - int32_t(meta % 8u);
-					bool snow_cover = xz_info->meta[noise_index] % 16;
-					if (cur_height <= height)
-						chunk_ptr->SetBlock(
-						    x, y, z,
-						    cur_height >= ice_height
-						        ? (snow_cover && cur_height == height ? Blocks::kSnow : Blocks::kBlueIce)
-						        : Blocks::kStone);
-				} break;
-				case Biomes::kDesert: {
-					if (cur_height <= height) {
-						int32_t sand_height = height - int32_t(meta % 4u);
-						if (sand_height <= cur_height) {
-							chunk_ptr->SetBlock(x, y, z, Blocks::kSand);
-						} else {
-							int32_t sandstone_height = sand_height - int32_t(meta % 6u);
-							chunk_ptr->SetBlock(x, y, z,
-							                    cur_height >= sandstone_height ? Blocks::kSandstone : Blocks::kStone);
 						}
+						break;
+					case Biomes::kSavanna:
+						if (cur_height == height) {
+							chunk_ptr->SetBlock(x, y, z, {Blocks::kGrassBlock, BlockVariants::Grass::kSavanna, 0});
+						} else if (cur_height < height) {
+							int32_t dirt_height = height - int32_t(meta % 6u) - 3;
+							chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
+						}
+						break;
+						// TODO: Better tundra generation
+					case Biomes::kTundra: {
+						if (cur_height <= height) {
+							if ((meta % (height + 64)) == 0) {
+								int32_t dirt_height = height - int32_t(meta % 3u);
+								chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
+							} else if ((meta % (std::max(128 - height, 1))) == 0) {
+								int32_t snow_height = height - int32_t(meta % 2u);
+								chunk_ptr->SetBlock(x, y, z, cur_height >= snow_height ? Blocks::kSnow : Blocks::kStone);
+							} else
+								chunk_ptr->SetBlock(x, y, z, Blocks::kStone);
+						}
+					} break;
+					case Biomes::kGlacier: {
+						int32_t ice_height = height - int32_t(meta % 8u);
+						bool snow_cover = xz_info->meta[noise_index] % 16;
+						if (cur_height <= height)
+							chunk_ptr->SetBlock(
+							    x, y, z,
+							    cur_height >= ice_height
+							        ? (snow_cover && cur_height == height ? Blocks::kSnow : Blocks::kBlueIce)
+							        : Blocks::kStone);
+					} break;
+					case Biomes::kDesert: {
+						if (cur_height <= height) {
+							int32_t sand_height = height - int32_t(meta % 4u);
+							if (sand_height <= cur_height) {
+								chunk_ptr->SetBlock(x, y, z, Blocks::kSand);
+							} else {
+								int32_t sandstone_height = sand_height - int32_t(meta % 6u);
+								chunk_ptr->SetBlock(x, y, z,
+								                    cur_height >= sandstone_height ? Blocks::kSandstone : Blocks::kStone);
+							}
+						}
+					} break;
+					case Biomes::kForest: {
+						if (cur_height == height) {
+							chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kPlain, 0});
+						} else if (cur_height < height) {
+							int32_t dirt_height = height - int32_t(meta % 6u) - 3;
+							chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
+						}
+					} break;
+					case Biomes::kTropicalForest: {
+						if (cur_height == height) {
+							chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kTropical, 0});
+						} else if (cur_height < height) {
+							int32_t dirt_height = height - int32_t(meta % 6u) - 3;
+							chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
+						}
+					} break;
+					case Biomes::kBorealForest: {
+						if (cur_height == height) {
+							chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kBoreal, 0});
+						} else if (cur_height < height) {
+							int32_t dirt_height = height - int32_t(meta % 6u) - 3;
+							chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
+						}
+					} break;
+					default:
+						break;
 					}
-				} break;
-				case Biomes::kForest: {
-					if (cur_height == height) {
-						chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kPlain, 0});
-					} else if (cur_height < height) {
-						int32_t dirt_height = height - int32_t(meta % 6u) - 3;
-						chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-					}
-				} break;
-				case Biomes::kTropicalForest: {
-					if (cur_height == height) {
-						chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kTropical, 0});
-					} else if (cur_height < height) {
-						int32_t dirt_height = height - int32_t(meta % 6u) - 3;
-						chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-					}
-				} break;
-				case Biomes::kBorealForest: {
-					if (cur_height == height) {
-						chunk_ptr->SetBlock(x, y, z, Block{Blocks::kGrassBlock, BlockVariants::Grass::kBoreal, 0});
-					} else if (cur_height < height) {
-						int32_t dirt_height = height - int32_t(meta % 6u) - 3;
-						chunk_ptr->SetBlock(x, y, z, cur_height >= dirt_height ? Blocks::kDirt : Blocks::kStone);
-					}
-				} break;
-				default:
-					break;
 				}
 			}
 		}
 	}
 	// cave
-	if ((BlockPos1)chunk_ptr->GetPosition().y * (BlockPos1)kChunkSize <= xz_info->max_height) {
+	if (base_height <= xz_info->max_height) {
 		// Generate a 16 x 16 x 16 area of noise
 		thread_local static float cave_noise_output[kChunkSize * kChunkSize * kChunkSize];
 		m_cave_noise->GenUniformGrid3D(cave_noise_output, chunk_ptr->GetPosition().x * (int)kChunkSize,
@@ -146,7 +155,6 @@ void DefaultTerrain::Generate(const std::shared_ptr<Chunk> &chunk_ptr) {
 	    });
 	combined_xz_info->decoration.PopToChunk(chunk_ptr);
 	// set initial sunlight from light_map
-	BlockPos1 base_height = chunk_ptr->GetPosition().y * (BlockPos1)kChunkSize;
 	for (uint32_t idx = 0; idx < kChunkSize * kChunkSize; ++idx)
 		chunk_ptr->SetSunlightHeight(
 		    idx, (InnerPos1)(std::clamp(combined_xz_info->light_map[idx] - base_height + 1, 0, (BlockPos1)kChunkSize)));
@@ -332,6 +340,7 @@ void DefaultTerrain::generate_xz_info(const ChunkPos2 &pos, XZInfo *info) {
 	thread_local static float surface_query_x[kChunkSize * kChunkSize], surface_query_y[kChunkSize * kChunkSize],
 	    surface_query_z[kChunkSize * kChunkSize];
 	info->max_height = INT32_MIN;
+	info->min_height = INT32_MAX;
 	for (uint32_t index = 0, x, z; index < kChunkSize * kChunkSize; ++index) {
 		x = index % kChunkSize;
 		z = index / kChunkSize;
@@ -345,6 +354,7 @@ void DefaultTerrain::generate_xz_info(const ChunkPos2 &pos, XZInfo *info) {
 		info->height_map[index] = ceil32(final_height);
 
 		info->max_height = std::max(info->max_height, info->height_map[index]);
+		info->min_height = std::min(info->min_height, info->height_map[index]);
 		info->biome_map[index] =
 		    get_biome(biome_precipitation_cell_output[index], biome_temperature_cell_output[index]);
 		info->is_ocean[index] = info->height_map[index] <= 0;
@@ -513,4 +523,24 @@ void DefaultTerrain::DecorationInfo::PopToChunk(const std::shared_ptr<Chunk> &ch
 	}
 }
 
+std::optional<BlockPos1> DefaultTerrain::GetMaxHeight() const {
+	// The height noise stays about within [-1, 1], sampled with a margin, while rivers and caves only dig into terrain
+	float max_height = 0.0f;
+	for (int32_t i = -320; i <= 320; ++i)
+		for (Biome biome = Biomes::kOcean; biome <= Biomes::kBorealForest; ++biome)
+			max_height = std::max(max_height, biome_height_transform(biome, float(i) / 256.0f));
+	return ceil32(max_height * (float)kHeightRange) + kMaxDecorationHeight;
+}
+
+std::size_t DefaultTerrain::GetCacheBytes() const {
+	return m_xz_cache.GetSize() * sizeof(XZInfo) + m_combined_xz_cache.GetSize() * sizeof(CombinedXZInfo);
+}
+
+std::size_t DefaultTerrain::TrimCaches(std::size_t bytes) {
+	// Both caches hold the same columns
+	constexpr std::size_t kEntryBytes = sizeof(XZInfo) + sizeof(CombinedXZInfo);
+	std::size_t count = (bytes + kEntryBytes - 1) / kEntryBytes;
+	return m_xz_cache.Trim(count) * sizeof(XZInfo) + m_combined_xz_cache.Trim(count) * sizeof(CombinedXZInfo);
+}
+
 } // namespace hc::client
\ No newline at end of file
@@ -1,67 +1,114 @@
 #include <client/LocalClient.hpp>
 
 #include <client/DefaultTerrain.hpp>
+#include <common/Trace.hpp>
+
+#include <algorithm>
 
 namespace hc::client {
 
 void LocalClient::tick_thread_func() {
+	HC_TRACE_THREAD_NAME("local client tick");
 	while (m_thread_running.load(std::memory_order_acquire)) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(50));
 		m_world_ptr->NextTick();
 	}
 }
 
-void LocalClient::load_chunk_thread_func() {
-	moodycamel::ConsumerToken token{m_load_chunk_queue};
+void LocalClient::load_chunk_thread_func(std::size_t thread_index) {
+	HC_TRACE_THREAD_NAME("local client load");
+	auto &queue = *m_load_chunk_queues[thread_index];
+	moodycamel::ConsumerToken token{queue};
 
 	while (m_thread_running.load(std::memory_order_acquire)) {
 		std::vector<ChunkPos3> chunk_pos_s;
-		if (m_load_chunk_queue.wait_dequeue_timed(token, chunk_pos_s, std::chrono::milliseconds(50))) {
-			auto chunk_entries = m_world_database->GetChunks(chunk_pos_s);
+		if (queue.wait_dequeue_timed(token, chunk_pos_s, std::chrono::milliseconds(50))) {
+			// Edits of chunks unloaded meanwhile may still be pending
+			m_world_database_writer->Flush();
+			auto chunk_entries = m_world_database->GetChunks(
+			    chunk_pos_s, m_bake_chunks ? std::optional{m_terrain->GetBakedVersion()} : std::nullopt);
+			for (const auto &chunk_pos : chunk_pos_s)
+				if (auto chunk = m_world_ptr->GetChunkPool().FindRawChunk(chunk_pos))
+					chunk->GetLifecycle().Reach(ChunkStage::kLoad);
 
-			ChunkTaskPoolLocked locked_task_pool{&m_world_ptr->m_chunk_task_pool};
+			// Push one by one so that the other readers and the workers are not blocked on the whole task table
 			for (std::size_t i = 0; i < chunk_pos_s.size(); ++i)
-				locked_task_pool.Push<ChunkTaskType::kGenerate>(chunk_pos_s[i], std::move(chunk_entries[i]));
+				m_world_ptr->m_chunk_task_pool.Push<ChunkTaskType::kGenerate>(chunk_pos_s[i],
+				                                                              std::move(chunk_entries[i]));
 		}
 	}
 }
 
 std::shared_ptr<LocalClient> LocalClient::Create(const std::shared_ptr<World> &world_ptr,
-                                                 const char *database_filename) {
+                                                 const char *database_filename,
+                                                 const LocalClientConfig &config) {
 	std::shared_ptr<LocalClient> ret = std::make_shared<LocalClient>();
 	ret->m_world_ptr = world_ptr;
 	world_ptr->m_client_weak_ptr = ret->weak_from_this();
 
 	if (!(ret->m_world_database = WorldDatabase::Create(database_filename)))
 		return nullptr;
+	ret->m_world_database_writer = std::make_unique<WorldDatabaseWriter>(ret->m_world_database.get(), config.writer);
+	ret->m_bake_chunks = config.bake_chunks;
 	if (!(ret->m_terrain = DefaultTerrain::Create(12314524)))
 		return nullptr;
 
 	ret->m_tick_thread = std::thread(&LocalClient::tick_thread_func, ret.get());
-	ret->m_load_chunk_thread = std::thread(&LocalClient::load_chunk_thread_func, ret.get());
+	std::size_t load_threads = std::max(config.load_threads, (std::size_t)1);
+	for (std::size_t i = 0; i < load_threads; ++i)
+		ret->m_load_chunk_queues.push_back(
+		    std::make_unique<moodycamel::BlockingConcurrentQueue<std::vector<ChunkPos3>>>());
+	for (std::size_t i = 0; i < load_threads; ++i)
+		ret->m_load_chunk_threads.emplace_back(&LocalClient::load_chunk_thread_func, ret.get(), i);
+
+	// Chunks above the terrain are air, only kept for the sunlight and the meshes of the chunks below
+	if (auto max_height = ret->m_terrain->GetMaxHeight())
+		world_ptr->SetMaxLoadChunkY(ChunkPos1(ChunkPosFromBlockPos(*max_height) + 3));
 	return ret;
 }
 
 LocalClient::~LocalClient() {
 	m_thread_running.store(false, std::memory_order_release);
 	m_tick_thread.join();
-	m_load_chunk_thread.join();
+	for (auto &thread : m_load_chunk_threads)
+		thread.join();
 }
 
 void LocalClient::LoadChunks(std::span<const ChunkPos3> chunk_pos_s) {
-	m_load_chunk_queue.enqueue(std::vector<ChunkPos3>{chunk_pos_s.begin(), chunk_pos_s.end()});
+	if (m_load_chunk_queues.size() == 1) {
+		m_load_chunk_queues[0]->enqueue(std::vector<ChunkPos3>{chunk_pos_s.begin(), chunk_pos_s.end()});
+		return;
+	}
+	// A position always goes to the same reader, keeping its requests in order
+	std::vector<std::vector<ChunkPos3>> batches(m_load_chunk_queues.size());
+	for (const auto &chunk_pos : chunk_pos_s)
+		batches[std::hash<ChunkPos3>{}(chunk_pos) % batches.size()].push_back(chunk_pos);
+	for (std::size_t i = 0; i < batches.size(); ++i)
+		if (!batches[i].empty())
+			m_load_chunk_queues[i]->enqueue(std::move(batches[i]));
 }
 
 void LocalClient::SetChunkBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks) {
-	m_world_ptr->m_chunk_task_pool.Push<ChunkTaskType::kSetBlock>(
-	    chunk_pos, PackedChunkBlockEntry::Unpack(m_world_database->SetBlocks(chunk_pos, blocks)),
-	    ChunkUpdateType::kRemote);
+	m_world_database_writer->SetBlocks(
+	    chunk_pos, blocks, [world_ptr = m_world_ptr, chunk_pos](std::vector<PackedChunkBlockEntry> &&entries) {
+		    world_ptr->m_chunk_task_pool.Push<ChunkTaskType::kSetBlock>(
+		        chunk_pos, PackedChunkBlockEntry::Unpack(entries), ChunkUpdateType::kRemote);
+		    // Missed if the chunk is unloaded, so it is read from the database again
+		    world_ptr->m_chunk_pool.GetHibernationCache().Erase(chunk_pos);
+	    });
 }
 
 void LocalClient::SetChunkSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights) {
-	m_world_ptr->m_chunk_task_pool.Push<ChunkTaskType::kSetSunlight>(
-	    chunk_pos, PackedChunkSunlightEntry::Unpack(m_world_database->SetSunlights(chunk_pos, sunlights)),
-	    ChunkUpdateType::kRemote);
+	m_world_database_writer->SetSunlights(
+	    chunk_pos, sunlights, [world_ptr = m_world_ptr, chunk_pos](std::vector<PackedChunkSunlightEntry> &&entries) {
+		    world_ptr->m_chunk_task_pool.Push<ChunkTaskType::kSetSunlight>(
+		        chunk_pos, PackedChunkSunlightEntry::Unpack(entries), ChunkUpdateType::kRemote);
+		    world_ptr->m_chunk_pool.GetHibernationCache().Erase(chunk_pos);
+	    });
+}
+
+void LocalClient::SetBakedChunk(ChunkPos3 chunk_pos, std::vector<uint8_t> &&baked) {
+	m_world_database_writer->SetBakedChunk(chunk_pos, m_terrain->GetBakedVersion(), std::move(baked));
 }
 
 } // namespace hc::client
\ No newline at end of file
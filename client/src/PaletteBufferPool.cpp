@@ -0,0 +1,69 @@
+#include <client/PaletteBufferPool.hpp>
+
+#include <algorithm>
+#include <new>
+
+namespace hc::client {
+
+PaletteBufferPool::~PaletteBufferPool() { Release(); }
+
+PaletteBufferPool::FreeList &PaletteBufferPool::get_free_list(std::size_t size) {
+	auto it = std::find_if(m_free_lists.begin(), m_free_lists.end(),
+	                       [size](const FreeList &free_list) { return free_list.size == size; });
+	if (it != m_free_lists.end())
+		return *it;
+	return m_free_lists.emplace_back(FreeList{.size = size});
+}
+
+void *PaletteBufferPool::Allocate(std::size_t size) {
+	{
+		std::scoped_lock lock{m_mutex};
+		FreeList &free_list = get_free_list(size);
+		if (!free_list.buffers.empty()) {
+			++m_hits;
+			--m_buffers;
+			m_bytes -= size;
+			void *buffer = free_list.buffers.back();
+			free_list.buffers.pop_back();
+			return buffer;
+		}
+		++m_misses;
+	}
+	return ::operator new(size);
+}
+
+void PaletteBufferPool::Deallocate(void *buffer, std::size_t size) {
+	{
+		std::scoped_lock lock{m_mutex};
+		if (m_bytes + size <= m_capacity) {
+			++m_buffers;
+			m_bytes += size;
+			get_free_list(size).buffers.push_back(buffer);
+			return;
+		}
+	}
+	::operator delete(buffer);
+}
+
+PaletteBufferPool::Stats PaletteBufferPool::GetStats() {
+	std::scoped_lock lock{m_mutex};
+	return {.hits = m_hits, .misses = m_misses, .buffers = m_buffers, .bytes = m_bytes};
+}
+
+std::size_t PaletteBufferPool::Release() {
+	std::vector<FreeList> free_lists;
+	std::size_t released;
+	{
+		std::scoped_lock lock{m_mutex};
+		free_lists = std::move(m_free_lists);
+		m_free_lists.clear();
+		released = m_bytes;
+		m_bytes = m_buffers = 0;
+	}
+	for (const auto &free_list : free_lists)
+		for (void *buffer : free_list.buffers)
+			::operator delete(buffer);
+	return released;
+}
+
+} // namespace hc::client
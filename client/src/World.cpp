@@ -1,14 +1,111 @@
 #include <client/World.hpp>
 
-#include <client/WorldRenderer.hpp>
+#include <client/ClientBase.hpp>
+
+#include <cmath>
 
 namespace hc::client {
 
 void World::update() {
 	m_chunk_pool.Update();
-	auto renderer = m_world_renderer_weak_ptr.lock();
-	if (renderer)
-		renderer->EraseUnloadedMeshes();
+	auto mesh_sink = m_mesh_sink_weak_ptr.lock();
+	if (mesh_sink)
+		mesh_sink->EraseUnloadedMeshes();
+}
+
+World::MemoryStats World::GetMemoryStats() const {
+	MemoryStats stats{.chunks = m_chunk_pool.GetMemoryBytes(),
+	                  .chunk_tasks = m_chunk_task_pool.GetMemoryBytes(),
+	                  .hibernated_chunks = m_chunk_pool.GetHibernationCache().GetStats().bytes};
+	if (auto client = LockClient(); client && client->GetTerrain())
+		stats.terrain_caches = client->GetTerrain()->GetCacheBytes();
+	if (auto mesh_sink = LockMeshSink())
+		stats.meshes = mesh_sink->GetMeshBytes();
+	return stats;
+}
+
+void World::enforce_memory_budget() {
+	std::size_t budget = GetMemoryBudget();
+	ChunkPos1 shrink = GetBudgetShrink();
+	if (budget == 0) {
+		if (shrink) {
+			m_budget_shrink.store(0, std::memory_order_release);
+			update();
+		}
+		return;
+	}
+
+	// The slabs and palette buffers stay allocated otherwise, and count in the chunk bytes
+	m_chunk_pool.GetSlabPool()->ReleaseEmptySlabs();
+	m_chunk_pool.GetSlabPool()->ReleasePaletteBuffers();
+	std::size_t total = GetMemoryStats().GetTotal();
+	ChunkLoadShape load_shape = get_requested_load_shape();
+	// Shrunk until both radii reach the floor, so that a wide and low shape still shrinks horizontally
+	ChunkPos1 max_shrink = ChunkPos1(
+	    std::max(std::max(load_shape.radius, load_shape.height) - (int32_t)kMemoryBudgetMinLoadRadius, 0));
+	if (shrink > max_shrink) { // the requested shape got smaller
+		m_budget_shrink.store(max_shrink, std::memory_order_release);
+		update();
+	} else if (total > budget) {
+		// Terrain caches and hibernated chunks are cheaper to rebuild than loaded chunks
+		if (auto client = LockClient(); client && client->GetTerrain())
+			total -= std::min(client->GetTerrain()->TrimCaches(total - budget), total);
+		if (total > budget)
+			total -= std::min(m_chunk_pool.GetHibernationCache().Trim(total - budget), total);
+		if (total <= budget || shrink >= max_shrink)
+			return;
+		// Unloaded chunks are released by their tasks lazily, so the next check waits for them
+		m_budget_shrink.store(ChunkPos1(shrink + 1), std::memory_order_release);
+		update();
+	} else if (shrink) {
+		// Grow back if a chunk thicker shape would likely stay within the budget
+		const auto get_volume = [](const ChunkLoadShape &shape) {
+			return float(shape.radius) * float(shape.radius) * float(shape.height);
+		};
+		float growth = get_volume(load_shape.Shrink(ChunkPos1(shrink - 1), kMemoryBudgetMinLoadRadius)) /
+		               get_volume(load_shape.Shrink(shrink, kMemoryBudgetMinLoadRadius));
+		if (float(total) * growth >= float(budget))
+			return;
+		m_budget_shrink.store(ChunkPos1(shrink - 1), std::memory_order_release);
+		update();
+	}
+}
+
+bool World::SetCenterView(const glm::vec3 &direction, float fov, float aspect_ratio, const glm::vec3 &velocity) {
+	ChunkTaskView view{};
+	if (glm::vec3 dir = glm::round(direction * 8.0f) / 8.0f; dir != glm::vec3{0.0f})
+		view.direction = glm::normalize(dir);
+	view.velocity = glm::round(velocity / float(kChunkSize) * 2.0f) / 2.0f;
+	float half_angle = std::atan(std::tan(fov * 0.5f) * std::sqrt(1.0f + aspect_ratio * aspect_ratio));
+	half_angle = std::round(half_angle * 32.0f) / 32.0f;
+	view.half_angle_cos = std::cos(half_angle);
+	view.half_angle_sin = std::sin(half_angle);
+
+	std::scoped_lock lock{m_center_view_mutex};
+	if (view == m_center_view)
+		return false;
+	m_center_view = view;
+	return true;
+}
+
+bool World::IsViewMeshed(ChunkPos1 radius) const {
+	ChunkPos3 center = GetCenterChunkPos();
+	ChunkTaskView view = GetCenterView();
+	// Chunks near the top of the loaded area and near the border of the load shape miss neighbours as well
+	ChunkLoadShape inner_shape = GetLoadShape().Grow(-4);
+	ChunkPos1 max_y = ChunkPos1(std::min<int32_t>(radius, GetMaxLoadChunkY() - 4 - center.y));
+	for (ChunkPos1 y = -radius; y <= max_y; ++y)
+		for (ChunkPos1 z = -radius; z <= radius; ++z)
+			for (ChunkPos1 x = -radius; x <= radius; ++x) {
+				ChunkPos3 rel_pos{x, y, z};
+				if (ChunkPosLength2(rel_pos) > uint32_t(radius * radius) || !inner_shape.Contains(rel_pos) ||
+				    !view.IsVisible(rel_pos))
+					continue;
+				auto chunk = m_chunk_pool.FindRawChunk(center + rel_pos);
+				if (!chunk || !chunk->IsMeshed())
+					return false;
+			}
+	return true;
 }
 
 } // namespace hc::client
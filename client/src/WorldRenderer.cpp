@@ -11,11 +11,12 @@ void WorldRenderer::thread_func() {
 			if (post_updates.empty()) {
 				// purge unloaded chunk meshes
 				auto center_pos = m_world_ptr->GetCenterChunkPos();
-				auto unload_radius = m_world_ptr->GetUnloadChunkRadius();
+				auto unload_shape = m_world_ptr->GetUnloadShape();
+				auto max_y = m_world_ptr->GetMaxLoadChunkY();
 
 				auto locked_meshes = m_chunk_mesh_map.lock_table();
 				for (auto it = locked_meshes.begin(); it != locked_meshes.end();) {
-					if (ChunkPosDistance2(center_pos, it->first) > uint32_t(unload_radius * unload_radius))
+					if (it->first.y > max_y || !unload_shape.Contains(it->first - center_pos))
 						it = locked_meshes.erase(it);
 					else
 						++it;
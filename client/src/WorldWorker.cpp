@@ -1,9 +1,12 @@
 #include <client/WorldWorker.hpp>
 
+#include <common/Trace.hpp>
+
 namespace hc::client {
 
 void WorldWorker::Join() {
 	m_running.store(false, std::memory_order_release);
+	m_world_ptr->m_chunk_task_pool.Wake(true);
 	for (auto &i : m_worker_threads)
 		i.join();
 }
@@ -16,14 +19,31 @@ void WorldWorker::launch_worker_threads(std::size_t concurrency) {
 }
 
 void WorldWorker::worker_thread_func() {
+	HC_TRACE_THREAD_NAME("chunk worker");
 	ChunkTaskPoolProducerConfig producer_config{};
 	producer_config.max_high_priority_tasks = 64;
 	producer_config.max_tick_tasks = 16;
 	producer_config.max_tasks = 256;
 
-	ChunkTaskPoolToken token{&m_world_ptr->m_chunk_task_pool, producer_config};
-	while (m_running.load(std::memory_order_acquire))
-		m_world_ptr->m_chunk_task_pool.Run(&token);
+	auto &task_pool = m_world_ptr->m_chunk_task_pool;
+	ChunkTaskPoolToken token{&task_pool, producer_config};
+	// Idle workers encode the unloaded chunks, then wait for the wake epoch to change: spin, then yield, then park
+	while (m_running.load(std::memory_order_acquire)) {
+		uint64_t wake_epoch = task_pool.GetWakeEpoch();
+		if (task_pool.Run(&token) || m_world_ptr->EncodeHibernatingChunks(1))
+			continue;
+		uint32_t idle_rounds = 0;
+		while (task_pool.GetWakeEpoch() == wake_epoch && m_running.load(std::memory_order_acquire)) {
+			if (++idle_rounds <= kSpinRounds)
+				continue;
+			if (idle_rounds <= kSpinRounds + kYieldRounds)
+				std::this_thread::yield();
+			else {
+				task_pool.Park(wake_epoch, kParkTimeout);
+				break;
+			}
+		}
+	}
 }
 
 } // namespace hc::client
\ No newline at end of file
@@ -0,0 +1,330 @@
+// Runs the world simulation without a window or a GPU. The center moves along a scripted path while the meshes go to a
+// NullChunkMeshSink, then generation and meshing throughput and the latency from a center change to its view being
+// meshed, and the chunk lifecycle stage durations are reported. The run fails if the view at the end of the path is not
+// meshed before the drain timeout.
+
+#include <client/LocalClient.hpp>
+#include <client/NullChunkMeshSink.hpp>
+#include <client/World.hpp>
+#include <client/WorldWorker.hpp>
+#include <common/Trace.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace hc;
+using namespace hc::client;
+
+struct Options {
+	ChunkPos1 load_radius = 8, load_height = 0; // load_height defaults to load_radius
+	std::size_t concurrency = std::max(std::thread::hardware_concurrency(), 1u);
+	std::size_t load_threads = LocalClientConfig{}.load_threads;
+	std::size_t memory_budget = 0; // in MiB, 0 for no budget
+	std::size_t hibernation = kChunkHibernationCapacity / (1024 * 1024); // in MiB, 0 to disable
+	std::string path = "line";            // line, square or circle
+	std::string chunk_storage = "hash";   // hash or ring
+	std::string load_shape = "ellipsoid"; // ellipsoid or cylinder
+	float length = 512.0f;                // in blocks
+	float speed = 16.0f;                  // in blocks per second
+	float height = 32.0f;
+	bool view = true, bake = false;
+	std::string database, stats_csv, stats_json, lifecycle_csv, lifecycle_json, trace;
+};
+
+static void print_usage() {
+	printf("usage: HyperCraft_client_headless [--radius R] [--workers N] [--path line|square|circle] [--length BLOCKS]\n"
+	       "                                  [--speed BLOCKS_PER_SEC] [--height Y] [--no-view] [--database PATH]\n"
+	       "                                  [--stats-csv FILE] [--stats-json FILE] [--lifecycle-csv FILE]\n"
+	       "                                  [--lifecycle-json FILE] [--trace FILE] [--bake] [--load-threads N]\n"
+	       "                                  [--chunk-storage hash|ring] [--load-height H]\n"
+	       "                                  [--load-shape ellipsoid|cylinder] [--memory-budget MIB]\n"
+	       "                                  [--hibernation MIB]\n");
+}
+
+static bool parse_options(int argc, char **argv, Options *p_options) {
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		if (!strcmp(arg, "--no-view")) {
+			p_options->view = false;
+			continue;
+		}
+		if (!strcmp(arg, "--bake")) {
+			p_options->bake = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false;
+		const char *value = argv[++i];
+		if (!strcmp(arg, "--radius"))
+			p_options->load_radius = (ChunkPos1)std::clamp(atoi(value), 4, (int)kWorldMaxLoadRadius);
+		else if (!strcmp(arg, "--load-height"))
+			p_options->load_height = (ChunkPos1)std::clamp(atoi(value), 4, (int)kWorldMaxLoadRadius);
+		else if (!strcmp(arg, "--workers"))
+			p_options->concurrency = std::max(atoi(value), 1);
+		else if (!strcmp(arg, "--memory-budget"))
+			p_options->memory_budget = std::max(atoi(value), 0);
+		else if (!strcmp(arg, "--hibernation"))
+			p_options->hibernation = std::max(atoi(value), 0);
+		else if (!strcmp(arg, "--load-threads"))
+			p_options->load_threads = std::max(atoi(value), 1);
+		else if (!strcmp(arg, "--path"))
+			p_options->path = value;
+		else if (!strcmp(arg, "--chunk-storage"))
+			p_options->chunk_storage = value;
+		else if (!strcmp(arg, "--load-shape"))
+			p_options->load_shape = value;
+		else if (!strcmp(arg, "--length"))
+			p_options->length = (float)atof(value);
+		else if (!strcmp(arg, "--speed"))
+			p_options->speed = std::max((float)atof(value), 0.1f);
+		else if (!strcmp(arg, "--height"))
+			p_options->height = (float)atof(value);
+		else if (!strcmp(arg, "--database"))
+			p_options->database = value;
+		else if (!strcmp(arg, "--stats-csv"))
+			p_options->stats_csv = value;
+		else if (!strcmp(arg, "--stats-json"))
+			p_options->stats_json = value;
+		else if (!strcmp(arg, "--lifecycle-csv"))
+			p_options->lifecycle_csv = value;
+		else if (!strcmp(arg, "--lifecycle-json"))
+			p_options->lifecycle_json = value;
+		else if (!strcmp(arg, "--trace"))
+			p_options->trace = value;
+		else
+			return false;
+	}
+	return (p_options->path == "line" || p_options->path == "square" || p_options->path == "circle") &&
+	       (p_options->chunk_storage == "hash" || p_options->chunk_storage == "ring") &&
+	       (p_options->load_shape == "ellipsoid" || p_options->load_shape == "cylinder");
+}
+
+static std::vector<glm::vec3> make_waypoints(const Options &options) {
+	std::vector<glm::vec3> waypoints;
+	if (options.path == "line") {
+		waypoints = {{0.0f, options.height, 0.0f}, {options.length, options.height, 0.0f}};
+	} else if (options.path == "square") {
+		float side = options.length / 4.0f;
+		waypoints = {{0.0f, options.height, 0.0f},
+		             {side, options.height, 0.0f},
+		             {side, options.height, side},
+		             {0.0f, options.height, side},
+		             {0.0f, options.height, 0.0f}};
+	} else {
+		constexpr uint32_t kSegments = 32;
+		float radius = options.length / (2.0f * glm::pi<float>());
+		for (uint32_t i = 0; i <= kSegments; ++i) {
+			float angle = 2.0f * glm::pi<float>() * float(i) / float(kSegments);
+			waypoints.emplace_back(radius * std::cos(angle), options.height, radius * std::sin(angle));
+		}
+	}
+	return waypoints;
+}
+
+// A center chunk change waiting for the chunks in its view to be meshed. Chunks near the load radius of an old center
+// may never be meshed, so a probe is superseded by the next center change.
+struct LatencyProbe {
+	std::chrono::steady_clock::time_point time;
+	ChunkPos3 center;
+	ChunkTaskView view;
+};
+
+static bool is_probe_meshed(const World &world, const LatencyProbe &probe, ChunkPos1 radius) {
+	ChunkLoadShape inner_shape = world.GetLoadShape().Grow(-4);
+	ChunkPos1 max_y = ChunkPos1(std::min<int32_t>(radius, world.GetMaxLoadChunkY() - 4 - probe.center.y));
+	for (ChunkPos1 y = -radius; y <= max_y; ++y)
+		for (ChunkPos1 z = -radius; z <= radius; ++z)
+			for (ChunkPos1 x = -radius; x <= radius; ++x) {
+				ChunkPos3 rel_pos{x, y, z};
+				if (ChunkPosLength2(rel_pos) > uint32_t(radius * radius) || !inner_shape.Contains(rel_pos) ||
+				    !probe.view.IsVisible(rel_pos))
+					continue;
+				auto chunk = world.GetChunkPool().FindRawChunk(probe.center + rel_pos);
+				if (!chunk || !chunk->IsMeshed())
+					return false;
+			}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%t] [%l] %v");
+	Options options{};
+	if (!parse_options(argc, argv, &options)) {
+		print_usage();
+		return EXIT_FAILURE;
+	}
+#ifndef HYPERCRAFT_TRACE
+	if (!options.trace.empty())
+		spdlog::warn("--trace is ignored, configure with -DHYPERCRAFT_TRACE=ON to record trace zones");
+#endif
+	HC_TRACE_THREAD_NAME("main");
+
+	bool temp_database = options.database.empty();
+	std::filesystem::path db_path = temp_database
+	                                    ? std::filesystem::temp_directory_path() / "hypercraft_client_headless"
+	                                    : std::filesystem::path{options.database};
+	if (temp_database)
+		std::filesystem::remove_all(db_path);
+	std::filesystem::create_directories(db_path);
+
+	// Meshes only reach a few chunks inside the load radius, see World::IsViewMeshed()
+	const ChunkPos1 unload_radius = options.load_radius + 2, mesh_radius = options.load_radius - 4;
+	auto chunk_storage = options.chunk_storage == "ring" ? ChunkPoolStorage::kRingMap : ChunkPoolStorage::kHashMap;
+	ChunkLoadShape load_shape{.type = options.load_shape == "cylinder" ? ChunkLoadShape::Type::kCylinder
+	                                                                   : ChunkLoadShape::Type::kEllipsoid,
+	                          .radius = options.load_radius,
+	                          .height = options.load_height ? options.load_height : options.load_radius};
+	auto world = World::Create(load_shape, unload_radius, chunk_storage);
+	auto mesh_sink = NullChunkMeshSink::Create(world);
+	auto client = LocalClient::Create(world, (db_path / "world").string().c_str(),
+	                                  {.bake_chunks = options.bake, .load_threads = options.load_threads});
+	auto worker = WorldWorker::Create(world);
+	world->SetMemoryBudget(options.memory_budget * 1024 * 1024);
+	world->SetChunkHibernationCapacity(options.hibernation * 1024 * 1024);
+
+	std::vector<glm::vec3> waypoints = make_waypoints(options);
+	glm::vec3 position = waypoints.front();
+	world->SetCenterPos(position);
+
+	spdlog::info("Headless run: {} radius {} height {}, {} workers, {} path of {} blocks at {} blocks/s, view {}",
+	             options.load_shape, load_shape.radius, load_shape.height, options.concurrency, options.path,
+	             options.length, options.speed, options.view ? "on" : "off");
+
+	worker->Launch(options.concurrency);
+	auto begin_time = std::chrono::steady_clock::now();
+	world->Start();
+
+	constexpr auto kTickDuration = std::chrono::milliseconds(16);
+	constexpr auto kDrainTimeout = std::chrono::seconds(30);
+	std::optional<LatencyProbe> probe = LatencyProbe{begin_time, world->GetCenterChunkPos(), world->GetCenterView()};
+	std::vector<double> latencies;
+	std::size_t probe_count = 1;
+
+	World::MemoryStats peak_memory_stats{};
+	ChunkPos1 max_budget_shrink = 0;
+
+	std::size_t waypoint = 1;
+	auto prev_time = begin_time, path_end_time = begin_time;
+	bool path_ended = false;
+	while (true) {
+		std::this_thread::sleep_for(kTickDuration);
+		auto cur_time = std::chrono::steady_clock::now();
+		float delta = std::chrono::duration<float>(cur_time - prev_time).count();
+		prev_time = cur_time;
+
+		// Move along the path
+		glm::vec3 velocity{0.0f};
+		if (waypoint < waypoints.size()) {
+			float step = options.speed * delta;
+			while (waypoint < waypoints.size() && step > 0.0f) {
+				glm::vec3 to_waypoint = waypoints[waypoint] - position;
+				float distance = glm::length(to_waypoint);
+				if (distance <= step) {
+					position = waypoints[waypoint++];
+					step -= distance;
+				} else {
+					velocity = to_waypoint / distance * options.speed;
+					position += to_waypoint / distance * step;
+					step = 0.0f;
+				}
+			}
+			if (waypoint == waypoints.size()) {
+				path_ended = true;
+				path_end_time = cur_time;
+			}
+		}
+		if (options.view) {
+			glm::vec3 direction = velocity == glm::vec3{0.0f} ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::normalize(velocity);
+			world->SetCenterView(direction, glm::pi<float>() / 3.0f, 16.0f / 9.0f, velocity);
+		}
+		ChunkPos3 prev_center = world->GetCenterChunkPos();
+		world->SetCenterPos(position);
+		if (world->GetCenterChunkPos() != prev_center) {
+			probe = LatencyProbe{cur_time, world->GetCenterChunkPos(), world->GetCenterView()};
+			++probe_count;
+		}
+		if (probe && is_probe_meshed(*world, *probe, mesh_radius)) {
+			latencies.push_back(std::chrono::duration<double, std::milli>(cur_time - probe->time).count());
+			probe = std::nullopt;
+		}
+
+		if (auto memory_stats = world->GetMemoryStats(); memory_stats.GetTotal() > peak_memory_stats.GetTotal())
+			peak_memory_stats = memory_stats;
+		max_budget_shrink = std::max(max_budget_shrink, world->GetBudgetShrink());
+
+		if (path_ended && (!probe || cur_time - path_end_time > kDrainTimeout))
+			break;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+
+	worker->Join();
+	ChunkTaskStats task_stats = world->GetChunkTaskPool().GetTaskStats();
+	NullChunkMeshSink::Stats mesh_stats = mesh_sink->GetStats();
+	ChunkLifecycleStats lifecycle_stats = world->GetChunkLifecycleStats();
+
+	printf("time: %.2f s\n", seconds);
+	printf("generated: %llu chunks (%.1f/s)\n", (unsigned long long)task_stats.Get(ChunkTaskType::kGenerate).completed,
+	       double(task_stats.Get(ChunkTaskType::kGenerate).completed) / seconds);
+	printf("meshed: %zu chunks (%.1f/s), %zu meshes, %zu vertices, %zu indices, %.1f MiB\n", mesh_stats.chunks,
+	       double(mesh_stats.chunks) / seconds, mesh_stats.meshes, mesh_stats.vertices, mesh_stats.indices,
+	       double(mesh_stats.bytes) / (1024.0 * 1024.0));
+	constexpr double kMiB = 1024.0 * 1024.0;
+	World::MemoryStats memory_stats = world->GetMemoryStats();
+	for (const auto &[name, stats] : {std::pair{"peak", peak_memory_stats}, std::pair{"final", memory_stats}})
+		printf("%s memory: %.1f MiB, chunks %.1f MiB, chunk tasks %.1f MiB, terrain caches %.1f MiB, "
+		       "hibernated chunks %.1f MiB, meshes %.1f MiB\n",
+		       name, double(stats.GetTotal()) / kMiB, double(stats.chunks) / kMiB, double(stats.chunk_tasks) / kMiB,
+		       double(stats.terrain_caches) / kMiB, double(stats.hibernated_chunks) / kMiB,
+		       double(stats.meshes) / kMiB);
+	if (options.memory_budget)
+		printf("memory budget: %zu MiB, load shape shrunk by up to %d chunks\n", options.memory_budget,
+		       max_budget_shrink);
+	ChunkHibernationCache::Stats hibernation_stats = world->GetChunkHibernationStats();
+	if (std::size_t loads = hibernation_stats.hits + hibernation_stats.misses)
+		printf("hibernation: %zu of %zu loads restored (%.1f%%), %zu chunks kept, %.1f MiB\n", hibernation_stats.hits,
+		       loads, 100.0 * double(hibernation_stats.hits) / double(loads), hibernation_stats.chunks,
+		       double(hibernation_stats.bytes) / kMiB);
+	for (const auto &[name, histogram] :
+	     {std::pair{"restored", &lifecycle_stats.restored}, std::pair{"not restored", &lifecycle_stats.cold}})
+		if (histogram->GetCount())
+			printf("insert to visible, %s: %llu chunks, mean %.1f ms, p50 %.1f ms, p90 %.1f ms\n", name,
+			       (unsigned long long)histogram->GetCount(), histogram->GetMeanUs() / 1000.0,
+			       double(histogram->GetQuantileUs(0.5)) / 1000.0, double(histogram->GetQuantileUs(0.9)) / 1000.0);
+	printf("center changes with view meshed: %zu of %zu\n", latencies.size(), probe_count);
+	if (probe)
+		spdlog::error("View at the end of the path not meshed after {} s", kDrainTimeout.count());
+	if (!latencies.empty()) {
+		std::sort(latencies.begin(), latencies.end());
+		printf("center change to view meshed: median %.1f ms, p90 %.1f ms, max %.1f ms\n",
+		       latencies[latencies.size() / 2], latencies[latencies.size() * 9 / 10], latencies.back());
+	}
+	printf("%s", task_stats.ToCSV().c_str());
+	if (!options.stats_csv.empty())
+		std::ofstream{options.stats_csv} << task_stats.ToCSV();
+	if (!options.stats_json.empty())
+		std::ofstream{options.stats_json} << task_stats.ToJSON();
+	printf("%s", lifecycle_stats.ToCSV().c_str());
+	if (!options.lifecycle_csv.empty())
+		std::ofstream{options.lifecycle_csv} << lifecycle_stats.ToCSV();
+	if (!options.lifecycle_json.empty())
+		std::ofstream{options.lifecycle_json} << lifecycle_stats.ToJSON();
+#ifdef HYPERCRAFT_TRACE
+	if (!options.trace.empty())
+		std::ofstream{options.trace} << Trace::ToChromeJSON();
+#endif
+
+	client.reset();
+	world.reset();
+	if (temp_database)
+		std::filesystem::remove_all(db_path);
+	return probe ? EXIT_FAILURE : EXIT_SUCCESS;
+}
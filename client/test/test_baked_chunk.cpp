@@ -0,0 +1,112 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <client/BakedChunk.hpp>
+#include <client/Chunk.hpp>
+#include <common/Varint.hpp>
+
+using namespace hc;
+using namespace hc::client;
+using namespace hc::block;
+
+namespace {
+
+constexpr uint32_t kBlockCount = Chunk::kSize * Chunk::kSize * Chunk::kSize,
+                   kSunlightCount = Chunk::kSize * Chunk::kSize;
+
+bool same_chunks(const Chunk &l, const Chunk &r) {
+	for (uint32_t i = 0; i < kBlockCount; ++i)
+		if (l.GetBlock(i) != r.GetBlock(i))
+			return false;
+	for (uint32_t i = 0; i < kSunlightCount; ++i)
+		if (l.GetSunlightHeight(i) != r.GetSunlightHeight(i))
+			return false;
+	return true;
+}
+
+std::shared_ptr<Chunk> check_round_trip(const Chunk &chunk, std::vector<uint8_t> *p_record = nullptr) {
+	std::vector<uint8_t> record = EncodeBakedChunk(chunk);
+	auto decoded = Chunk::Create(chunk.GetPosition());
+	REQUIRE(DecodeBakedChunk(record, decoded.get()));
+	CHECK(same_chunks(chunk, *decoded));
+	if (chunk.IsUniform())
+		CHECK(decoded->IsUniform());
+	if (p_record)
+		*p_record = std::move(record);
+	return decoded;
+}
+
+} // namespace
+
+TEST_CASE("Uniform chunks") {
+	auto chunk = Chunk::Create({0, 0, 0});
+	chunk->FillBlocks(Blocks::kStone);
+	REQUIRE(chunk->IsUniform());
+	std::vector<uint8_t> record;
+	check_round_trip(*chunk, &record);
+	// format, palette, run of all blocks, run of all sunlights
+	CHECK(record.size() <= 16);
+
+	for (uint32_t i = 0; i < kSunlightCount; ++i)
+		chunk->SetSunlightHeight(i, InnerPos1(i % 7));
+	check_round_trip(*chunk);
+}
+
+TEST_CASE("Single run chunks") {
+	// Widened by a block changed back, so that the single run goes through the palette path
+	auto chunk = Chunk::Create({1, 2, 3});
+	chunk->FillBlocks(Blocks::kSand);
+	chunk->SetBlock(100, Blocks::kStone);
+	chunk->SetBlock(100, Blocks::kSand);
+	REQUIRE_FALSE(chunk->IsUniform());
+	// decoded as uniform
+	CHECK(check_round_trip(*chunk)->IsUniform());
+
+	// A single run of another block in the middle
+	for (uint32_t i = 1000; i < 5000; ++i)
+		chunk->SetBlock(i, Blocks::kGravel);
+	chunk->CompactBlocks();
+	CHECK_FALSE(check_round_trip(*chunk)->IsUniform());
+}
+
+TEST_CASE("Chunks with the largest palette") {
+	auto chunk = Chunk::Create({-1, 0, 1});
+	for (uint32_t i = 0; i < kBlockCount; ++i) {
+		Block block;
+		block.SetData(uint16_t(i * 2 + 1));
+		chunk->SetBlock(i, block);
+	}
+	for (uint32_t i = 0; i < kSunlightCount; ++i)
+		chunk->SetSunlightHeight(i, InnerPos1(i % (Chunk::kSize + 1)));
+	check_round_trip(*chunk);
+}
+
+TEST_CASE("Malformed records leave the chunk untouched") {
+	auto chunk = Chunk::Create({0, 0, 0});
+	for (uint32_t i = 0; i < kBlockCount; i += 3)
+		chunk->SetBlock(i, Blocks::kStone);
+	std::vector<uint8_t> record = EncodeBakedChunk(*chunk);
+
+	auto target = Chunk::Create({0, 0, 0});
+	target->FillBlocks(Blocks::kGravel);
+	for (std::size_t size = 0; size < record.size(); ++size) {
+		CAPTURE(size);
+		CHECK_FALSE(DecodeBakedChunk({record.data(), size}, target.get()));
+	}
+	std::vector<uint8_t> wrong_format = record;
+	wrong_format[0] = 0;
+	CHECK_FALSE(DecodeBakedChunk(wrong_format, target.get()));
+	// Runs pointing past a single block palette, then runs longer than the chunk
+	std::vector<uint8_t> bad_palette{record[0]};
+	const uint32_t stone_data = Block{Blocks::kStone}.GetData();
+	for (uint32_t value : {1u, stone_data, 1u, kBlockCount - 1, 0u, kSunlightCount - 1})
+		PutVarint(&bad_palette, value);
+	CHECK_FALSE(DecodeBakedChunk(bad_palette, target.get()));
+	std::vector<uint8_t> long_run{record[0]};
+	for (uint32_t value : {1u, stone_data, 0u, kBlockCount, 0u, kSunlightCount - 1})
+		PutVarint(&long_run, value);
+	CHECK_FALSE(DecodeBakedChunk(long_run, target.get()));
+
+	CHECK(target->IsUniform());
+	CHECK(target->GetBlock(0) == Blocks::kGravel);
+}
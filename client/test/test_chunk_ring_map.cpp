@@ -0,0 +1,119 @@
+#include "doctest.h"
+
+#include <client/ChunkRingMap.hpp>
+#include <client/World.hpp>
+
+#include <map>
+
+using namespace hc;
+using namespace hc::client;
+
+TEST_CASE("Ring map extents are rounded up to powers of two") {
+	ChunkRingMap<int> ring{5, 3};
+	CHECK(ring.GetExtentXZ() == 8);
+	CHECK(ring.GetExtentY() == 4);
+	CHECK(ring.Holds(8, 4));
+	CHECK_FALSE(ring.Holds(9, 4));
+	CHECK_FALSE(ring.Holds(8, 5));
+}
+
+TEST_CASE("Ring map positions sharing a slot are told apart by their tags") {
+	ChunkRingMap<int> ring{8, 8};
+	REQUIRE(ring.Insert({0, 0, 0}, 1));
+	// (8, 0, 0), (-8, 0, 0) and (0, 0, -8) all map to the slot of (0, 0, 0)
+	CHECK_FALSE(ring.Insert({8, 0, 0}, 2));
+	CHECK_FALSE(ring.Contains({8, 0, 0}));
+	CHECK_FALSE(ring.Contains({-8, 0, 0}));
+	CHECK_FALSE(ring.FindFn({0, 0, -8}, [](int) {}));
+	CHECK_FALSE(ring.Erase({-8, 0, 0}));
+	int value = 0;
+	CHECK(ring.FindFn({0, 0, 0}, [&value](int v) { value = v; }));
+	CHECK(value == 1);
+
+	CHECK(ring.Erase({0, 0, 0}));
+	CHECK_FALSE(ring.Contains({0, 0, 0}));
+	CHECK(ring.Insert({-8, 0, 0}, 3));
+	CHECK(ring.FindFn({-8, 0, 0}, [&value](int v) { value = v; }));
+	CHECK(value == 3);
+}
+
+TEST_CASE("Ring map wraps around as a box moves across negative positions") {
+	constexpr int32_t kExtentXZ = 5, kExtentY = 3;
+	ChunkRingMap<int> ring{kExtentXZ, kExtentY};
+	const auto box_contains = [](const ChunkPos3 &center, const ChunkPos3 &pos) {
+		return std::abs(pos.x - center.x) <= kExtentXZ / 2 && std::abs(pos.y - center.y) <= kExtentY / 2 &&
+		       std::abs(pos.z - center.z) <= kExtentXZ / 2;
+	};
+	const auto for_each_box_pos = [](const ChunkPos3 &center, auto &&func) {
+		for (int32_t y = -kExtentY / 2; y <= kExtentY / 2; ++y)
+			for (int32_t z = -kExtentXZ / 2; z <= kExtentXZ / 2; ++z)
+				for (int32_t x = -kExtentXZ / 2; x <= kExtentXZ / 2; ++x)
+					func(center + ChunkPos3(x, y, z));
+	};
+	const auto value_of = [](const ChunkPos3 &pos) { return pos.x * 10000 + pos.y * 100 + pos.z; };
+
+	ChunkPos3 center{-20, -7, 13};
+	for_each_box_pos(center, [&](const ChunkPos3 &pos) { REQUIRE(ring.Insert(pos, value_of(pos))); });
+	for (int32_t step = 0; step < 40; ++step) {
+		ChunkPos3 next = center + ChunkPos3(1, step % 3 == 0 ? 1 : 0, -1);
+		for_each_box_pos(center, [&](const ChunkPos3 &pos) {
+			if (!box_contains(next, pos))
+				REQUIRE(ring.Erase(pos));
+		});
+		for_each_box_pos(next, [&](const ChunkPos3 &pos) {
+			if (!box_contains(center, pos))
+				REQUIRE(ring.Insert(pos, value_of(pos)));
+		});
+		center = next;
+
+		std::size_t count = 0;
+		ring.ForEachFn([&](const ChunkPos3 &pos, int value) {
+			++count;
+			CHECK(box_contains(center, pos));
+			CHECK(value == value_of(pos));
+		});
+		CHECK(count == kExtentXZ * kExtentXZ * kExtentY);
+		for_each_box_pos(center, [&](const ChunkPos3 &pos) {
+			int value = -1;
+			CHECK(ring.FindFn(pos, [&value](int v) { value = v; }));
+			CHECK(value == value_of(pos));
+		});
+	}
+
+	ring.Clear();
+	std::size_t count = 0;
+	ring.ForEachFn([&count](const ChunkPos3 &, int) { ++count; });
+	CHECK(count == 0);
+}
+
+TEST_CASE("Ring map ChunkPool grows with the load shape") {
+	const auto check_loaded = [](const World &world) {
+		ChunkLoadShape shape = world.GetLoadShape();
+		for (int32_t z = -shape.radius; z <= shape.radius; ++z)
+			for (int32_t x = -shape.radius; x <= shape.radius; ++x)
+				for (int32_t y = -shape.GetHalfHeight(x, z); y <= shape.GetHalfHeight(x, z); ++y) {
+					ChunkPos3 pos = world.GetCenterChunkPos() + ChunkPos3(x, y, z);
+					CAPTURE(pos.x);
+					CAPTURE(pos.y);
+					CAPTURE(pos.z);
+					REQUIRE(world.GetChunkPool().FindRawChunk(pos));
+				}
+	};
+
+	auto world = World::Create(ChunkLoadShape{.radius = 3, .height = 2}, 4, ChunkPoolStorage::kRingMap);
+	world->Start();
+	auto [extent_xz, extent_y] = world->GetChunkPool().GetRingMapExtents();
+	check_loaded(*world);
+
+	world->SetCenterChunkPos({-5, 3, 7});
+	world->SetLoadChunkRadius(12);
+	world->SetLoadChunkHeight(9);
+	auto [grown_extent_xz, grown_extent_y] = world->GetChunkPool().GetRingMapExtents();
+	CHECK(grown_extent_xz > extent_xz);
+	CHECK(grown_extent_y > extent_y);
+	check_loaded(*world);
+
+	world->SetUnloadChunkRadius(20);
+	world->SetCenterChunkPos({-9, 3, 7});
+	check_loaded(*world);
+}
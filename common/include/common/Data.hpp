@@ -83,6 +83,8 @@ static_assert(sizeof(PackedChunkSunlightEntry) == 2);
 struct PackedChunkEntry {
 	std::vector<PackedChunkBlockEntry> blocks;
 	std::vector<PackedChunkSunlightEntry> sunlights;
+	// Encoded generated chunk that the entries apply on, empty if it has to be generated
+	std::vector<uint8_t> baked;
 };
 
 } // namespace hc
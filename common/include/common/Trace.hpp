@@ -0,0 +1,58 @@
+#ifndef HYPERCRAFT_COMMON_TRACE_HPP
+#define HYPERCRAFT_COMMON_TRACE_HPP
+
+// Scoped trace zones, enabled by the HYPERCRAFT_TRACE option. Each thread records its zones into its own ring buffer
+// and Trace::ToChromeJSON() exports them in the Chrome trace event format (chrome://tracing or ui.perfetto.dev).
+// Without the option the macros expand to nothing.
+
+#ifdef HYPERCRAFT_TRACE
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace hc {
+
+class Trace {
+public:
+	// Zones per thread, older ones are overwritten
+	inline static constexpr std::size_t kBufferSize = 1 << 16;
+
+	inline static int64_t GetNow() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		           std::chrono::steady_clock::now().time_since_epoch())
+		    .count();
+	}
+	// The name must outlive the trace, normally a string literal
+	static void Record(const char *name, int64_t begin_ns, int64_t end_ns);
+	static void SetThreadName(std::string name);
+	static std::string ToChromeJSON();
+};
+
+class TraceZone {
+private:
+	const char *m_name;
+	int64_t m_begin;
+
+public:
+	inline explicit TraceZone(const char *name) : m_name{name}, m_begin{Trace::GetNow()} {}
+	inline ~TraceZone() { Trace::Record(m_name, m_begin, Trace::GetNow()); }
+	TraceZone(const TraceZone &) = delete;
+	TraceZone &operator=(const TraceZone &) = delete;
+};
+
+} // namespace hc
+
+#define HC_TRACE_CONCAT_IMPL(a, b) a##b
+#define HC_TRACE_CONCAT(a, b) HC_TRACE_CONCAT_IMPL(a, b)
+#define HC_TRACE_ZONE(name) ::hc::TraceZone HC_TRACE_CONCAT(hc_trace_zone_, __LINE__){name}
+#define HC_TRACE_THREAD_NAME(name) ::hc::Trace::SetThreadName(name)
+
+#else
+
+#define HC_TRACE_ZONE(name)
+#define HC_TRACE_THREAD_NAME(name)
+
+#endif
+
+#endif
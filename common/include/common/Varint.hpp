@@ -0,0 +1,30 @@
+#ifndef HYPERCRAFT_COMMON_VARINT_HPP
+#define HYPERCRAFT_COMMON_VARINT_HPP
+
+#include <cinttypes>
+#include <vector>
+
+namespace hc {
+
+// LEB128 encoding of unsigned integers, 7 bits per byte
+inline void PutVarint(std::vector<uint8_t> *p_bytes, uint32_t value) {
+	for (; value >= 0x80u; value >>= 7u)
+		p_bytes->push_back(uint8_t(value | 0x80u));
+	p_bytes->push_back(uint8_t(value));
+}
+
+// Reads a varint at *p_data and advances it, never reading past end
+inline uint32_t GetVarint(const uint8_t **p_data, const uint8_t *end) {
+	uint32_t value = 0;
+	for (uint32_t shift = 0; *p_data < end && shift < 32; shift += 7) {
+		uint8_t byte = *(*p_data)++;
+		value |= uint32_t(byte & 0x7fu) << shift;
+		if (!(byte & 0x80u))
+			break;
+	}
+	return value;
+}
+
+} // namespace hc
+
+#endif
@@ -4,27 +4,58 @@
 #include <common/Data.hpp>
 #include <lmdb.h>
 #include <memory>
+#include <optional>
 #include <span>
 #include <vector>
 
 namespace hc {
 
+// SetBlocks()/SetSunlights() requests of a chunk, applied in order on a single read and write of its records
+struct ChunkWriteRequests {
+	ChunkPos3 chunk_pos{};
+	std::vector<std::vector<ChunkSetBlockEntry>> blocks;
+	std::vector<std::vector<ChunkSetSunlightEntry>> sunlights;
+	// Replaces the baked chunk of baked_version if not empty
+	uint32_t baked_version{};
+	std::vector<uint8_t> baked;
+};
+// Resolved entries of each request
+struct ChunkWriteResults {
+	std::vector<std::vector<PackedChunkBlockEntry>> blocks;
+	std::vector<std::vector<PackedChunkSunlightEntry>> sunlights;
+};
+
 class WorldDatabase {
 private:
 	MDB_env *m_env{nullptr};
-	MDB_dbi m_config_db{}, m_block_db{}, m_sunlight_db{};
+	MDB_dbi m_config_db{}, m_block_db{}, m_sunlight_db{}, m_baked_db{};
+	bool m_compress_records{true};
+
+	// Return the error of the failed mdb call, if any
+	int write_chunk(MDB_txn *txn, const ChunkWriteRequests &requests, ChunkWriteResults *p_results);
+	int write_baked(MDB_txn *txn, const ChunkWriteRequests &requests);
 
 public:
 	static std::unique_ptr<WorldDatabase> Create(const char *filename, std::size_t max_size = 1024 * 1024 * 1024);
 
+	// Whether new block and sunlight records may be compressed, records of either kind are always readable
+	inline void SetRecordCompression(bool compress) { m_compress_records = compress; }
+	// Size of the used pages in bytes
+	[[nodiscard]] std::size_t GetUsedSize() const;
+
 	void SetSeed(uint32_t seed);
 	[[nodiscard]] uint32_t GetSeed() const;
 
 	static_assert(sizeof(ChunkPos1) == sizeof(unsigned short) && sizeof(ChunkPos3) == 3 * sizeof(unsigned short));
 
-	[[nodiscard]] std::vector<PackedChunkEntry> GetChunks(std::span<const ChunkPos3> chunk_pos_s) const;
+	// Also reads the baked chunks of baked_version if given
+	[[nodiscard]] std::vector<PackedChunkEntry> GetChunks(std::span<const ChunkPos3> chunk_pos_s,
+	                                                      std::optional<uint32_t> baked_version = std::nullopt) const;
 	std::vector<PackedChunkBlockEntry> SetBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks);
 	std::vector<PackedChunkSunlightEntry> SetSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights);
+	// Apply the requests of many chunks in a single write transaction, then their baked chunks in another one. If the
+	// first one fails (e.g. the map is full), every result is empty.
+	std::vector<ChunkWriteResults> Write(std::span<const ChunkWriteRequests> chunks);
 
 	~WorldDatabase();
 };
@@ -0,0 +1,69 @@
+#ifndef HYPERCRAFT_COMMON_WORLD_DATABASE_WRITER_HPP
+#define HYPERCRAFT_COMMON_WORLD_DATABASE_WRITER_HPP
+
+#include <common/WorldDatabase.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hc {
+
+struct WorldDatabaseWriterConfig {
+	// How long a request may wait for others to join its transaction
+	std::chrono::milliseconds flush_latency{4};
+	// Maximum chunks committed in one transaction
+	std::size_t max_batch_chunks{256};
+};
+
+// Write-behind stage of a WorldDatabase. Requests are coalesced per chunk and committed by a dedicated thread, many
+// chunks per transaction, then their resolved entries are passed to the callbacks on that thread.
+class WorldDatabaseWriter {
+public:
+	using BlockCallback = std::function<void(std::vector<PackedChunkBlockEntry> &&)>;
+	using SunlightCallback = std::function<void(std::vector<PackedChunkSunlightEntry> &&)>;
+
+private:
+	struct PendingChunk {
+		ChunkWriteRequests requests;
+		std::vector<BlockCallback> block_callbacks;
+		std::vector<SunlightCallback> sunlight_callbacks;
+	};
+
+	WorldDatabase *m_p_database;
+	WorldDatabaseWriterConfig m_config;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition, m_idle_condition;
+	std::unordered_map<ChunkPos3, PendingChunk> m_pending_chunks;
+	std::vector<ChunkPos3> m_pending_order; // chunks in the order of their first pending request
+	std::chrono::steady_clock::time_point m_first_pending_time;
+	std::size_t m_edit_count{0}; // block and sunlight requests not committed yet
+	bool m_running{true}, m_flushing{false};
+	std::thread m_thread;
+
+	PendingChunk &get_pending_chunk(const ChunkPos3 &chunk_pos);
+	void thread_func();
+
+public:
+	explicit WorldDatabaseWriter(WorldDatabase *p_database, const WorldDatabaseWriterConfig &config = {});
+	// Commit the pending requests and join the writer thread
+	~WorldDatabaseWriter();
+
+	void SetBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks, BlockCallback &&callback);
+	void SetSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights,
+	                  SunlightCallback &&callback);
+	// Store the baked chunk of a generator version, replacing a pending one
+	void SetBakedChunk(ChunkPos3 chunk_pos, uint32_t version, std::vector<uint8_t> &&baked);
+	// Block until the block and sunlight requests so far are committed, without waiting for the flush latency
+	void Flush();
+	inline const WorldDatabaseWriterConfig &GetConfig() const { return m_config; }
+};
+
+} // namespace hc
+
+#endif
@@ -0,0 +1,128 @@
+#include <common/Trace.hpp>
+
+#ifdef HYPERCRAFT_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace hc {
+
+namespace {
+
+struct TraceEvent {
+	std::atomic<const char *> name;
+	std::atomic_int64_t begin, end;
+};
+
+// Only written by its thread. Buffers are kept after their thread exits so that its zones can still be exported.
+struct TraceBuffer {
+	uint32_t tid{};
+	std::string name;
+	std::atomic_uint64_t count{0};
+	std::array<TraceEvent, Trace::kBufferSize> events{};
+};
+
+struct TraceRegistry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+	const int64_t begin_ns = Trace::GetNow();
+};
+
+TraceRegistry &get_registry() {
+	static TraceRegistry registry;
+	return registry;
+}
+
+thread_local TraceBuffer *t_buffer = nullptr;
+
+TraceBuffer &get_buffer() {
+	if (!t_buffer) {
+		auto &registry = get_registry();
+		std::scoped_lock lock{registry.mutex};
+		auto &buffer = registry.buffers.emplace_back(std::make_unique<TraceBuffer>());
+		buffer->tid = (uint32_t)registry.buffers.size();
+		buffer->name = "thread " + std::to_string(buffer->tid);
+		t_buffer = buffer.get();
+	}
+	return *t_buffer;
+}
+
+void append_json_string(std::string *p_json, const char *str) {
+	p_json->push_back('"');
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\')
+			p_json->push_back('\\');
+		p_json->push_back(*str);
+	}
+	p_json->push_back('"');
+}
+
+} // namespace
+
+void Trace::Record(const char *name, int64_t begin_ns, int64_t end_ns) {
+	TraceBuffer &buffer = get_buffer();
+	uint64_t index = buffer.count.load(std::memory_order_relaxed);
+	TraceEvent &event = buffer.events[index % kBufferSize];
+	event.name.store(name, std::memory_order_relaxed);
+	event.begin.store(begin_ns, std::memory_order_relaxed);
+	event.end.store(end_ns, std::memory_order_relaxed);
+	buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Trace::SetThreadName(std::string name) {
+	TraceBuffer &buffer = get_buffer();
+	std::scoped_lock lock{get_registry().mutex};
+	buffer.name = std::move(name);
+}
+
+std::string Trace::ToChromeJSON() {
+	auto &registry = get_registry();
+	std::scoped_lock lock{registry.mutex};
+
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	char number[128];
+	for (const auto &buffer : registry.buffers) {
+		if (!first)
+			json += ',';
+		first = false;
+		snprintf(number, sizeof(number),
+		         "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buffer->tid);
+		json += number;
+		append_json_string(&json, buffer->name.c_str());
+		json += "}}";
+
+		// Copy the events, then drop the ones the thread may have overwritten meanwhile
+		uint64_t end = buffer->count.load(std::memory_order_acquire);
+		uint64_t begin = end > kBufferSize ? end - kBufferSize : 0;
+		std::vector<std::tuple<const char *, int64_t, int64_t>> events;
+		events.reserve(end - begin);
+		for (uint64_t i = begin; i < end; ++i) {
+			const TraceEvent &event = buffer->events[i % kBufferSize];
+			events.emplace_back(event.name.load(std::memory_order_relaxed),
+			                    event.begin.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed));
+		}
+		uint64_t new_end = buffer->count.load(std::memory_order_acquire);
+		uint64_t valid_begin = new_end >= kBufferSize ? std::max(begin, new_end - kBufferSize + 1) : begin;
+
+		for (uint64_t i = valid_begin; i < end; ++i) {
+			const auto &[name, begin_ns, end_ns] = events[i - begin];
+			json += ",{\"ph\":\"X\",\"name\":";
+			append_json_string(&json, name);
+			snprintf(number, sizeof(number), ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid,
+			         double(begin_ns - registry.begin_ns) / 1000.0, double(end_ns - begin_ns) / 1000.0);
+			json += number;
+		}
+	}
+	return json + "]}";
+}
+
+} // namespace hc
+
+#endif
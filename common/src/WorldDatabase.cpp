@@ -1,10 +1,19 @@
 #include <common/WorldDatabase.hpp>
 
+#include <common/Trace.hpp>
+#include <common/Varint.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <type_traits>
+
 namespace hc {
 
-inline constexpr const char *kConfigDBName = "config", *kBlockDBName = "block", *kSunlightDBName = "sunlight";
+inline constexpr const char *kConfigDBName = "config", *kBlockDBName = "block", *kSunlightDBName = "sunlight",
+                            *kBakedDBName = "baked";
 inline constexpr char kConfigSeedName[] = "seed";
 inline constexpr MDB_val kConfigSeedKey = {.mv_size = sizeof(kConfigSeedName), .mv_data = (void *)kConfigSeedName};
 
@@ -30,6 +39,7 @@ std::unique_ptr<WorldDatabase> WorldDatabase::Create(const char *filename, std::
 	MDB_CALL(nullptr, mdb_dbi_open, txn, kConfigDBName, MDB_CREATE, &ret->m_config_db);
 	MDB_CALL(nullptr, mdb_dbi_open, txn, kBlockDBName, MDB_CREATE, &ret->m_block_db);
 	MDB_CALL(nullptr, mdb_dbi_open, txn, kSunlightDBName, MDB_CREATE, &ret->m_sunlight_db);
+	MDB_CALL(nullptr, mdb_dbi_open, txn, kBakedDBName, MDB_CREATE, &ret->m_baked_db);
 	mdb_txn_commit(txn);
 
 	return ret;
@@ -55,7 +65,348 @@ uint32_t WorldDatabase::GetSeed() const {
 
 WorldDatabase::~WorldDatabase() { mdb_env_close(m_env); }
 
-std::vector<PackedChunkEntry> WorldDatabase::GetChunks(std::span<const ChunkPos3> chunk_pos_s) const {
+std::size_t WorldDatabase::GetUsedSize() const {
+	MDB_envinfo info{};
+	MDB_stat stat{};
+	mdb_env_info(m_env, &info);
+	mdb_env_stat(m_env, &stat);
+	return (info.me_last_pgno + 1) * stat.ms_psize;
+}
+
+namespace {
+
+// Block and sunlight records start with a RecordFormat byte and keep their entries sorted by index. Records written
+// before the format byte are unsorted entry arrays, told apart by their size being a multiple of the entry size, since
+// the new records always have an odd size.
+enum class RecordFormat : uint8_t { kSparse = 1, kDense = 2, kCompressed = 3 };
+
+inline constexpr uint32_t kBlockCount = kChunkSize * kChunkSize * kChunkSize, kSunlightCount = kChunkSize * kChunkSize;
+// A dense block record is a presence bitmap followed by the present blocks, smaller than sparse past this count
+inline constexpr std::size_t kDenseBlockThreshold =
+    kBlockCount / 8 / (sizeof(PackedChunkBlockEntry) - sizeof(uint16_t));
+// A dense sunlight record holds a byte per column, kNoSunlight for absent entries
+inline constexpr std::size_t kDenseSunlightThreshold = kSunlightCount / sizeof(PackedChunkSunlightEntry);
+inline constexpr uint8_t kNoSunlight = 0xff;
+static_assert(kChunkSize + 1 < kNoSunlight);
+static_assert(sizeof(PackedChunkBlockEntry) % 2 == 0 && sizeof(PackedChunkSunlightEntry) % 2 == 0 &&
+              (kBlockCount / 8) % 2 == 0 && kSunlightCount % 2 == 0);
+
+// Compressed records hold the entry count, the runs of consecutive indices as (gap, length - 1) varint pairs, then the
+// runs of equal values as (value, length - 1) varint pairs. Block values are indices into a palette stored before
+// them. A zero byte is appended to keep the size odd.
+template <typename Entry> void put_index_runs(std::vector<uint8_t> *p_record, std::span<const Entry> entries) {
+	uint32_t prev_end = 0;
+	for (std::size_t i = 0; i < entries.size();) {
+		std::size_t j = i + 1;
+		while (j < entries.size() && entries[j].GetIndex() == entries[j - 1].GetIndex() + 1u)
+			++j;
+		PutVarint(p_record, entries[i].GetIndex() - prev_end);
+		PutVarint(p_record, uint32_t(j - i - 1));
+		prev_end = entries[j - 1].GetIndex() + 1u;
+		i = j;
+	}
+}
+
+template <typename GetValueFunc>
+void put_value_runs(std::vector<uint8_t> *p_record, std::size_t count, GetValueFunc &&get_value_func) {
+	for (std::size_t i = 0; i < count;) {
+		uint32_t value = get_value_func(i);
+		std::size_t j = i + 1;
+		while (j < count && get_value_func(j) == value)
+			++j;
+		PutVarint(p_record, value);
+		PutVarint(p_record, uint32_t(j - i - 1));
+		i = j;
+	}
+}
+
+std::vector<uint32_t> get_index_runs(const uint8_t **p_data, const uint8_t *end, uint32_t count, uint32_t max_index) {
+	std::vector<uint32_t> indices;
+	indices.reserve(count);
+	uint32_t prev_end = 0;
+	while (indices.size() < count && *p_data < end) {
+		uint32_t begin = prev_end + GetVarint(p_data, end), length = GetVarint(p_data, end) + 1;
+		length = std::min({length, max_index - std::min(begin, max_index), count - (uint32_t)indices.size()});
+		for (uint32_t i = 0; i < length; ++i)
+			indices.push_back(begin + i);
+		prev_end = begin + length;
+	}
+	return indices;
+}
+
+template <typename SetValueFunc>
+void get_value_runs(const uint8_t **p_data, const uint8_t *end, std::size_t count, SetValueFunc &&set_value_func) {
+	for (std::size_t i = 0; i < count && *p_data < end;) {
+		uint32_t value = GetVarint(p_data, end), length = GetVarint(p_data, end) + 1;
+		for (std::size_t j = 0; j < length && i < count; ++j)
+			set_value_func(i++, value);
+	}
+}
+
+void pad_odd(std::vector<uint8_t> *p_record) {
+	if (p_record->size() % 2 == 0)
+		p_record->push_back(0);
+}
+
+// Entries out of the chunk (from a corrupt record) are skipped
+template <typename Entry>
+std::vector<Entry> decode_sparse(const uint8_t *data, std::size_t size, uint32_t max_index) {
+	using PackedData = decltype(std::declval<Entry>().GetPackedData());
+	std::vector<Entry> entries;
+	entries.reserve(size / sizeof(Entry));
+	for (std::size_t i = 0; i < size / sizeof(Entry); ++i) {
+		Entry entry{PackedData{}};
+		std::memcpy(&entry, data + i * sizeof(Entry), sizeof(Entry));
+		if (entry.GetIndex() < max_index)
+			entries.push_back(entry);
+	}
+	return entries;
+}
+
+std::vector<PackedChunkBlockEntry> decode_blocks(const MDB_val &val) {
+	const auto *data = (const uint8_t *)val.mv_data;
+	if (val.mv_size % sizeof(PackedChunkBlockEntry) == 0) {
+		auto entries = decode_sparse<PackedChunkBlockEntry>(data, val.mv_size, kBlockCount);
+		std::sort(entries.begin(), entries.end(), [](auto l, auto r) { return l.GetIndex() < r.GetIndex(); });
+		return entries;
+	}
+	if (RecordFormat(data[0]) == RecordFormat::kSparse)
+		return decode_sparse<PackedChunkBlockEntry>(data + 1, val.mv_size - 1, kBlockCount);
+	if (RecordFormat(data[0]) == RecordFormat::kCompressed) {
+		const uint8_t *ptr = data + 1, *end = data + val.mv_size;
+		uint32_t count = std::min(GetVarint(&ptr, end), kBlockCount);
+		std::vector<uint32_t> indices = get_index_runs(&ptr, end, count, kBlockCount);
+		std::vector<uint16_t> palette(std::min(GetVarint(&ptr, end), kBlockCount));
+		for (auto &block_data : palette)
+			block_data = (uint16_t)GetVarint(&ptr, end);
+		std::vector<PackedChunkBlockEntry> entries;
+		entries.reserve(indices.size());
+		get_value_runs(&ptr, end, indices.size(), [&](std::size_t i, uint32_t palette_index) {
+			uint16_t block_data = palette_index < palette.size() ? palette[palette_index] : 0;
+			entries.emplace_back((indices[i] << 16u) | block_data);
+		});
+		return entries;
+	}
+
+	if (val.mv_size < 1 + kBlockCount / 8)
+		return {};
+	const uint8_t *bitmap = data + 1, *blocks = bitmap + kBlockCount / 8, *end = data + val.mv_size;
+	std::vector<PackedChunkBlockEntry> entries;
+	entries.reserve((val.mv_size - 1 - kBlockCount / 8) / sizeof(uint16_t));
+	for (uint32_t i = 0; i < kBlockCount; ++i) {
+		if (!(bitmap[i >> 3u] & (1u << (i & 7u))))
+			continue;
+		if (end - blocks < (std::ptrdiff_t)sizeof(uint16_t))
+			break;
+		uint16_t block_data;
+		std::copy(blocks, blocks + sizeof(uint16_t), (uint8_t *)&block_data);
+		blocks += sizeof(uint16_t);
+		entries.emplace_back((uint32_t(i) << 16u) | block_data);
+	}
+	return entries;
+}
+
+std::vector<uint8_t> encode_blocks_compressed(std::span<const PackedChunkBlockEntry> entries) {
+	std::vector<uint8_t> record{(uint8_t)RecordFormat::kCompressed};
+	PutVarint(&record, (uint32_t)entries.size());
+	put_index_runs(&record, entries);
+
+	std::vector<uint16_t> palette;
+	std::vector<uint32_t> palette_indices(entries.size());
+	std::unordered_map<uint16_t, uint32_t> palette_map;
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		auto [it, inserted] = palette_map.try_emplace(entries[i].GetBlock().GetData(), (uint32_t)palette.size());
+		if (inserted)
+			palette.push_back(it->first);
+		palette_indices[i] = it->second;
+	}
+	PutVarint(&record, (uint32_t)palette.size());
+	for (uint16_t block_data : palette)
+		PutVarint(&record, block_data);
+	put_value_runs(&record, entries.size(), [&](std::size_t i) { return palette_indices[i]; });
+
+	pad_odd(&record);
+	return record;
+}
+
+std::vector<uint8_t> encode_blocks(std::span<const PackedChunkBlockEntry> entries, bool compress) {
+	if (compress) {
+		std::vector<uint8_t> record = encode_blocks_compressed(entries);
+		if (record.size() <= 1 + std::min(entries.size_bytes(), kBlockCount / 8 + entries.size() * sizeof(uint16_t)))
+			return record;
+	}
+	std::vector<uint8_t> record;
+	if (entries.size() <= kDenseBlockThreshold) {
+		record.resize(1 + entries.size_bytes());
+		record[0] = (uint8_t)RecordFormat::kSparse;
+		std::copy((const uint8_t *)entries.data(), (const uint8_t *)entries.data() + entries.size_bytes(),
+		          record.data() + 1);
+		return record;
+	}
+	record.resize(1 + kBlockCount / 8 + entries.size() * sizeof(uint16_t));
+	record[0] = (uint8_t)RecordFormat::kDense;
+	uint8_t *bitmap = record.data() + 1, *blocks = bitmap + kBlockCount / 8;
+	for (auto entry : entries) {
+		bitmap[entry.GetIndex() >> 3u] |= uint8_t(1u << (entry.GetIndex() & 7u));
+		uint16_t block_data = entry.GetBlock().GetData();
+		blocks = std::copy((const uint8_t *)&block_data, (const uint8_t *)&block_data + sizeof(uint16_t), blocks);
+	}
+	return record;
+}
+
+std::vector<PackedChunkSunlightEntry> decode_sunlights(const MDB_val &val) {
+	const auto *data = (const uint8_t *)val.mv_data;
+	if (val.mv_size % sizeof(PackedChunkSunlightEntry) == 0) {
+		auto entries = decode_sparse<PackedChunkSunlightEntry>(data, val.mv_size, kSunlightCount);
+		std::sort(entries.begin(), entries.end(), [](auto l, auto r) { return l.GetIndex() < r.GetIndex(); });
+		return entries;
+	}
+	if (RecordFormat(data[0]) == RecordFormat::kSparse)
+		return decode_sparse<PackedChunkSunlightEntry>(data + 1, val.mv_size - 1, kSunlightCount);
+	if (RecordFormat(data[0]) == RecordFormat::kCompressed) {
+		const uint8_t *ptr = data + 1, *end = data + val.mv_size;
+		uint32_t count = std::min(GetVarint(&ptr, end), kSunlightCount);
+		std::vector<uint32_t> indices = get_index_runs(&ptr, end, count, kSunlightCount);
+		std::vector<PackedChunkSunlightEntry> entries;
+		entries.reserve(indices.size());
+		get_value_runs(&ptr, end, indices.size(), [&](std::size_t i, uint32_t sunlight) {
+			entries.emplace_back((InnerIndex2)indices[i], (InnerPos1)sunlight);
+		});
+		return entries;
+	}
+
+	std::vector<PackedChunkSunlightEntry> entries;
+	for (uint32_t i = 0; i < std::min<std::size_t>(kSunlightCount, val.mv_size - 1); ++i)
+		if (data[1 + i] != kNoSunlight)
+			entries.emplace_back((InnerIndex2)i, (InnerPos1)data[1 + i]);
+	return entries;
+}
+
+std::vector<uint8_t> encode_sunlights_compressed(std::span<const PackedChunkSunlightEntry> entries) {
+	std::vector<uint8_t> record{(uint8_t)RecordFormat::kCompressed};
+	PutVarint(&record, (uint32_t)entries.size());
+	put_index_runs(&record, entries);
+	put_value_runs(&record, entries.size(), [&](std::size_t i) { return (uint32_t)entries[i].GetSunlight(); });
+	pad_odd(&record);
+	return record;
+}
+
+std::vector<uint8_t> encode_sunlights(std::span<const PackedChunkSunlightEntry> entries, bool compress) {
+	if (compress) {
+		std::vector<uint8_t> record = encode_sunlights_compressed(entries);
+		if (record.size() <= 1 + std::min<std::size_t>(entries.size_bytes(), kSunlightCount))
+			return record;
+	}
+	std::vector<uint8_t> record;
+	if (entries.size() <= kDenseSunlightThreshold) {
+		record.resize(1 + entries.size_bytes());
+		record[0] = (uint8_t)RecordFormat::kSparse;
+		std::copy((const uint8_t *)entries.data(), (const uint8_t *)entries.data() + entries.size_bytes(),
+		          record.data() + 1);
+		return record;
+	}
+	record.resize(1 + kSunlightCount, kNoSunlight);
+	record[0] = (uint8_t)RecordFormat::kDense;
+	for (auto entry : entries)
+		record[1 + entry.GetIndex()] = (uint8_t)entry.GetSunlight();
+	return record;
+}
+
+// Merge the request into the sorted entries of a chunk record with a single pass, returns the resolved entries. An
+// existing entry is only replaced if it equals the old value of the request, and the last request of an index wins.
+template <typename Entry, typename SetEntry, typename GetOldFunc, typename MakeEntryFunc>
+std::vector<Entry> merge_entries(std::vector<Entry> *p_entries, std::span<const SetEntry> request,
+                                 GetOldFunc &&get_old_func, MakeEntryFunc &&make_entry_func) {
+	std::vector<SetEntry> sorted_request{request.begin(), request.end()};
+	std::stable_sort(sorted_request.begin(), sorted_request.end(),
+	                 [](const auto &l, const auto &r) { return l.index < r.index; });
+
+	std::vector<Entry> merged, ret;
+	merged.reserve(p_entries->size() + sorted_request.size());
+	ret.reserve(sorted_request.size());
+	auto entry_it = p_entries->begin();
+	for (auto it = sorted_request.begin(); it != sorted_request.end(); ++it) {
+		if (it + 1 != sorted_request.end() && (it + 1)->index == it->index)
+			continue;
+		while (entry_it != p_entries->end() && entry_it->GetIndex() < it->index)
+			merged.push_back(*entry_it++);
+		if (entry_it != p_entries->end() && entry_it->GetIndex() == it->index) {
+			merged.push_back(get_old_func(*entry_it) == get_old_func(*it) ? make_entry_func(*it) : *entry_it);
+			++entry_it;
+		} else
+			merged.push_back(make_entry_func(*it));
+		ret.push_back(merged.back());
+	}
+	merged.insert(merged.end(), entry_it, p_entries->end());
+	*p_entries = std::move(merged);
+	return ret;
+}
+
+std::vector<PackedChunkBlockEntry> apply_blocks(std::vector<PackedChunkBlockEntry> *p_entries,
+                                                std::span<const ChunkSetBlockEntry> blocks) {
+	return merge_entries<PackedChunkBlockEntry>(
+	    p_entries, blocks,
+	    [](const auto &e) {
+		    if constexpr (std::is_same_v<std::decay_t<decltype(e)>, ChunkSetBlockEntry>)
+			    return e.old_block;
+		    else
+			    return e.GetBlock();
+	    },
+	    [](const ChunkSetBlockEntry &b) { return PackedChunkBlockEntry{b.index, b.new_block}; });
+}
+
+std::vector<PackedChunkSunlightEntry> apply_sunlights(std::vector<PackedChunkSunlightEntry> *p_entries,
+                                                      std::span<const ChunkSetSunlightEntry> sunlights) {
+	return merge_entries<PackedChunkSunlightEntry>(
+	    p_entries, sunlights,
+	    [](const auto &e) {
+		    if constexpr (std::is_same_v<std::decay_t<decltype(e)>, ChunkSetSunlightEntry>)
+			    return e.old_sunlight;
+		    else
+			    return e.GetSunlight();
+	    },
+	    [](const ChunkSetSunlightEntry &b) { return PackedChunkSunlightEntry{b.index, b.new_sunlight}; });
+}
+
+// Returns the error of mdb_put, if any
+template <typename Entry, typename Request, typename DecodeFunc, typename EncodeFunc, typename ApplyFunc>
+int write_record(MDB_txn *txn, MDB_dbi dbi, ChunkPos3 chunk_pos, const std::vector<Request> &requests,
+                  std::vector<std::vector<Entry>> *p_results, DecodeFunc &&decode_func, EncodeFunc &&encode_func,
+                  ApplyFunc &&apply_func) {
+	p_results->clear();
+	p_results->reserve(requests.size());
+	if (std::all_of(requests.begin(), requests.end(), [](const auto &request) { return request.empty(); })) {
+		p_results->resize(requests.size());
+		return MDB_SUCCESS;
+	}
+
+	MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos}, val{};
+	std::vector<Entry> entries;
+	if (mdb_get(txn, dbi, &key, &val) != MDB_NOTFOUND)
+		entries = decode_func(val);
+	for (const auto &request : requests)
+		p_results->push_back(apply_func(&entries, request));
+
+	std::vector<uint8_t> record = encode_func(entries);
+	val = {.mv_size = record.size(), .mv_data = record.data()};
+	return mdb_put(txn, dbi, &key, &val, 0);
+}
+
+// Baked chunks are keyed by position and generator version, so that a new generator ignores the old ones
+struct BakedKey {
+	std::array<uint8_t, sizeof(ChunkPos3) + sizeof(uint32_t)> bytes;
+	inline BakedKey(ChunkPos3 chunk_pos, uint32_t version) : bytes{} {
+		std::memcpy(bytes.data(), &chunk_pos, sizeof(ChunkPos3));
+		std::memcpy(bytes.data() + sizeof(ChunkPos3), &version, sizeof(uint32_t));
+	}
+	inline MDB_val GetVal() { return {.mv_size = bytes.size(), .mv_data = bytes.data()}; }
+};
+
+} // namespace
+
+std::vector<PackedChunkEntry> WorldDatabase::GetChunks(std::span<const ChunkPos3> chunk_pos_s,
+                                                       std::optional<uint32_t> baked_version) const {
+	HC_TRACE_ZONE("WorldDatabase::GetChunks");
 	std::vector<PackedChunkEntry> chunks;
 	chunks.reserve(chunk_pos_s.size());
 
@@ -67,102 +418,101 @@ std::vector<PackedChunkEntry> WorldDatabase::GetChunks(std::span<const ChunkPos3
 		auto &chunk = chunks.back();
 		MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos};
 		if (mdb_get(txn, m_block_db, &key, &block_val) != MDB_NOTFOUND)
-			chunk.blocks = {(PackedChunkBlockEntry *)block_val.mv_data,
-			                (PackedChunkBlockEntry *)((uint8_t *)block_val.mv_data + block_val.mv_size)};
+			chunk.blocks = decode_blocks(block_val);
 		if (mdb_get(txn, m_sunlight_db, &key, &sunlight_val) != MDB_NOTFOUND)
-			chunk.sunlights = {(PackedChunkSunlightEntry *)sunlight_val.mv_data,
-			                   (PackedChunkSunlightEntry *)((uint8_t *)sunlight_val.mv_data + sunlight_val.mv_size)};
+			chunk.sunlights = decode_sunlights(sunlight_val);
+		if (baked_version) {
+			BakedKey baked_key{chunk_pos, *baked_version};
+			MDB_val baked_key_val = baked_key.GetVal(), baked_val{};
+			if (mdb_get(txn, m_baked_db, &baked_key_val, &baked_val) != MDB_NOTFOUND)
+				chunk.baked = {(uint8_t *)baked_val.mv_data, (uint8_t *)baked_val.mv_data + baked_val.mv_size};
+		}
 	}
 	mdb_txn_abort(txn);
 
 	return chunks;
 }
 
-std::vector<PackedChunkBlockEntry> WorldDatabase::SetBlocks(ChunkPos3 chunk_pos,
-                                                            std::span<const ChunkSetBlockEntry> blocks) {
-	if (blocks.empty())
-		return {};
+int WorldDatabase::write_chunk(MDB_txn *txn, const ChunkWriteRequests &requests, ChunkWriteResults *p_results) {
+	const auto encode_block_record = [this](std::span<const PackedChunkBlockEntry> entries) {
+		return encode_blocks(entries, m_compress_records);
+	};
+	const auto encode_sunlight_record = [this](std::span<const PackedChunkSunlightEntry> entries) {
+		return encode_sunlights(entries, m_compress_records);
+	};
+	if (int err = write_record(txn, m_block_db, requests.chunk_pos, requests.blocks, &p_results->blocks,
+	                           decode_blocks, encode_block_record, apply_blocks))
+		return err;
+	return write_record(txn, m_sunlight_db, requests.chunk_pos, requests.sunlights, &p_results->sunlights,
+	                    decode_sunlights, encode_sunlight_record, apply_sunlights);
+}
 
-	std::unordered_map<InnerIndex3, std::pair<block::Block, block::Block>> block_map;
-	for (auto b : blocks)
-		block_map[b.index] = {b.old_block, b.new_block}; // TODO: do we need to deal with overlapped blocks ?
+int WorldDatabase::write_baked(MDB_txn *txn, const ChunkWriteRequests &requests) {
+	if (requests.baked.empty())
+		return MDB_SUCCESS;
+	BakedKey baked_key{requests.chunk_pos, requests.baked_version};
+	MDB_val key = baked_key.GetVal();
+	MDB_val val = {.mv_size = requests.baked.size(), .mv_data = (void *)requests.baked.data()};
+	return mdb_put(txn, m_baked_db, &key, &val, 0);
+}
 
-	std::vector<PackedChunkBlockEntry> ret;
-	ret.reserve(blocks.size());
+std::vector<ChunkWriteResults> WorldDatabase::Write(std::span<const ChunkWriteRequests> chunks) {
+	HC_TRACE_ZONE("WorldDatabase::Write");
+	std::vector<ChunkWriteResults> results(chunks.size());
+	if (chunks.empty())
+		return results;
 
+	// The edits are committed on their own, so that a full map only drops the baked chunks (generated again later)
 	MDB_txn *txn{};
-	mdb_txn_begin(m_env, nullptr, 0, &txn);
-	MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos}, val{};
-
-	std::vector<PackedChunkBlockEntry> entries;
-	if (mdb_get(txn, m_block_db, &key, &val) != MDB_NOTFOUND) {
-		entries = {(PackedChunkBlockEntry *)val.mv_data,
-		           (PackedChunkBlockEntry *)((uint8_t *)val.mv_data + val.mv_size)};
-		for (auto &entry : entries) {
-			auto it = block_map.find(entry.GetIndex());
-			if (it != block_map.end()) {
-				if (entry.GetBlock() == it->second.first) // SetBlock only if old_block == current block
-					entry = {it->first, it->second.second};
-
-				ret.push_back(entry);
-				block_map.erase(it);
-			}
+	int err = mdb_txn_begin(m_env, nullptr, 0, &txn);
+	for (std::size_t i = 0; !err && i < chunks.size(); ++i)
+		err = write_chunk(txn, chunks[i], &results[i]);
+	if (!err)
+		err = mdb_txn_commit(txn);
+	else if (txn)
+		mdb_txn_abort(txn);
+	if (err) {
+		// Nothing applied, so that the callers do not apply edits lost by the database
+		spdlog::error("WorldDatabase::Write edits of {} chunks lost: {}", chunks.size(), mdb_strerror(err));
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			results[i].blocks.assign(chunks[i].blocks.size(), {});
+			results[i].sunlights.assign(chunks[i].sunlights.size(), {});
 		}
-	}
-	for (const auto &b : block_map) {
-		entries.emplace_back(b.first, b.second.second);
-		ret.push_back(entries.back());
+		return results;
 	}
 
-	val = {.mv_size = entries.size() * sizeof(PackedChunkBlockEntry), .mv_data = entries.data()};
-	mdb_put(txn, m_block_db, &key, &val, 0);
-	mdb_txn_commit(txn);
+	if (std::none_of(chunks.begin(), chunks.end(), [](const auto &requests) { return !requests.baked.empty(); }))
+		return results;
+	txn = nullptr;
+	err = mdb_txn_begin(m_env, nullptr, 0, &txn);
+	for (std::size_t i = 0; !err && i < chunks.size(); ++i)
+		err = write_baked(txn, chunks[i]);
+	if (!err)
+		err = mdb_txn_commit(txn);
+	else if (txn)
+		mdb_txn_abort(txn);
+	if (err)
+		spdlog::warn("WorldDatabase::Write baked chunks dropped: {}", mdb_strerror(err));
+
+	return results;
+}
 
-	return ret;
+std::vector<PackedChunkBlockEntry> WorldDatabase::SetBlocks(ChunkPos3 chunk_pos,
+                                                            std::span<const ChunkSetBlockEntry> blocks) {
+	HC_TRACE_ZONE("WorldDatabase::SetBlocks");
+	if (blocks.empty())
+		return {};
+	ChunkWriteRequests requests{.chunk_pos = chunk_pos, .blocks = {{blocks.begin(), blocks.end()}}};
+	return std::move(Write({&requests, 1}).front().blocks.front());
 }
 
 std::vector<PackedChunkSunlightEntry> WorldDatabase::SetSunlights(ChunkPos3 chunk_pos,
                                                                   std::span<const ChunkSetSunlightEntry> sunlights) {
+	HC_TRACE_ZONE("WorldDatabase::SetSunlights");
 	if (sunlights.empty())
 		return {};
-
-	std::unordered_map<InnerIndex2, std::pair<InnerPos1, InnerPos1>> sunlight_map;
-	for (auto b : sunlights)
-		sunlight_map[b.index] = {b.old_sunlight, b.new_sunlight};
-
-	std::vector<PackedChunkSunlightEntry> ret;
-	ret.reserve(sunlights.size());
-
-	MDB_txn *txn{};
-	mdb_txn_begin(m_env, nullptr, 0, &txn);
-	MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos}, val{};
-
-	std::vector<PackedChunkSunlightEntry> entries;
-	if (mdb_get(txn, m_sunlight_db, &key, &val) != MDB_NOTFOUND) {
-		entries = {(PackedChunkSunlightEntry *)val.mv_data,
-		           (PackedChunkSunlightEntry *)((uint8_t *)val.mv_data + val.mv_size)};
-
-		for (auto &entry : entries) {
-			auto it = sunlight_map.find(entry.GetIndex());
-			if (it != sunlight_map.end()) {
-				if (entry.GetSunlight() == it->second.first)
-					entry = {it->first, it->second.second};
-
-				ret.push_back(entry);
-				sunlight_map.erase(it);
-			}
-		}
-	}
-	for (const auto &b : sunlight_map) {
-		entries.emplace_back(b.first, b.second.second);
-		ret.push_back(entries.back());
-	}
-
-	val = {.mv_size = entries.size() * sizeof(PackedChunkSunlightEntry), .mv_data = entries.data()};
-	mdb_put(txn, m_sunlight_db, &key, &val, 0);
-	mdb_txn_commit(txn);
-
-	return ret;
+	ChunkWriteRequests requests{.chunk_pos = chunk_pos, .sunlights = {{sunlights.begin(), sunlights.end()}}};
+	return std::move(Write({&requests, 1}).front().sunlights.front());
 }
 
-} // namespace hc
\ No newline at end of file
+} // namespace hc
@@ -0,0 +1,129 @@
+#include <common/WorldDatabaseWriter.hpp>
+
+#include <common/Trace.hpp>
+
+#include <algorithm>
+
+namespace hc {
+
+WorldDatabaseWriter::WorldDatabaseWriter(WorldDatabase *p_database, const WorldDatabaseWriterConfig &config)
+    : m_p_database{p_database}, m_config{config} {
+	m_config.max_batch_chunks = std::max(m_config.max_batch_chunks, (std::size_t)1);
+	m_thread = std::thread(&WorldDatabaseWriter::thread_func, this);
+}
+
+WorldDatabaseWriter::~WorldDatabaseWriter() {
+	{
+		std::scoped_lock lock{m_mutex};
+		m_running = false;
+	}
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+WorldDatabaseWriter::PendingChunk &WorldDatabaseWriter::get_pending_chunk(const ChunkPos3 &chunk_pos) {
+	if (m_pending_order.empty())
+		m_first_pending_time = std::chrono::steady_clock::now();
+	auto [it, inserted] = m_pending_chunks.try_emplace(chunk_pos);
+	if (inserted) {
+		it->second.requests.chunk_pos = chunk_pos;
+		m_pending_order.push_back(chunk_pos);
+	}
+	return it->second;
+}
+
+void WorldDatabaseWriter::SetBlocks(ChunkPos3 chunk_pos, std::span<const ChunkSetBlockEntry> blocks,
+                                    BlockCallback &&callback) {
+	{
+		std::scoped_lock lock{m_mutex};
+		auto &pending = get_pending_chunk(chunk_pos);
+		pending.requests.blocks.emplace_back(blocks.begin(), blocks.end());
+		pending.block_callbacks.push_back(std::move(callback));
+		++m_edit_count;
+	}
+	m_condition.notify_one();
+}
+
+void WorldDatabaseWriter::SetSunlights(ChunkPos3 chunk_pos, std::span<const ChunkSetSunlightEntry> sunlights,
+                                       SunlightCallback &&callback) {
+	{
+		std::scoped_lock lock{m_mutex};
+		auto &pending = get_pending_chunk(chunk_pos);
+		pending.requests.sunlights.emplace_back(sunlights.begin(), sunlights.end());
+		pending.sunlight_callbacks.push_back(std::move(callback));
+		++m_edit_count;
+	}
+	m_condition.notify_one();
+}
+
+void WorldDatabaseWriter::SetBakedChunk(ChunkPos3 chunk_pos, uint32_t version, std::vector<uint8_t> &&baked) {
+	{
+		std::scoped_lock lock{m_mutex};
+		auto &pending = get_pending_chunk(chunk_pos);
+		pending.requests.baked_version = version;
+		pending.requests.baked = std::move(baked);
+	}
+	m_condition.notify_one();
+}
+
+void WorldDatabaseWriter::Flush() {
+	std::unique_lock lock{m_mutex};
+	if (m_edit_count == 0)
+		return;
+	m_flushing = true;
+	m_condition.notify_one();
+	m_idle_condition.wait(lock, [this] { return m_edit_count == 0; });
+}
+
+void WorldDatabaseWriter::thread_func() {
+	std::vector<PendingChunk> batch;
+	std::vector<ChunkWriteRequests> requests;
+	std::unique_lock lock{m_mutex};
+	while (true) {
+		m_condition.wait(lock, [this] { return !m_pending_order.empty() || !m_running; });
+		if (m_pending_order.empty())
+			break;
+		// Wait for more requests to join the transaction
+		m_condition.wait_until(lock, m_first_pending_time + m_config.flush_latency, [this] {
+			return m_pending_order.size() >= m_config.max_batch_chunks || m_flushing || !m_running;
+		});
+
+		std::size_t count = std::min(m_pending_order.size(), m_config.max_batch_chunks);
+		batch.clear();
+		for (std::size_t i = 0; i < count; ++i) {
+			auto it = m_pending_chunks.find(m_pending_order[i]);
+			batch.push_back(std::move(it->second));
+			m_pending_chunks.erase(it);
+		}
+		m_pending_order.erase(m_pending_order.begin(), m_pending_order.begin() + (std::ptrdiff_t)count);
+		// The remaining requests are at least as old as the batch
+		m_first_pending_time = std::chrono::steady_clock::now() - m_config.flush_latency;
+		lock.unlock();
+
+		{
+			HC_TRACE_ZONE("WorldDatabaseWriter::Commit");
+			requests.clear();
+			for (auto &pending : batch)
+				requests.push_back(std::move(pending.requests));
+			std::vector<ChunkWriteResults> results = m_p_database->Write(requests);
+			for (std::size_t i = 0; i < batch.size(); ++i) {
+				for (std::size_t r = 0; r < batch[i].block_callbacks.size(); ++r)
+					batch[i].block_callbacks[r](std::move(results[i].blocks[r]));
+				for (std::size_t r = 0; r < batch[i].sunlight_callbacks.size(); ++r)
+					batch[i].sunlight_callbacks[r](std::move(results[i].sunlights[r]));
+			}
+		}
+
+		std::size_t edit_count = 0;
+		for (const auto &pending : batch)
+			edit_count += pending.block_callbacks.size() + pending.sunlight_callbacks.size();
+		lock.lock();
+		m_edit_count -= edit_count;
+		if (m_edit_count == 0) {
+			m_flushing = false;
+			m_idle_condition.notify_all();
+		}
+	}
+}
+
+} // namespace hc
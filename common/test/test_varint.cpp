@@ -0,0 +1,43 @@
+#include "doctest.h"
+
+#include <common/Varint.hpp>
+
+#include <limits>
+
+using namespace hc;
+
+TEST_CASE("Varints round-trip") {
+	const uint32_t values[] = {0u,      1u,       0x7fu,      0x80u,      0x3fffu,
+	                           0x4000u, 0x1fffffu, 0x200000u, 0xfffffffu, std::numeric_limits<uint32_t>::max()};
+	const std::size_t sizes[] = {1, 1, 1, 2, 2, 3, 3, 4, 4, 5};
+	std::vector<uint8_t> bytes;
+	for (std::size_t i = 0; i < std::size(values); ++i) {
+		std::size_t prev_size = bytes.size();
+		PutVarint(&bytes, values[i]);
+		CHECK(bytes.size() - prev_size == sizes[i]);
+	}
+
+	const uint8_t *ptr = bytes.data(), *end = bytes.data() + bytes.size();
+	for (uint32_t value : values)
+		CHECK(GetVarint(&ptr, end) == value);
+	CHECK(ptr == end);
+}
+
+TEST_CASE("Varints never read past the end") {
+	std::vector<uint8_t> bytes;
+	PutVarint(&bytes, 0x12345678u);
+	REQUIRE(bytes.size() == 5);
+	for (std::size_t size = 0; size < bytes.size(); ++size) {
+		CAPTURE(size);
+		const uint8_t *ptr = bytes.data(), *end = bytes.data() + size;
+		// only the low bits read so far
+		CHECK(GetVarint(&ptr, end) == (0x12345678u & ((1u << (7 * size)) - 1u)));
+		CHECK(ptr == end);
+	}
+
+	// Continuation bits past 32 bits stop the read
+	const uint8_t overlong[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+	const uint8_t *ptr = overlong;
+	GetVarint(&ptr, overlong + sizeof(overlong));
+	CHECK(ptr == overlong + 5);
+}
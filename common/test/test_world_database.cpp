@@ -0,0 +1,362 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <common/WorldDatabase.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+using namespace hc;
+using namespace hc::block;
+
+namespace {
+
+// Record format bytes, see WorldDatabase.cpp
+constexpr uint8_t kSparse = 1, kDense = 2, kCompressed = 3;
+constexpr ChunkPos3 kChunkPos{1, -2, 3};
+
+// A database file removed before and after the test
+class TempDatabase {
+private:
+	std::filesystem::path m_path;
+
+	inline void remove() const {
+		std::filesystem::remove(m_path);
+		std::filesystem::remove(m_path.string() + "-lock");
+	}
+
+public:
+	inline explicit TempDatabase(const char *name)
+	    : m_path{std::filesystem::temp_directory_path() / (std::string{"hypercraft_test_"} + name)} {
+		remove();
+	}
+	inline ~TempDatabase() { remove(); }
+	inline std::string GetPath() const { return m_path.string(); }
+
+	inline std::unique_ptr<WorldDatabase> Open(bool compress) const {
+		auto database = WorldDatabase::Create(GetPath().c_str());
+		database->SetRecordCompression(compress);
+		return database;
+	}
+
+	// Raw records of a table, with no WorldDatabase open on the file
+	inline std::vector<uint8_t> ReadRaw(const char *db_name, ChunkPos3 chunk_pos) const {
+		std::vector<uint8_t> record;
+		raw_txn(db_name, MDB_RDONLY, [&](MDB_txn *txn, MDB_dbi dbi) {
+			MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos}, val{};
+			if (mdb_get(txn, dbi, &key, &val) == MDB_SUCCESS)
+				record.assign((const uint8_t *)val.mv_data, (const uint8_t *)val.mv_data + val.mv_size);
+		});
+		return record;
+	}
+	inline void WriteRaw(const char *db_name, ChunkPos3 chunk_pos, const void *data, std::size_t size) const {
+		raw_txn(db_name, 0, [&](MDB_txn *txn, MDB_dbi dbi) {
+			MDB_val key = {.mv_size = sizeof(ChunkPos3), .mv_data = &chunk_pos},
+			        val = {.mv_size = size, .mv_data = (void *)data};
+			REQUIRE(mdb_put(txn, dbi, &key, &val, 0) == MDB_SUCCESS);
+		});
+	}
+
+private:
+	template <typename Func> inline void raw_txn(const char *db_name, unsigned flags, Func &&func) const {
+		MDB_env *env{};
+		REQUIRE(mdb_env_create(&env) == MDB_SUCCESS);
+		mdb_env_set_maxdbs(env, 8);
+		REQUIRE(mdb_env_open(env, GetPath().c_str(), MDB_NOSUBDIR, 0664) == MDB_SUCCESS);
+		MDB_txn *txn{};
+		REQUIRE(mdb_txn_begin(env, nullptr, flags, &txn) == MDB_SUCCESS);
+		MDB_dbi dbi{};
+		REQUIRE(mdb_dbi_open(txn, db_name, 0, &dbi) == MDB_SUCCESS);
+		func(txn, dbi);
+		if (flags & MDB_RDONLY)
+			mdb_txn_abort(txn);
+		else
+			REQUIRE(mdb_txn_commit(txn) == MDB_SUCCESS);
+		mdb_env_close(env);
+	}
+};
+
+// Entries on every other index with values cycling through a few blocks
+std::vector<ChunkSetBlockEntry> make_block_requests(std::size_t count) {
+	const Block kBlocks[] = {Blocks::kStone, Blocks::kSand, Blocks::kGravel};
+	std::vector<ChunkSetBlockEntry> requests(count);
+	for (std::size_t i = 0; i < count; ++i)
+		requests[i] = {.index = InnerIndex3(2 * i), .old_block = Blocks::kAir, .new_block = kBlocks[i / 5 % 3]};
+	return requests;
+}
+// Entries on consecutive columns with heights changing every few columns
+std::vector<ChunkSetSunlightEntry> make_sunlight_requests(std::size_t count) {
+	std::vector<ChunkSetSunlightEntry> requests(count);
+	for (std::size_t i = 0; i < count; ++i)
+		requests[i] = {.index = InnerIndex2(i), .old_sunlight = 0, .new_sunlight = InnerPos1(i / 3 % kChunkSize)};
+	return requests;
+}
+
+void check_blocks(const std::vector<PackedChunkBlockEntry> &entries, std::span<const ChunkSetBlockEntry> requests) {
+	REQUIRE(entries.size() == requests.size());
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		CHECK(entries[i].GetIndex() == requests[i].index);
+		CHECK(entries[i].GetBlock() == requests[i].new_block);
+	}
+}
+void check_sunlights(std::vector<PackedChunkSunlightEntry> entries, std::vector<ChunkSetSunlightEntry> requests) {
+	std::sort(requests.begin(), requests.end(), [](const auto &l, const auto &r) { return l.index < r.index; });
+	REQUIRE(entries.size() == requests.size());
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		CHECK(entries[i].GetIndex() == requests[i].index);
+		CHECK(entries[i].GetSunlight() == requests[i].new_sunlight);
+	}
+}
+
+} // namespace
+
+TEST_CASE("Legacy records are read sorted and rewritten with a format byte") {
+	TempDatabase temp{"legacy"};
+	temp.Open(false);
+
+	const PackedChunkBlockEntry legacy_blocks[] = {{7, Blocks::kStone}, {3, Blocks::kSand}, {5, Blocks::kGravel}};
+	const PackedChunkSunlightEntry legacy_sunlights[] = {{9, 4}, {1, 2}};
+	temp.WriteRaw("block", kChunkPos, legacy_blocks, sizeof(legacy_blocks));
+	temp.WriteRaw("sunlight", kChunkPos, legacy_sunlights, sizeof(legacy_sunlights));
+
+	{
+		auto database = temp.Open(false);
+		auto chunk = database->GetChunks({&kChunkPos, 1}).front();
+		const ChunkSetBlockEntry expected_blocks[] = {{3, Blocks::kAir, Blocks::kSand},
+		                                              {5, Blocks::kAir, Blocks::kGravel},
+		                                              {7, Blocks::kAir, Blocks::kStone}};
+		check_blocks(chunk.blocks, expected_blocks);
+		check_sunlights(chunk.sunlights, {{1, 0, 2}, {9, 0, 4}});
+
+		const ChunkSetBlockEntry set_block{4, Blocks::kAir, Blocks::kStone};
+		database->SetBlocks(kChunkPos, {&set_block, 1});
+		const ChunkSetSunlightEntry set_sunlight{5, 0, 7};
+		database->SetSunlights(kChunkPos, {&set_sunlight, 1});
+	}
+
+	auto block_record = temp.ReadRaw("block", kChunkPos);
+	REQUIRE(block_record.size() == 1 + 4 * sizeof(PackedChunkBlockEntry));
+	CHECK(block_record[0] == kSparse);
+	auto sunlight_record = temp.ReadRaw("sunlight", kChunkPos);
+	REQUIRE(sunlight_record.size() == 1 + 3 * sizeof(PackedChunkSunlightEntry));
+	CHECK(sunlight_record[0] == kSparse);
+
+	auto chunk = temp.Open(false)->GetChunks({&kChunkPos, 1}).front();
+	const ChunkSetBlockEntry expected_blocks[] = {{3, Blocks::kAir, Blocks::kSand},
+	                                              {4, Blocks::kAir, Blocks::kStone},
+	                                              {5, Blocks::kAir, Blocks::kGravel},
+	                                              {7, Blocks::kAir, Blocks::kStone}};
+	check_blocks(chunk.blocks, expected_blocks);
+	check_sunlights(chunk.sunlights, {{1, 0, 2}, {5, 0, 7}, {9, 0, 4}});
+}
+
+TEST_CASE("Block records turn dense past 2048 entries") {
+	for (std::size_t count : {std::size_t{2048}, std::size_t{2049}}) {
+		CAPTURE(count);
+		TempDatabase temp{"dense_blocks"};
+		auto requests = make_block_requests(count);
+		temp.Open(false)->SetBlocks(kChunkPos, requests);
+
+		auto record = temp.ReadRaw("block", kChunkPos);
+		REQUIRE(!record.empty());
+		if (count <= 2048) {
+			CHECK(record[0] == kSparse);
+			CHECK(record.size() == 1 + count * sizeof(PackedChunkBlockEntry));
+		} else {
+			CHECK(record[0] == kDense);
+			CHECK(record.size() == 1 + kChunkSize * kChunkSize * kChunkSize / 8 + count * sizeof(uint16_t));
+		}
+		check_blocks(temp.Open(false)->GetChunks({&kChunkPos, 1}).front().blocks, requests);
+	}
+}
+
+TEST_CASE("Sunlight records turn dense past 512 entries") {
+	for (std::size_t count : {std::size_t{512}, std::size_t{513}}) {
+		CAPTURE(count);
+		TempDatabase temp{"dense_sunlights"};
+		auto requests = make_sunlight_requests(count);
+		temp.Open(false)->SetSunlights(kChunkPos, requests);
+
+		auto record = temp.ReadRaw("sunlight", kChunkPos);
+		REQUIRE(!record.empty());
+		if (count <= 512) {
+			CHECK(record[0] == kSparse);
+			CHECK(record.size() == 1 + count * sizeof(PackedChunkSunlightEntry));
+		} else {
+			CHECK(record[0] == kDense);
+			CHECK(record.size() == 1 + kChunkSize * kChunkSize);
+		}
+		check_sunlights(temp.Open(false)->GetChunks({&kChunkPos, 1}).front().sunlights, requests);
+	}
+}
+
+TEST_CASE("Duplicate indices are merged") {
+	TempDatabase temp{"duplicates"};
+	auto database = temp.Open(false);
+
+	// The last request of an index wins
+	const ChunkSetBlockEntry first[] = {{10, Blocks::kAir, Blocks::kStone},
+	                                    {2, Blocks::kAir, Blocks::kSand},
+	                                    {10, Blocks::kAir, Blocks::kGravel}};
+	auto resolved = database->SetBlocks(kChunkPos, first);
+	const ChunkSetBlockEntry expected_first[] = {{2, Blocks::kAir, Blocks::kSand}, {10, Blocks::kAir, Blocks::kGravel}};
+	check_blocks(resolved, expected_first);
+
+	// An existing entry is only replaced if it equals the old block of the request
+	const ChunkSetBlockEntry second[] = {{10, Blocks::kStone, Blocks::kSand}, {2, Blocks::kSand, Blocks::kStone}};
+	resolved = database->SetBlocks(kChunkPos, second);
+	const ChunkSetBlockEntry expected_second[] = {{2, Blocks::kAir, Blocks::kStone},
+	                                              {10, Blocks::kAir, Blocks::kGravel}};
+	check_blocks(resolved, expected_second);
+	check_blocks(database->GetChunks({&kChunkPos, 1}).front().blocks, expected_second);
+
+	const ChunkSetSunlightEntry sunlights[] = {{3, 0, 5}, {3, 0, 6}, {3, 6, 7}};
+	check_sunlights(database->SetSunlights(kChunkPos, sunlights), {{3, 0, 7}});
+}
+
+TEST_CASE("Compressed records round-trip") {
+	// A large palette, then long runs of indices and values
+	std::vector<ChunkSetBlockEntry> palette_requests(2400);
+	for (std::size_t i = 0; i < palette_requests.size(); ++i) {
+		Block block;
+		block.SetData(uint16_t(i / 8 * 211 + 1));
+		palette_requests[i] = {.index = InnerIndex3(i + i / 600), .old_block = Blocks::kAir, .new_block = block};
+	}
+	std::vector<ChunkSetBlockEntry> run_requests(4096);
+	for (std::size_t i = 0; i < run_requests.size(); ++i)
+		run_requests[i] = {.index = InnerIndex3(i < 2048 ? i : i + 10000),
+		                   .old_block = Blocks::kAir,
+		                   .new_block = i < 3000 ? Blocks::kStone : Blocks::kSand};
+
+	for (const auto *p_requests : {&palette_requests, &run_requests}) {
+		CAPTURE(p_requests->size());
+		TempDatabase temp{"compressed_blocks"};
+		temp.Open(true)->SetBlocks(kChunkPos, *p_requests);
+
+		auto record = temp.ReadRaw("block", kChunkPos);
+		REQUIRE(!record.empty());
+		CHECK(record[0] == kCompressed);
+		CHECK(record.size() % 2 == 1);
+		CHECK(record.size() < 1 + p_requests->size() * sizeof(PackedChunkBlockEntry));
+		check_blocks(temp.Open(true)->GetChunks({&kChunkPos, 1}).front().blocks, *p_requests);
+	}
+
+	TempDatabase temp{"compressed_sunlights"};
+	auto sunlight_requests = make_sunlight_requests(700);
+	temp.Open(true)->SetSunlights(kChunkPos, sunlight_requests);
+	auto record = temp.ReadRaw("sunlight", kChunkPos);
+	REQUIRE(!record.empty());
+	CHECK(record[0] == kCompressed);
+	CHECK(record.size() % 2 == 1);
+	check_sunlights(temp.Open(true)->GetChunks({&kChunkPos, 1}).front().sunlights, sunlight_requests);
+}
+
+TEST_CASE("Legacy and uncompressed records are rewritten compressed") {
+	TempDatabase temp{"compressed_legacy"};
+	temp.Open(true);
+	const PackedChunkBlockEntry legacy_blocks[] = {{7, Blocks::kStone}, {3, Blocks::kStone}, {5, Blocks::kStone}};
+	temp.WriteRaw("block", kChunkPos, legacy_blocks, sizeof(legacy_blocks));
+	const ChunkPos3 dense_pos{0, 0, 0};
+	auto dense_requests = make_block_requests(3000);
+	temp.Open(false)->SetBlocks(dense_pos, dense_requests);
+	REQUIRE(temp.ReadRaw("block", dense_pos)[0] == kDense);
+
+	{
+		auto database = temp.Open(true);
+		const ChunkSetBlockEntry set_block{4, Blocks::kAir, Blocks::kStone};
+		database->SetBlocks(kChunkPos, {&set_block, 1});
+		const ChunkSetBlockEntry set_dense_block{1, Blocks::kAir, Blocks::kSand};
+		database->SetBlocks(dense_pos, {&set_dense_block, 1});
+	}
+	CHECK(temp.ReadRaw("block", kChunkPos)[0] == kCompressed);
+	CHECK(temp.ReadRaw("block", dense_pos)[0] == kCompressed);
+
+	auto database = temp.Open(true);
+	const ChunkSetBlockEntry expected_blocks[] = {{3, Blocks::kAir, Blocks::kStone},
+	                                              {4, Blocks::kAir, Blocks::kStone},
+	                                              {5, Blocks::kAir, Blocks::kStone},
+	                                              {7, Blocks::kAir, Blocks::kStone}};
+	check_blocks(database->GetChunks({&kChunkPos, 1}).front().blocks, expected_blocks);
+	dense_requests.insert(dense_requests.begin() + 1, {1, Blocks::kAir, Blocks::kSand});
+	check_blocks(database->GetChunks({&dense_pos, 1}).front().blocks, dense_requests);
+}
+
+TEST_CASE("Truncated and corrupt compressed records decode to bounded entries") {
+	TempDatabase temp{"compressed_corrupt"};
+	auto block_requests = make_block_requests(200);
+	auto sunlight_requests = make_sunlight_requests(200);
+	temp.Open(true)->SetBlocks(kChunkPos, block_requests);
+	temp.Open(true)->SetSunlights(kChunkPos, sunlight_requests);
+	auto block_record = temp.ReadRaw("block", kChunkPos), sunlight_record = temp.ReadRaw("sunlight", kChunkPos);
+	REQUIRE(block_record[0] == kCompressed);
+	REQUIRE(sunlight_record[0] == kCompressed);
+
+	// Every prefix of the records, each at its own chunk
+	std::vector<ChunkPos3> positions;
+	for (std::size_t size = 1; size < std::max(block_record.size(), sunlight_record.size()); ++size) {
+		ChunkPos3 pos{ChunkPos1(size), 0, 0};
+		positions.push_back(pos);
+		temp.WriteRaw("block", pos, block_record.data(), std::min(size, block_record.size()));
+		temp.WriteRaw("sunlight", pos, sunlight_record.data(), std::min(size, sunlight_record.size()));
+	}
+	// A count far beyond the data, and a palette index out of the palette (read as air)
+	const uint8_t huge_count[] = {kCompressed, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x00, 0x7f, 0x00};
+	const uint8_t bad_palette[] = {kCompressed, 2, 0, 1, 1, 5, 7, 1, 0};
+	const ChunkPos3 huge_count_pos{0, 1, 0}, bad_palette_pos{0, 2, 0};
+	temp.WriteRaw("block", huge_count_pos, huge_count, sizeof(huge_count));
+	temp.WriteRaw("sunlight", huge_count_pos, huge_count, sizeof(huge_count));
+	temp.WriteRaw("block", bad_palette_pos, bad_palette, sizeof(bad_palette));
+
+	auto database = temp.Open(true);
+	auto chunks = database->GetChunks(positions);
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		CAPTURE(i);
+		CHECK(chunks[i].blocks.size() <= block_requests.size());
+		for (auto entry : chunks[i].blocks)
+			CHECK(entry.GetIndex() < kChunkSize * kChunkSize * kChunkSize);
+		CHECK(chunks[i].sunlights.size() <= sunlight_requests.size());
+		for (auto entry : chunks[i].sunlights)
+			CHECK(entry.GetIndex() < kChunkSize * kChunkSize);
+	}
+
+	auto huge_count_chunk = database->GetChunks({&huge_count_pos, 1}).front();
+	CHECK(huge_count_chunk.blocks.empty());
+	CHECK(huge_count_chunk.sunlights.size() <= 128);
+	auto bad_palette_chunk = database->GetChunks({&bad_palette_pos, 1}).front();
+	const ChunkSetBlockEntry expected_bad_palette[] = {{0, Blocks::kAir, Blocks::kAir},
+	                                                   {1, Blocks::kAir, Blocks::kAir}};
+	check_blocks(bad_palette_chunk.blocks, expected_bad_palette);
+}
+
+TEST_CASE("A full map drops the baked chunks before the edits") {
+	TempDatabase temp{"map_full"};
+	auto database = WorldDatabase::Create(temp.GetPath().c_str(), 256 * 1024);
+	database->SetRecordCompression(false);
+
+	// Edits kept while the baked chunk does not fit
+	ChunkWriteRequests requests{.chunk_pos = kChunkPos,
+	                            .blocks = {make_block_requests(16)},
+	                            .baked_version = 1,
+	                            .baked = std::vector<uint8_t>(512 * 1024, 7)};
+	auto results = database->Write({&requests, 1});
+	check_blocks(results.front().blocks.front(), requests.blocks.front());
+	auto chunk = database->GetChunks({&kChunkPos, 1}, 1).front();
+	check_blocks(chunk.blocks, requests.blocks.front());
+	CHECK(chunk.baked.empty());
+
+	// Edits that do not fit resolve to nothing
+	auto dense_requests = make_block_requests(16000);
+	bool full = false;
+	for (ChunkPos1 x = 0; x < 64 && !full; ++x) {
+		ChunkPos3 chunk_pos{x, 5, 0};
+		auto resolved = database->SetBlocks(chunk_pos, dense_requests);
+		if (resolved.empty()) {
+			full = true;
+			CHECK(database->GetChunks({&chunk_pos, 1}).front().blocks.empty());
+		} else
+			check_blocks(resolved, dense_requests);
+	}
+	CHECK(full);
+	check_blocks(database->GetChunks({&kChunkPos, 1}).front().blocks, requests.blocks.front());
+}